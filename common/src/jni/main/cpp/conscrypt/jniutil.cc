@@ -31,7 +31,6 @@ jclass nativeRefClass;
 jclass nativeRefHpkeCtxClass;
 
 jclass byteArrayClass;
-jclass calendarClass;
 jclass objectClass;
 jclass objectArrayClass;
 jclass integerClass;
@@ -46,11 +45,10 @@ static jclass sslHandshakeCallbacksClass;
 jfieldID nativeRef_address;
 static jfieldID fileDescriptor_fd;
 
-jmethodID calendar_setMethod;
-jmethodID inputStream_readMethod;
+jmethodID inputStream_readRangeMethod;
 jmethodID integer_valueOfMethod;
 jmethodID openSslInputStream_readLineMethod;
-jmethodID outputStream_writeMethod;
+jmethodID outputStream_writeRangeMethod;
 jmethodID outputStream_flushMethod;
 jmethodID buffer_positionMethod;
 jmethodID buffer_limitMethod;
@@ -73,7 +71,6 @@ void init(JavaVM* vm, JNIEnv* env) {
     gJavaVM = vm;
 
     byteArrayClass = findClass(env, "[B");
-    calendarClass = findClass(env, "java/util/Calendar");
     inputStreamClass = findClass(env, "java/io/InputStream");
     integerClass = findClass(env, "java/lang/Integer");
     objectClass = findClass(env, "java/lang/Object");
@@ -105,18 +102,17 @@ void init(JavaVM* vm, JNIEnv* env) {
     fileDescriptor_fd = getFieldRef(env, fileDescriptorClass, "fd", "I");
 #endif
 
-    calendar_setMethod = getMethodRef(env, calendarClass, "set", "(IIIIII)V");
-    inputStream_readMethod = getMethodRef(env, inputStreamClass, "read", "([B)I");
+    inputStream_readRangeMethod = getMethodRef(env, inputStreamClass, "read", "([BII)I");
     integer_valueOfMethod =
             env->GetStaticMethodID(integerClass, "valueOf", "(I)Ljava/lang/Integer;");
     openSslInputStream_readLineMethod = getMethodRef(env, openSslInputStreamClass, "gets", "([B)I");
-    outputStream_writeMethod = getMethodRef(env, outputStreamClass, "write", "([B)V");
+    outputStream_writeRangeMethod = getMethodRef(env, outputStreamClass, "write", "([BII)V");
     outputStream_flushMethod = getMethodRef(env, outputStreamClass, "flush", "()V");
     buffer_positionMethod = getMethodRef(env, bufferClass, "position", "()I");
     buffer_limitMethod = getMethodRef(env, bufferClass, "limit", "()I");
     buffer_isDirectMethod = getMethodRef(env, bufferClass, "isDirect", "()Z");
     sslHandshakeCallbacks_verifyCertificateChain = getMethodRef(
-            env, sslHandshakeCallbacksClass, "verifyCertificateChain", "([[BLjava/lang/String;)V");
+            env, sslHandshakeCallbacksClass, "verifyCertificateChain", "([JLjava/lang/String;)V");
     sslHandshakeCallbacks_onSSLStateChange =
             getMethodRef(env, sslHandshakeCallbacksClass, "onSSLStateChange", "(II)V");
     sslHandshakeCallbacks_clientCertificateRequested = getMethodRef(
@@ -19,15 +19,22 @@
 #include <conscrypt/bio_input_stream.h>
 #include <conscrypt/bio_output_stream.h>
 #include <conscrypt/bio_stream.h>
+#include <conscrypt/cert_compression.h>
 #include <conscrypt/compat.h>
 #include <conscrypt/compatibility_close_monitor.h>
+#include <conscrypt/connection_stats.h>
+#include <conscrypt/engine_bio.h>
+#include <conscrypt/handshake_timer.h>
 #include <conscrypt/jniutil.h>
 #include <conscrypt/logging.h>
 #include <conscrypt/macros.h>
+#include <conscrypt/memory_stats.h>
 #include <conscrypt/native_crypto.h>
 #include <conscrypt/netutil.h>
+#include <conscrypt/revocation_index.h>
 #include <conscrypt/scoped_ssl_bio.h>
 #include <conscrypt/ssl_error.h>
+#include <conscrypt/verify_cache.h>
 #include <limits.h>
 #include <nativehelper/scoped_primitive_array.h>
 #include <nativehelper/scoped_utf_chars.h>
@@ -41,6 +48,7 @@
 #include <openssl/engine.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <openssl/hkdf.h>
 #include <openssl/hmac.h>
 #include <openssl/hpke.h>
 #include <openssl/mldsa.h>
@@ -56,16 +64,45 @@
 
 #include <limits>
 #include <optional>
+#include <string>
 #include <type_traits>
 #include <vector>
 
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#define CONSCRYPT_KTLS 1
+// off_t is 32 bits on 32-bit Android, where sendfile64 only exists from API 21.
+#if defined(__ANDROID__) && __ANDROID_API__ < 21
+typedef off_t ktls_off_t;
+#define ktls_sendfile sendfile
+#else
+typedef off64_t ktls_off_t;
+#define ktls_sendfile sendfile64
+#endif
+#endif
+#endif
+
 using conscrypt::AppData;
 using conscrypt::BioInputStream;
 using conscrypt::BioOutputStream;
 using conscrypt::BioStream;
 using conscrypt::CompatibilityCloseMonitor;
+using conscrypt::ConnectionStats;
+using conscrypt::HandshakeTimer;
 using conscrypt::NativeCrypto;
+using conscrypt::RevocationIndex;
 using conscrypt::SslError;
+using conscrypt::VerifyCache;
 
 /**
  * Helper function that grabs the casts an ssl pointer and then checks for
@@ -370,8 +407,29 @@ jbyteArray CryptoBufferToByteArray(JNIEnv* env, const CRYPTO_BUFFER* buf) {
     return ret;
 }
 
+/**
+ * Returns the pool that certificates and CA names are interned in, so that
+ * every connection to or from the same peers shares one copy of their bytes.
+ * It is shared by all SSL_CTXs and never freed.
+ */
+static CRYPTO_BUFFER_POOL* certificatePool() {
+    static CRYPTO_BUFFER_POOL* pool = CRYPTO_BUFFER_POOL_new();
+    return pool;
+}
+
+/**
+ * Counts buffers looked up in certificatePool() in the memory statistics,
+ * whether or not the pool already held a copy.
+ */
+static void countPoolLookups(size_t count, size_t bytes) {
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kPoolLookups,
+                                 static_cast<int64_t>(count));
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kPoolLookupBytes,
+                                 static_cast<int64_t>(bytes));
+}
+
 bssl::UniquePtr<CRYPTO_BUFFER> ByteArrayToCryptoBuffer(JNIEnv* env, const jbyteArray array,
-                                                       CONSCRYPT_UNUSED CRYPTO_BUFFER_POOL* pool) {
+                                                       CRYPTO_BUFFER_POOL* pool) {
     if (array == nullptr) {
         JNI_TRACE("array was null");
         conscrypt::jniutil::throwNullPointerException(env, "array == null");
@@ -385,12 +443,15 @@ bssl::UniquePtr<CRYPTO_BUFFER> ByteArrayToCryptoBuffer(JNIEnv* env, const jbyteA
     }
 
     bssl::UniquePtr<CRYPTO_BUFFER> ret(CRYPTO_BUFFER_new(
-            reinterpret_cast<const uint8_t*>(arrayRo.get()), arrayRo.size(), nullptr));
+            reinterpret_cast<const uint8_t*>(arrayRo.get()), arrayRo.size(), pool));
     if (!ret) {
         JNI_TRACE("failed to allocate CRYPTO_BUFFER");
         conscrypt::jniutil::throwOutOfMemory(env, "failed to allocate CRYPTO_BUFFER");
         return nullptr;
     }
+    if (pool != nullptr) {
+        countPoolLookups(1, arrayRo.size());
+    }
 
     return ret;
 }
@@ -424,6 +485,36 @@ static jobjectArray CryptoBuffersToObjectArray(JNIEnv* env,
     return array.release();
 }
 
+/**
+ * Returns handles to the CRYPTO_BUFFERs of buffers, each holding a reference
+ * that Java releases with CRYPTO_BUFFER_free, so that Java can look at the
+ * certificates without copying them.
+ */
+static jlongArray CryptoBuffersToHandleArray(JNIEnv* env,
+                                             const STACK_OF(CRYPTO_BUFFER)* buffers) {
+    size_t numBuffers = sk_CRYPTO_BUFFER_num(buffers);
+    if (numBuffers > INT_MAX) {
+        JNI_TRACE("too many buffers");
+        conscrypt::jniutil::throwRuntimeException(env, "too many buffers");
+        return nullptr;
+    }
+
+    ScopedLocalRef<jlongArray> array(env, env->NewLongArray(static_cast<int>(numBuffers)));
+    if (array.get() == nullptr) {
+        JNI_TRACE("failed to allocate array");
+        return nullptr;
+    }
+
+    std::vector<jlong> handles(numBuffers);
+    for (size_t i = 0; i < numBuffers; ++i) {
+        CRYPTO_BUFFER* buffer = sk_CRYPTO_BUFFER_value(buffers, i);
+        CRYPTO_BUFFER_up_ref(buffer);
+        handles[i] = reinterpret_cast<uintptr_t>(buffer);
+    }
+    env->SetLongArrayRegion(array.get(), 0, static_cast<int>(numBuffers), handles.data());
+    return array.release();
+}
+
 /**
  * Converts ASN.1 BIT STRING to a jbooleanArray.
  */
@@ -503,6 +594,17 @@ static long bio_stream_ctrl(BIO* b, int cmd, long, void*) {
     }
 }
 
+/**
+ * Hands whatever a call wrote to bio to the Java stream behind it, as stream
+ * BIOs hold on to small writes. Throws if the stream did not take them.
+ */
+static void flush_written_bio(JNIEnv* env, BIO* bio) {
+    if (BIO_flush(bio) <= 0 && !env->ExceptionCheck()) {
+        ERR_clear_error();
+        conscrypt::jniutil::throwIOException(env, "BIO_flush");
+    }
+}
+
 static const BIO_METHOD* stream_bio_method() {
     static const BIO_METHOD* stream_method = []() -> const BIO_METHOD* {
         BIO_METHOD* method = BIO_meth_new(0, nullptr);
@@ -682,6 +784,7 @@ int RsaMethodSignRaw(RSA* rsa, size_t* out_len, uint8_t* out, size_t max_out, co
 
     // For RSA keys, this function behaves as RSA_private_encrypt with
     // the specified padding.
+    HandshakeTimer::Phase phase(HandshakeTimer::current(), HandshakeTimer::kPrivateKey);
     ScopedLocalRef<jbyteArray> signature(
             env, rsaSignDigestWithPrivateKey(env, ex_data->private_key, padding,
                                              reinterpret_cast<const char*>(in), in_len));
@@ -730,6 +833,7 @@ int RsaMethodDecrypt(RSA* rsa, size_t* out_len, uint8_t* out, size_t max_out, co
     }
 
     // This function behaves as RSA_private_decrypt.
+    HandshakeTimer::Phase phase(HandshakeTimer::current(), HandshakeTimer::kPrivateKey);
     ScopedLocalRef<jbyteArray> cleartext(
             env, rsaDecryptWithPrivateKey(env, ex_data->private_key, padding,
                                           reinterpret_cast<const char*>(in), in_len));
@@ -777,6 +881,7 @@ int EcdsaMethodSign(const uint8_t* digest, size_t digest_len, uint8_t* sig, unsi
     }
 
     // Sign message with it through JNI.
+    HandshakeTimer::Phase phase(HandshakeTimer::current(), HandshakeTimer::kPrivateKey);
     ScopedLocalRef<jbyteArray> signature(
             env, ecSignDigestWithPrivateKey(env, private_key, reinterpret_cast<const char*>(digest),
                                             digest_len));
@@ -5755,6 +5860,31 @@ static jstring X509_NAME_to_jstring(JNIEnv* env, X509_NAME* name, unsigned long
     return env->NewStringUTF(tmp);
 }
 
+/**
+ * Formats an iPAddress GENERAL_NAME as text, the way getSubjectAlternativeNames
+ * reports it. Returns false for encodings that are neither IPv4 nor IPv6.
+ */
+static bool ip_address_to_string(const ASN1_OCTET_STRING* ip, char (&out)[INET6_ADDRSTRLEN]) {
+#ifdef _WIN32
+    void* data = const_cast<void*>(reinterpret_cast<const void*>(ASN1_STRING_get0_data(ip)));
+#else
+    const void* data = reinterpret_cast<const void*>(ASN1_STRING_get0_data(ip));
+#endif
+    int family;
+    if (ASN1_STRING_length(ip) == 4) {
+        family = AF_INET;
+    } else if (ASN1_STRING_length(ip) == 16) {
+        family = AF_INET6;
+    } else {
+        return false;
+    }
+    if (inet_ntop(family, data, out, INET6_ADDRSTRLEN) == nullptr) {
+        JNI_TRACE("ip_address_to_string(%p) => failed %s", ip, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
 /**
  * Converts GENERAL_NAME items to the output format expected in
  * X509Certificate#getSubjectAlternativeNames and
@@ -5788,31 +5918,10 @@ static jobject GENERAL_NAME_to_jobject(JNIEnv* env, GENERAL_NAME* gen) {
             /* Write in RFC 2253 format */
             return X509_NAME_to_jstring(env, gen->d.directoryName, XN_FLAG_RFC2253);
         case GEN_IPADD: {
-#ifdef _WIN32
-            void* ip = reinterpret_cast<void*>(gen->d.ip->data);
-#else
-            const void* ip = reinterpret_cast<const void*>(gen->d.ip->data);
-#endif
-            if (gen->d.ip->length == 4) {
-                // IPv4
-                std::unique_ptr<char[]> buffer(new char[INET_ADDRSTRLEN]);
-                if (inet_ntop(AF_INET, ip, buffer.get(), INET_ADDRSTRLEN) != nullptr) {
-                    JNI_TRACE("GENERAL_NAME_to_jobject(%p) => IPv4 %s", gen, buffer.get());
-                    return env->NewStringUTF(buffer.get());
-                } else {
-                    JNI_TRACE("GENERAL_NAME_to_jobject(%p) => IPv4 failed %s", gen,
-                              strerror(errno));
-                }
-            } else if (gen->d.ip->length == 16) {
-                // IPv6
-                std::unique_ptr<char[]> buffer(new char[INET6_ADDRSTRLEN]);
-                if (inet_ntop(AF_INET6, ip, buffer.get(), INET6_ADDRSTRLEN) != nullptr) {
-                    JNI_TRACE("GENERAL_NAME_to_jobject(%p) => IPv6 %s", gen, buffer.get());
-                    return env->NewStringUTF(buffer.get());
-                } else {
-                    JNI_TRACE("GENERAL_NAME_to_jobject(%p) => IPv6 failed %s", gen,
-                              strerror(errno));
-                }
+            char buffer[INET6_ADDRSTRLEN];
+            if (ip_address_to_string(gen->d.ip, buffer)) {
+                JNI_TRACE("GENERAL_NAME_to_jobject(%p) => IP %s", gen, buffer);
+                return env->NewStringUTF(buffer);
             }
 
             /* Invalid IP encodings are pruned out without throwing an exception. */
@@ -5938,6 +6047,142 @@ static jobjectArray NativeCrypto_get_X509_GENERAL_NAME_stack(JNIEnv* env, jclass
     return joa.release();
 }
 
+#define HOST_MATCH_IP_ADDRESS 1
+#define HOST_MATCH_STRICT_WILDCARDS 2
+
+static bool ends_with(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * Returns whether the lower case hostName matches the DNS name pattern from a
+ * certificate. This follows OkHostnameVerifier#verifyHostName(String, String),
+ * which documents the wildcard rules.
+ */
+static bool host_name_matches(std::string hostName, std::string pattern, bool strictWildcards) {
+    if (hostName.empty() || hostName[0] == '.' || ends_with(hostName, "..")) {
+        return false;
+    }
+    if (pattern.empty() || pattern[0] == '.' || ends_with(pattern, "..")) {
+        return false;
+    }
+
+    // Both are treated as absolute domain names.
+    if (hostName.back() != '.') {
+        hostName += '.';
+    }
+    if (pattern.back() != '.') {
+        pattern += '.';
+    }
+    for (char& c : pattern) {
+        c = static_cast<char>(OPENSSL_tolower(c));
+    }
+
+    if (pattern.find('*') == std::string::npos) {
+        return hostName == pattern;
+    }
+    if (pattern.compare(0, 2, "*.") != 0 || pattern.find('*', 1) != std::string::npos) {
+        return false;
+    }
+    if (hostName.size() < pattern.size() || pattern == "*.") {
+        return false;
+    }
+    // In strict mode the pattern may not match top-level domains, e.g. *.com.
+    if (strictWildcards && pattern.find('.', 2) == pattern.size() - 1) {
+        return false;
+    }
+
+    std::string suffix = pattern.substr(1);
+    if (!ends_with(hostName, suffix)) {
+        return false;
+    }
+    // The asterisk may not match across labels.
+    size_t suffixStart = hostName.size() - suffix.size();
+    return suffixStart == 0 || hostName.rfind('.', suffixStart - 1) == std::string::npos;
+}
+
+/**
+ * Returns whether a subjectAltName of x509 matches host. With
+ * HOST_MATCH_IP_ADDRESS, host is compared case-insensitively with the iPAddress
+ * names as getSubjectAlternativeNames formats them. Otherwise host must be in
+ * lower case and is matched against the dNSName names, skipping those that
+ * getSubjectAlternativeNames would drop.
+ */
+static bool x509_matches_host(X509* x509, const std::string& host, int flags) {
+    bssl::UniquePtr<STACK_OF(GENERAL_NAME)> names(static_cast<STACK_OF(GENERAL_NAME)*>(
+            X509_get_ext_d2i(x509, NID_subject_alt_name, nullptr, nullptr)));
+    if (names == nullptr) {
+        ERR_clear_error();
+        return false;
+    }
+
+    for (size_t i = 0; i < sk_GENERAL_NAME_num(names.get()); i++) {
+        const GENERAL_NAME* gen = sk_GENERAL_NAME_value(names.get(), i);
+        if (flags & HOST_MATCH_IP_ADDRESS) {
+            char buffer[INET6_ADDRSTRLEN];
+            if (gen->type == GEN_IPADD && ip_address_to_string(gen->d.ip, buffer) &&
+                OPENSSL_strcasecmp(host.c_str(), buffer) == 0) {
+                return true;
+            }
+            continue;
+        }
+
+        if (gen->type != GEN_DNS) {
+            continue;
+        }
+        const uint8_t* data = ASN1_STRING_get0_data(gen->d.dNSName);
+        size_t len = static_cast<size_t>(ASN1_STRING_length(gen->d.dNSName));
+        bool valid = true;
+        for (size_t j = 0; j < len && valid; j++) {
+            valid = data[j] != 0 && data[j] <= 127;
+        }
+        if (valid && host_name_matches(host, std::string(reinterpret_cast<const char*>(data), len),
+                                       (flags & HOST_MATCH_STRICT_WILDCARDS) != 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static jboolean NativeCrypto_X509_matches_host(JNIEnv* env, jclass, jlong x509Ref,
+                                               CONSCRYPT_UNUSED jobject holder, jstring hostJava,
+                                               jint flags) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    X509* x509 = reinterpret_cast<X509*>(static_cast<uintptr_t>(x509Ref));
+    JNI_TRACE("X509_matches_host(%p, %p, %d)", x509, hostJava, flags);
+
+    if (x509 == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "x509 == null");
+        JNI_TRACE("X509_matches_host(%p) => x509 == null", x509);
+        return JNI_FALSE;
+    }
+
+    ScopedUtfChars host(env, hostJava);
+    if (host.c_str() == nullptr) {
+        JNI_TRACE("X509_matches_host(%p) => host == null", x509);
+        return JNI_FALSE;
+    }
+
+    bool matches = x509_matches_host(x509, std::string(host.c_str(), host.size()), flags);
+    JNI_TRACE("X509_matches_host(%p, %s, %d) => %d", x509, host.c_str(), flags, matches);
+    return matches ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Converts asn1Time to milliseconds since the epoch. Returns false if it is
+ * not a valid time.
+ */
+static bool asn1_time_to_millis(const ASN1_TIME* asn1Time, int64_t* out) {
+    int64_t seconds;
+    if (!ASN1_TIME_to_posix(asn1Time, &seconds)) {
+        ERR_clear_error();
+        return false;
+    }
+    *out = seconds * 1000;
+    return true;
+}
+
 static jlong NativeCrypto_X509_get_notBefore(JNIEnv* env, jclass, jlong x509Ref,
                                              CONSCRYPT_UNUSED jobject holder) {
     CHECK_ERROR_QUEUE_ON_RETURN;
@@ -5991,6 +6236,82 @@ static long NativeCrypto_X509_get_version(JNIEnv* env, jclass, jlong x509Ref,
     return version;
 }
 
+static const uint32_t kX509FieldsVersion = 3;
+
+/**
+ * Returns the scalar fields of a certificate that OpenSSLX509Certificate reads
+ * most often, so that one call replaces several. Byte string fields are left to
+ * their own getters, which copy them out of the encodings BoringSSL keeps from
+ * parsing rather than re-encoding the whole certificate. The layout, all
+ * integers big-endian, is:
+ *
+ *   u32 layout version (kX509FieldsVersion)
+ *   u32 X.509 version, zero-based
+ *   u64 notBefore, milliseconds since the epoch
+ *   u64 notAfter, milliseconds since the epoch
+ *   u32 extension flags, as in get_X509_ex_flags
+ *   u32 length of the signature algorithm OID, then the OID in dotted form
+ *
+ * Throws ParsingException if the validity period cannot be parsed, which
+ * OpenSSLX509Certificate reports from its constructor.
+ */
+static jbyteArray NativeCrypto_get_X509_fields(JNIEnv* env, jclass, jlong x509Ref,
+                                               CONSCRYPT_UNUSED jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    X509* x509 = reinterpret_cast<X509*>(static_cast<uintptr_t>(x509Ref));
+    JNI_TRACE("get_X509_fields(%p)", x509);
+
+    if (x509 == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "x509 == null");
+        JNI_TRACE("get_X509_fields(%p) => x509 == null", x509);
+        return nullptr;
+    }
+
+    int64_t notBefore, notAfter;
+    if (!asn1_time_to_millis(X509_get0_notBefore(x509), &notBefore) ||
+        !asn1_time_to_millis(X509_get0_notAfter(x509), &notAfter)) {
+        conscrypt::jniutil::throwParsingException(env, "Invalid date format");
+        JNI_TRACE("get_X509_fields(%p) => invalid validity", x509);
+        return nullptr;
+    }
+
+    // See NativeCrypto_get_X509_ex_flags.
+    uint32_t flags = X509_get_extension_flags(x509);
+    ERR_clear_error();
+
+    // See ASN1_OBJECT_to_OID_string.
+    const X509_ALGOR* sigAlg;
+    X509_get0_signature(nullptr, &sigAlg, x509);
+    const ASN1_OBJECT* sigAlgOid;
+    X509_ALGOR_get0(&sigAlgOid, nullptr, nullptr, sigAlg);
+    char sigAlgOidText[128];
+    int sigAlgOidLen = OBJ_obj2txt(sigAlgOidText, sizeof(sigAlgOidText), sigAlgOid, 1);
+    if (sigAlgOidLen < 0 || static_cast<size_t>(sigAlgOidLen) >= sizeof(sigAlgOidText)) {
+        conscrypt::jniutil::throwParsingException(env, "Invalid signature algorithm");
+        JNI_TRACE("get_X509_fields(%p) => invalid signature algorithm", x509);
+        return nullptr;
+    }
+
+    bssl::ScopedCBB cbb;
+    bool ok = CBB_init(cbb.get(), 32 + sizeof(sigAlgOidText)) &&
+              CBB_add_u32(cbb.get(), kX509FieldsVersion) &&
+              CBB_add_u32(cbb.get(), static_cast<uint32_t>(X509_get_version(x509))) &&
+              CBB_add_u64(cbb.get(), static_cast<uint64_t>(notBefore)) &&
+              CBB_add_u64(cbb.get(), static_cast<uint64_t>(notAfter)) &&
+              CBB_add_u32(cbb.get(), flags) &&
+              CBB_add_u32(cbb.get(), static_cast<uint32_t>(sigAlgOidLen)) &&
+              CBB_add_bytes(cbb.get(), reinterpret_cast<const uint8_t*>(sigAlgOidText),
+                            static_cast<size_t>(sigAlgOidLen));
+    if (!ok) {
+        conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate X.509 fields");
+        JNI_TRACE("get_X509_fields(%p) => CBB failed", x509);
+        return nullptr;
+    }
+
+    JNI_TRACE("get_X509_fields(%p) => %zu bytes", x509, CBB_len(cbb.get()));
+    return CBBToByteArray(env, cbb.get());
+}
+
 template <typename T>
 static jbyteArray get_X509Type_serialNumber(JNIEnv* env, const T* x509Type,
                                             const ASN1_INTEGER* (*get_serial_func)(const T*)) {
@@ -6354,6 +6675,130 @@ static jlongArray NativeCrypto_X509_CRL_get_REVOKED(JNIEnv* env, jclass, jlong x
     return revokedArray.release();
 }
 
+/**
+ * Returns the revocation date of each of the given X509_REVOKED handles, in
+ * milliseconds since the epoch, or Long.MIN_VALUE for a date that cannot be
+ * parsed. Reading them from the handles rather than from the CRL keeps the two
+ * in step even if the CRL's list is sorted in between.
+ */
+static jlongArray NativeCrypto_X509_REVOKED_get_revocationDates(JNIEnv* env, jclass,
+                                                                jlongArray revokedRefs) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("X509_REVOKED_get_revocationDates(%p)", revokedRefs);
+
+    if (revokedRefs == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "revokedRefs == null");
+        JNI_TRACE("X509_REVOKED_get_revocationDates(%p) => revokedRefs == null", revokedRefs);
+        return nullptr;
+    }
+
+    ScopedLongArrayRO refs(env, revokedRefs);
+    if (refs.get() == nullptr) {
+        JNI_TRACE("X509_REVOKED_get_revocationDates(%p) => failed to get refs", revokedRefs);
+        return nullptr;
+    }
+    size_t size = refs.size();
+    ScopedLocalRef<jlongArray> datesArray(env, env->NewLongArray(static_cast<jsize>(size)));
+    if (datesArray.get() == nullptr) {
+        JNI_TRACE("X509_REVOKED_get_revocationDates(%p) => allocating result failed",
+                  revokedRefs);
+        return nullptr;
+    }
+    ScopedLongArrayRW dates(env, datesArray.get());
+    for (size_t i = 0; i < size; i++) {
+        const X509_REVOKED* item =
+                reinterpret_cast<const X509_REVOKED*>(static_cast<uintptr_t>(refs[i]));
+        if (item == nullptr) {
+            conscrypt::jniutil::throwNullPointerException(env, "revoked == null");
+            JNI_TRACE("X509_REVOKED_get_revocationDates(%p) => revoked == null", revokedRefs);
+            return nullptr;
+        }
+        int64_t millis;
+        if (!asn1_time_to_millis(X509_REVOKED_get0_revocationDate(item), &millis)) {
+            millis = std::numeric_limits<int64_t>::min();
+        }
+        dates[i] = static_cast<jlong>(millis);
+    }
+
+    JNI_TRACE("X509_REVOKED_get_revocationDates(%p) => %p [size=%zd]", revokedRefs,
+              datesArray.get(), size);
+    return datesArray.release();
+}
+
+static jlong NativeCrypto_X509_CRL_revocation_index_new(JNIEnv* env, jclass, jlong x509CrlRef,
+                                                       CONSCRYPT_UNUSED jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    X509_CRL* crl = reinterpret_cast<X509_CRL*>(static_cast<uintptr_t>(x509CrlRef));
+    JNI_TRACE("X509_CRL_revocation_index_new(%p)", crl);
+
+    if (crl == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "crl == null");
+        JNI_TRACE("X509_CRL_revocation_index_new(%p) => crl == null", crl);
+        return 0;
+    }
+
+    RevocationIndex* index = new RevocationIndex(crl);
+    JNI_TRACE("X509_CRL_revocation_index_new(%p) => %p [size=%zd]", crl, index, index->size());
+    return reinterpret_cast<uintptr_t>(index);
+}
+
+static void NativeCrypto_X509_CRL_revocation_index_free(CONSCRYPT_UNUSED JNIEnv* env, jclass,
+                                                        jlong indexRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    RevocationIndex* index = reinterpret_cast<RevocationIndex*>(static_cast<uintptr_t>(indexRef));
+    JNI_TRACE("X509_CRL_revocation_index_free(%p)", index);
+    delete index;
+}
+
+static jbooleanArray NativeCrypto_X509_CRL_revocation_index_lookup(JNIEnv* env, jclass,
+                                                                   jobject indexRef,
+                                                                   jbyteArray serials,
+                                                                   jintArray spans) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    const RevocationIndex* index = fromContextObject<RevocationIndex>(env, indexRef);
+    JNI_TRACE("X509_CRL_revocation_index_lookup(%p, %p, %p)", index, serials, spans);
+
+    if (index == nullptr) {
+        return nullptr;
+    }
+    ScopedByteArrayRO bytes(env, serials);
+    if (bytes.get() == nullptr) {
+        JNI_TRACE("X509_CRL_revocation_index_lookup(%p) => using byte array failed", index);
+        return nullptr;
+    }
+    ScopedIntArrayRO spansRo(env, spans);
+    if (spansRo.get() == nullptr) {
+        JNI_TRACE("X509_CRL_revocation_index_lookup(%p) => using spans array failed", index);
+        return nullptr;
+    }
+
+    jsize count = static_cast<jsize>(spansRo.size() / 2);
+    ScopedLocalRef<jbooleanArray> resultRef(env, env->NewBooleanArray(count));
+    if (resultRef.get() == nullptr) {
+        JNI_TRACE("X509_CRL_revocation_index_lookup(%p) => allocating result failed", index);
+        return nullptr;
+    }
+    ScopedBooleanArrayRW result(env, resultRef.get());
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(bytes.get());
+    for (jsize i = 0; i < count; i++) {
+        jint offset = spansRo[2 * i];
+        jint length = spansRo[2 * i + 1];
+        if (offset < 0 || length < 0 || static_cast<size_t>(offset) > bytes.size() ||
+            static_cast<size_t>(length) > bytes.size() - static_cast<size_t>(offset)) {
+            conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                               "span out of bounds");
+            JNI_TRACE("X509_CRL_revocation_index_lookup(%p) => span %d out of bounds", index, i);
+            return nullptr;
+        }
+        result[i] = static_cast<jboolean>(
+                index->contains(data + offset, static_cast<size_t>(length)));
+    }
+
+    JNI_TRACE("X509_CRL_revocation_index_lookup(%p) => %p [count=%d]", index, resultRef.get(),
+              count);
+    return resultRef.release();
+}
+
 static jbyteArray NativeCrypto_i2d_X509_CRL(JNIEnv* env, jclass, jlong x509CrlRef,
                                             CONSCRYPT_UNUSED jobject holder) {
     CHECK_ERROR_QUEUE_ON_RETURN;
@@ -6407,6 +6852,7 @@ static void NativeCrypto_X509_CRL_print(JNIEnv* env, jclass, jlong bioRef, jlong
         JNI_TRACE("X509_CRL_print(%p, %p) => threw error", bio, crl);
         return;
     }
+    flush_written_bio(env, bio);
     JNI_TRACE("X509_CRL_print(%p, %p) => success", bio, crl);
 }
 
@@ -6658,6 +7104,7 @@ static void NativeCrypto_X509_REVOKED_print(JNIEnv* env, jclass, jlong bioRef, j
     // simpler toString() implementation.
     X509V3_extensions_print(bio, "CRL entry extensions", X509_REVOKED_get0_extensions(revoked), 0,
                             0);
+    flush_written_bio(env, bio);
 }
 #ifndef _WIN32
 #pragma GCC diagnostic pop
@@ -6758,58 +7205,25 @@ static jint NativeCrypto_X509_supported_extension(JNIEnv* env, jclass, jlong x50
     return X509_supported_extension(ext);
 }
 
-static inline bool decimal_to_integer(const char* data, size_t len, int* out) {
-    int ret = 0;
-    for (size_t i = 0; i < len; i++) {
-        ret *= 10;
-        if (data[i] < '0' || data[i] > '9') {
-            return false;
-        }
-        ret += data[i] - '0';
-    }
-    *out = ret;
-    return true;
-}
-
-static void NativeCrypto_ASN1_TIME_to_Calendar(JNIEnv* env, jclass, jlong asn1TimeRef,
-                                               jobject calendar) {
+static jlong NativeCrypto_ASN1_TIME_to_millis(JNIEnv* env, jclass, jlong asn1TimeRef) {
     CHECK_ERROR_QUEUE_ON_RETURN;
     ASN1_TIME* asn1Time = reinterpret_cast<ASN1_TIME*>(static_cast<uintptr_t>(asn1TimeRef));
-    JNI_TRACE("ASN1_TIME_to_Calendar(%p, %p)", asn1Time, calendar);
+    JNI_TRACE("ASN1_TIME_to_millis(%p)", asn1Time);
 
     if (asn1Time == nullptr) {
         conscrypt::jniutil::throwNullPointerException(env, "asn1Time == null");
-        return;
-    }
-
-    if (!ASN1_TIME_check(asn1Time)) {
-        conscrypt::jniutil::throwParsingException(env, "Invalid date format");
-        return;
-    }
-
-    bssl::UniquePtr<ASN1_GENERALIZEDTIME> gen(ASN1_TIME_to_generalizedtime(asn1Time, nullptr));
-    if (gen.get() == nullptr) {
-        conscrypt::jniutil::throwParsingException(env,
-                                                  "ASN1_TIME_to_generalizedtime returned null");
-        return;
-    }
-
-    if (ASN1_STRING_length(gen.get()) < 14 || ASN1_STRING_get0_data(gen.get()) == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "gen->length < 14 || gen->data == null");
-        return;
+        return 0;
     }
 
-    int year, mon, mday, hour, min, sec;
-    const char* data = reinterpret_cast<const char*>(ASN1_STRING_get0_data(gen.get()));
-    if (!decimal_to_integer(data, 4, &year) || !decimal_to_integer(data + 4, 2, &mon) ||
-        !decimal_to_integer(data + 6, 2, &mday) || !decimal_to_integer(data + 8, 2, &hour) ||
-        !decimal_to_integer(data + 10, 2, &min) || !decimal_to_integer(data + 12, 2, &sec)) {
+    int64_t millis;
+    if (!asn1_time_to_millis(asn1Time, &millis)) {
         conscrypt::jniutil::throwParsingException(env, "Invalid date format");
-        return;
+        JNI_TRACE("ASN1_TIME_to_millis(%p) => invalid date", asn1Time);
+        return 0;
     }
-
-    env->CallVoidMethod(calendar, conscrypt::jniutil::calendar_setMethod, year, mon - 1, mday, hour,
-                        min, sec);
+    // NOLINTNEXTLINE(runtime/int)
+    JNI_TRACE("ASN1_TIME_to_millis(%p) => %lld", asn1Time, static_cast<long long>(millis));
+    return static_cast<jlong>(millis);
 }
 
 // A CbsHandle is a structure used to manage resources allocated by asn1_read-*
@@ -7203,33 +7617,141 @@ static jlong NativeCrypto_d2i_X509(JNIEnv* env, jclass, jbyteArray certBytes) {
     return reinterpret_cast<uintptr_t>(x);
 }
 
-static jbyteArray NativeCrypto_i2d_X509(JNIEnv* env, jclass, jlong x509Ref,
-                                        CONSCRYPT_UNUSED jobject holder) {
+/**
+ * Parses count certificates packed into one array, where spans holds the
+ * offset and length of each. Returns their X509 handles, with 0 for each
+ * entry that could not be parsed; if errors is not null, the BoringSSL error
+ * code for such entries is stored at the same index, and 0 for the others.
+ */
+static jlongArray NativeCrypto_d2i_X509_batch(JNIEnv* env, jclass, jbyteArray data,
+                                              jintArray spans, jintArray errors) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    X509* x509 = reinterpret_cast<X509*>(static_cast<uintptr_t>(x509Ref));
-    JNI_TRACE("i2d_X509(%p)", x509);
+    JNI_TRACE("d2i_X509_batch(%p, %p, %p)", data, spans, errors);
 
-    if (x509 == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "x509 == null");
-        JNI_TRACE("i2d_X509(%p) => x509 == null", x509);
+    if (spans == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "spans == null");
+        return nullptr;
+    }
+    jsize count = env->GetArrayLength(spans) / 2;
+    if (errors != nullptr && env->GetArrayLength(errors) < count) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "errors.length < spans.length / 2");
         return nullptr;
     }
-    return ASN1ToByteArray<X509>(env, x509, i2d_X509);
-}
-
-static jbyteArray NativeCrypto_i2d_X509_PUBKEY(JNIEnv* env, jclass, jlong x509Ref,
-                                               CONSCRYPT_UNUSED jobject holder) {
-    CHECK_ERROR_QUEUE_ON_RETURN;
-    X509* x509 = reinterpret_cast<X509*>(static_cast<uintptr_t>(x509Ref));
-    JNI_TRACE("i2d_X509_PUBKEY(%p)", x509);
 
-    if (x509 == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "x509 == null");
-        JNI_TRACE("i2d_X509_PUBKEY(%p) => x509 == null", x509);
+    ScopedByteArrayRO bytes(env, data);
+    if (bytes.get() == nullptr) {
+        JNI_TRACE("d2i_X509_batch(%p) => using byte array failed", data);
+        return nullptr;
+    }
+    ScopedIntArrayRO spansRo(env, spans);
+    if (spansRo.get() == nullptr) {
+        JNI_TRACE("d2i_X509_batch(%p) => using spans array failed", data);
         return nullptr;
     }
-    return ASN1ToByteArray<X509_PUBKEY>(env, X509_get_X509_PUBKEY(x509), i2d_X509_PUBKEY);
-}
+
+    std::vector<jlong> handles(static_cast<size_t>(count));
+    std::vector<jint> codes(static_cast<size_t>(count));
+    for (jsize i = 0; i < count; i++) {
+        jint offset = spansRo.get()[2 * i];
+        jint length = spansRo.get()[2 * i + 1];
+        if (offset < 0 || length < 0 || static_cast<size_t>(offset) > bytes.size() ||
+            static_cast<size_t>(length) > bytes.size() - static_cast<size_t>(offset)) {
+            for (jsize j = 0; j < i; j++) {
+                X509_free(reinterpret_cast<X509*>(static_cast<uintptr_t>(handles[j])));
+            }
+            conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                               "span out of bounds");
+            JNI_TRACE("d2i_X509_batch(%p) => span %d out of bounds", data, i);
+            return nullptr;
+        }
+
+        const unsigned char* tmp = reinterpret_cast<const unsigned char*>(bytes.get()) + offset;
+        // NOLINTNEXTLINE(runtime/int)
+        X509* x = d2i_X509(nullptr, &tmp, static_cast<long>(length));
+        if (x == nullptr) {
+            codes[i] = static_cast<jint>(ERR_get_error());
+            ERR_clear_error();
+        }
+        handles[i] = reinterpret_cast<uintptr_t>(x);
+    }
+
+    ScopedLocalRef<jlongArray> result(env, env->NewLongArray(count));
+    if (result.get() == nullptr) {
+        for (jlong handle : handles) {
+            X509_free(reinterpret_cast<X509*>(static_cast<uintptr_t>(handle)));
+        }
+        JNI_TRACE("d2i_X509_batch(%p) => allocating result failed", data);
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result.get(), 0, count, handles.data());
+    if (errors != nullptr) {
+        env->SetIntArrayRegion(errors, 0, count, codes.data());
+    }
+    JNI_TRACE("d2i_X509_batch(%p) => %d certificates", data, count);
+    return result.release();
+}
+
+/**
+ * Parses the certificate in a CRYPTO_BUFFER handle. The X509 keeps a
+ * reference to the buffer instead of copying the DER.
+ */
+static jlong NativeCrypto_X509_parse_from_buffer(JNIEnv* env, jclass, jlong bufferRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    CRYPTO_BUFFER* buffer = reinterpret_cast<CRYPTO_BUFFER*>(static_cast<uintptr_t>(bufferRef));
+    JNI_TRACE("X509_parse_from_buffer(%p)", buffer);
+    if (buffer == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "buffer == null");
+        return 0;
+    }
+    X509* x = X509_parse_from_buffer(buffer);
+    if (x == nullptr) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(
+                env, "Error reading X.509 data", conscrypt::jniutil::throwParsingException);
+        return 0;
+    }
+    JNI_TRACE("X509_parse_from_buffer(%p) => %p", buffer, x);
+    return reinterpret_cast<uintptr_t>(x);
+}
+
+static void NativeCrypto_CRYPTO_BUFFER_free(JNIEnv* env, jclass, jlong bufferRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    CRYPTO_BUFFER* buffer = reinterpret_cast<CRYPTO_BUFFER*>(static_cast<uintptr_t>(bufferRef));
+    JNI_TRACE("CRYPTO_BUFFER_free(%p)", buffer);
+    if (buffer == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "buffer == null");
+        return;
+    }
+    CRYPTO_BUFFER_free(buffer);
+}
+
+static jbyteArray NativeCrypto_i2d_X509(JNIEnv* env, jclass, jlong x509Ref,
+                                        CONSCRYPT_UNUSED jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    X509* x509 = reinterpret_cast<X509*>(static_cast<uintptr_t>(x509Ref));
+    JNI_TRACE("i2d_X509(%p)", x509);
+
+    if (x509 == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "x509 == null");
+        JNI_TRACE("i2d_X509(%p) => x509 == null", x509);
+        return nullptr;
+    }
+    return ASN1ToByteArray<X509>(env, x509, i2d_X509);
+}
+
+static jbyteArray NativeCrypto_i2d_X509_PUBKEY(JNIEnv* env, jclass, jlong x509Ref,
+                                               CONSCRYPT_UNUSED jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    X509* x509 = reinterpret_cast<X509*>(static_cast<uintptr_t>(x509Ref));
+    JNI_TRACE("i2d_X509_PUBKEY(%p)", x509);
+
+    if (x509 == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "x509 == null");
+        JNI_TRACE("i2d_X509_PUBKEY(%p) => x509 == null", x509);
+        return nullptr;
+    }
+    return ASN1ToByteArray<X509_PUBKEY>(env, X509_get_X509_PUBKEY(x509), i2d_X509_PUBKEY);
+}
 
 template <typename T, T* (*PEM_read_func)(BIO*, T**, pem_password_cb*, void*)>
 static jlong PEM_to_jlong(JNIEnv* env, jlong bioRef) {
@@ -7280,6 +7802,127 @@ static jlong NativeCrypto_PEM_read_bio_PrivateKey(JNIEnv* env, jclass, jlong bio
     return PEM_to_jlong<EVP_PKEY, PEM_read_bio_PrivateKey>(env, bioRef);
 }
 
+// Kinds of object returned by PEM_read_all. Keep in sync with NativeCrypto.java.
+#define PEM_X509 1
+#define PEM_X509_CRL 2
+#define PEM_PRIVATE_KEY 4
+#define PEM_PUBLIC_KEY 8
+
+static int pemKindOf(const char* name) {
+    if (strcmp(name, PEM_STRING_X509) == 0 || strcmp(name, PEM_STRING_X509_OLD) == 0) {
+        return PEM_X509;
+    }
+    if (strcmp(name, PEM_STRING_X509_CRL) == 0) {
+        return PEM_X509_CRL;
+    }
+    if (strcmp(name, PEM_STRING_PKCS8INF) == 0 || strcmp(name, PEM_STRING_RSA) == 0 ||
+        strcmp(name, PEM_STRING_ECPRIVATEKEY) == 0) {
+        return PEM_PRIVATE_KEY;
+    }
+    if (strcmp(name, PEM_STRING_PUBLIC) == 0) {
+        return PEM_PUBLIC_KEY;
+    }
+    return 0;
+}
+
+static void pemFree(int kind, uintptr_t handle) {
+    switch (kind) {
+        case PEM_X509:
+            X509_free(reinterpret_cast<X509*>(handle));
+            break;
+        case PEM_X509_CRL:
+            X509_CRL_free(reinterpret_cast<X509_CRL*>(handle));
+            break;
+        default:
+            EVP_PKEY_free(reinterpret_cast<EVP_PKEY*>(handle));
+            break;
+    }
+}
+
+/**
+ * Decodes the DER body of a PEM block of the given kind, returning 0 if it is
+ * malformed.
+ */
+static uintptr_t pemDecode(int kind, const uint8_t* der, long len) {  // NOLINT(runtime/int)
+    const uint8_t* p = der;
+    switch (kind) {
+        case PEM_X509:
+            return reinterpret_cast<uintptr_t>(d2i_X509(nullptr, &p, len));
+        case PEM_X509_CRL:
+            return reinterpret_cast<uintptr_t>(d2i_X509_CRL(nullptr, &p, len));
+        case PEM_PRIVATE_KEY:
+            return reinterpret_cast<uintptr_t>(d2i_AutoPrivateKey(nullptr, &p, len));
+        case PEM_PUBLIC_KEY:
+            return reinterpret_cast<uintptr_t>(d2i_PUBKEY(nullptr, &p, len));
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Decodes every PEM block in pem whose kind is in the which mask, in a single
+ * pass over an in-memory BIO rather than a line-by-line stream. Returns
+ * (kind, handle) pairs in the order the blocks appear. Blocks of other kinds,
+ * including encrypted keys, are skipped. Decoding stops at the first block
+ * of a requested kind that is malformed, returning what came before it.
+ */
+static jlongArray NativeCrypto_PEM_read_all(JNIEnv* env, jclass, jbyteArray pem, jint which) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("PEM_read_all(%p, %d)", pem, which);
+
+    ScopedByteArrayRO bytes(env, pem);
+    if (bytes.get() == nullptr) {
+        JNI_TRACE("PEM_read_all(%p) => using byte array failed", pem);
+        return nullptr;
+    }
+    bssl::UniquePtr<BIO> bio(
+            BIO_new_mem_buf(bytes.get(), static_cast<ossl_ssize_t>(bytes.size())));
+    if (!bio) {
+        conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate BIO");
+        return nullptr;
+    }
+
+    std::vector<jlong> items;
+    for (;;) {
+        char* name = nullptr;
+        char* header = nullptr;
+        uint8_t* data = nullptr;
+        long len;  // NOLINT(runtime/int)
+        if (!PEM_read_bio(bio.get(), &name, &header, &data, &len)) {
+            // Either the end of the input or a block that is not valid PEM.
+            ERR_clear_error();
+            break;
+        }
+        bssl::UniquePtr<char> freeName(name);
+        bssl::UniquePtr<char> freeHeader(header);
+        bssl::UniquePtr<uint8_t> freeData(data);
+
+        int kind = pemKindOf(name);
+        if ((kind & which) == 0 || (header != nullptr && header[0] != '\0')) {
+            continue;
+        }
+        uintptr_t handle = pemDecode(kind, data, len);
+        if (handle == 0) {
+            ERR_clear_error();
+            JNI_TRACE("PEM_read_all(%p) => malformed %s", pem, name);
+            break;
+        }
+        items.push_back(kind);
+        items.push_back(static_cast<jlong>(handle));
+    }
+
+    ScopedLocalRef<jlongArray> result(env, env->NewLongArray(static_cast<jsize>(items.size())));
+    if (result.get() == nullptr) {
+        for (size_t i = 0; i < items.size(); i += 2) {
+            pemFree(static_cast<int>(items[i]), static_cast<uintptr_t>(items[i + 1]));
+        }
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result.get(), 0, static_cast<jsize>(items.size()), items.data());
+    JNI_TRACE("PEM_read_all(%p) => %zu objects", pem, items.size() / 2);
+    return result.release();
+}
+
 static jlongArray X509s_to_ItemArray(JNIEnv* env, STACK_OF(X509)* certs) {
     if (certs == nullptr) {
         return nullptr;
@@ -7599,6 +8242,7 @@ static void NativeCrypto_X509_print_ex(JNIEnv* env, jclass, jlong bioRef, jlong
         JNI_TRACE("X509_print_ex(%p, %p, %ld, %ld) => threw error", bio, x509, nmflag, certflag);
         return;
     }
+    flush_written_bio(env, bio);
     JNI_TRACE("X509_print_ex(%p, %p, %ld, %ld) => success", bio, x509, nmflag, certflag);
 }
 
@@ -8081,6 +8725,7 @@ static void info_callback_LOG(const SSL* s, int where, int ret) {
  */
 static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
                      int timeout_millis) {
+    ConnectionStats::Wait wait(&appData->stats);
     int result = -1;
 
     NetFd fd(env, fdObject);
@@ -8159,11 +8804,21 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
  */
 static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
                      int timeout_millis) {
+    ConnectionStats::Wait wait(&appData->stats);
     // This loop is an expanded version of the NET_FAILURE_RETRY
     // macro. It cannot simply be used in this case because poll
     // cannot be restarted without recreating the pollfd structure.
     int result;
     struct pollfd fds[2];
+    int wakeupFd;
+    {
+        std::lock_guard<std::mutex> appDataLock(appData->mutex);
+        if (!appData->ensureWakeupFd()) {
+            appData->waitingThreads--;
+            return -1;
+        }
+        wakeupFd = appData->wakeupFd;
+    }
     do {
         NetFd fd(env, fdObject);
         if (fd.isClosed()) {
@@ -8182,7 +8837,7 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
             fds[0].events = POLLOUT | POLLPRI;
         }
 
-        fds[1].fd = appData->fdsEmergency[0];
+        fds[1].fd = wakeupFd;
         fds[1].events = POLLIN | POLLPRI;
 
         // Converting from Java semantics to Posix semantics.
@@ -8210,18 +8865,18 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
     std::lock_guard<std::mutex> appDataLock(appData->mutex);
 
     if (result > 0) {
-        // We have been woken up by a token in the emergency pipe. We
-        // can't be sure the token is still in the pipe at this point
-        // because it could have already been read by the thread that
-        // originally wrote it if it entered sslSelect and acquired
-        // the mutex before we did. Thus we cannot safely read from
-        // the pipe in a blocking way (so we make the pipe
-        // non-blocking at creation).
-        if (fds[1].revents & POLLIN) {
-            char token;
-            do {
-                CONSCRYPT_UNUSED int n = read(appData->fdsEmergency[0], &token, 1);
-            } while (errno == EINTR);
+        // We have been woken up by the wakeup descriptor. We can't be sure
+        // the signal is still there at this point because it could have
+        // already been consumed by the thread that originally sent it if it
+        // entered sslSelect and acquired the mutex before we did, so the
+        // descriptor is non-blocking. Once the connection is being torn down
+        // the signal is left in place so that every waiting thread sees it.
+        if ((fds[1].revents & POLLIN) && appData->aliveAndKicking) {
+            appData->consumeWakeup();
+            if (!appData->aliveAndKicking) {
+                // Raced with SSL_interrupt and may have consumed its signal.
+                appData->signalWakeupFd();
+            }
         }
     }
 
@@ -8241,18 +8896,15 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
  * @param data The application data structure with mutex info etc.
  */
 static void sslNotify(AppData* appData) {
+    appData->stats.add(ConnectionStats::kNotifyWakeups);
 #ifdef _WIN32
     SetEvent(appData->interruptEvent);
 #else
-    // Write a byte to the emergency pipe, so a concurrent select() can return.
+    // Signal the wakeup descriptor, so a concurrent select() can return.
     // Note we have to restore the errno of the original system call, since the
     // caller relies on it for generating error messages.
     int errnoBackup = errno;
-    char token = '*';
-    do {
-        errno = 0;
-        CONSCRYPT_UNUSED int n = write(appData->fdsEmergency[1], &token, 1);
-    } while (errno == EINTR);
+    appData->notifyWakeup();
     errno = errnoBackup;
 #endif
 }
@@ -8261,10 +8913,99 @@ static AppData* toAppData(const SSL* ssl) {
     return reinterpret_cast<AppData*>(SSL_get_app_data(ssl));
 }
 
-static ssl_verify_result_t cert_verify_callback(SSL* ssl, CONSCRYPT_UNUSED uint8_t* out_alert) {
+/**
+ * Handles cert_verify_callback when the Java layer verifies the peer chain
+ * asynchronously. The first invocation only marks the verification as pending
+ * so that the handshake returns SSL_ERROR_WANT_CERTIFICATE_VERIFY; BoringSSL
+ * calls back again once the handshake is resumed, at which point the result
+ * posted by NativeCrypto_SSL_set_cert_verify_result is consumed.
+ */
+static ssl_verify_result_t async_cert_verify_result(SSL* ssl, AppData* appData,
+                                                    uint8_t* out_alert) {
+    int state = AppData::ASYNC_NONE;
+    HandshakeTimer* timer = appData->handshakeTimer.get();
+    if (appData->certVerifyState.compare_exchange_strong(state, AppData::ASYNC_PENDING)) {
+        if (timer != nullptr) {
+            timer->beginAsync();
+        }
+        JNI_TRACE("ssl=%p cert_verify_callback => retry (verification requested)", ssl);
+        return ssl_verify_retry;
+    }
+    if (timer != nullptr && state != AppData::ASYNC_PENDING) {
+        timer->endAsync(HandshakeTimer::kCertVerification);
+    }
+    switch (state) {
+        case AppData::ASYNC_PENDING:
+            JNI_TRACE("ssl=%p cert_verify_callback => retry (verification pending)", ssl);
+            return ssl_verify_retry;
+        case AppData::ASYNC_OK:
+            appData->certVerifyState = AppData::ASYNC_NONE;
+            JNI_TRACE("ssl=%p cert_verify_callback => ok", ssl);
+            return ssl_verify_ok;
+        default:
+            appData->certVerifyState = AppData::ASYNC_NONE;
+            *out_alert = SSL_AD_CERTIFICATE_UNKNOWN;
+            JNI_TRACE("ssl=%p cert_verify_callback => invalid", ssl);
+            return ssl_verify_invalid;
+    }
+}
+
+/**
+ * Returns the authentication method the peer's chain is verified for, as
+ * passed to verifyCertificateChain, or nullptr if there is no pending cipher.
+ */
+static const char* pending_auth_method(const SSL* ssl) {
+    const SSL_CIPHER* cipher = SSL_get_pending_cipher(ssl);
+    return cipher == nullptr ? nullptr : SSL_CIPHER_get_kx_name(cipher);
+}
+
+/**
+ * Returns the cache that verifications of the peer chain of ssl may be looked
+ * up in and added to, setting *key to the chain's key, or nullptr if there is
+ * none.
+ */
+static VerifyCache* verify_cache_for(SSL* ssl, AppData* appData, std::string* key) {
+    if (!appData->verifyCacheEnabled) {
+        return nullptr;
+    }
+    VerifyCache* cache = VerifyCache::get(SSL_get_SSL_CTX(ssl));
+    if (cache == nullptr || !cache->enabled()) {
+        return nullptr;
+    }
+    *key = VerifyCache::keyOf(ssl, pending_auth_method(ssl), appData->verifyCacheScope);
+    return cache;
+}
+
+static void verify_cache_insert(SSL* ssl, AppData* appData) {
+    std::string key;
+    VerifyCache* cache = verify_cache_for(ssl, appData, &key);
+    if (cache != nullptr) {
+        cache->insert(key, SSL_get0_peer_certificates(ssl));
+    }
+}
+
+static ssl_verify_result_t cert_verify_callback(SSL* ssl, uint8_t* out_alert) {
     JNI_TRACE("ssl=%p cert_verify_callback", ssl);
 
     AppData* appData = toAppData(ssl);
+    if (!appData->asyncCertVerification || appData->certVerifyState == AppData::ASYNC_NONE) {
+        // A chain verified recently needs no upcall. The session picks up
+        // the peer certificates once the handshake is done, as it does when
+        // a session is resumed.
+        std::string key;
+        VerifyCache* cache = verify_cache_for(ssl, appData, &key);
+        if (cache != nullptr && cache->lookup(key)) {
+            JNI_TRACE("ssl=%p cert_verify_callback => ok (cached)", ssl);
+            return ssl_verify_ok;
+        }
+    }
+    if (appData->asyncCertVerification) {
+        ssl_verify_result_t result = async_cert_verify_result(ssl, appData, out_alert);
+        if (result == ssl_verify_ok) {
+            verify_cache_insert(ssl, appData);
+        }
+        return result;
+    }
     JNIEnv* env = appData->env;
     if (env == nullptr) {
         CONSCRYPT_LOG_ERROR("AppData->env missing in cert_verify_callback");
@@ -8272,9 +9013,9 @@ static ssl_verify_result_t cert_verify_callback(SSL* ssl, CONSCRYPT_UNUSED uint8
         return ssl_verify_invalid;
     }
 
-    // Create the byte[][] array that holds all the certs
-    ScopedLocalRef<jobjectArray> array(
-            env, CryptoBuffersToObjectArray(env, SSL_get0_peer_certificates(ssl)));
+    // Hand the certs to Java by reference; it decodes them from the buffers.
+    ScopedLocalRef<jlongArray> array(
+            env, CryptoBuffersToHandleArray(env, SSL_get0_peer_certificates(ssl)));
     if (array.get() == nullptr) {
         return ssl_verify_invalid;
     }
@@ -8282,17 +9023,20 @@ static ssl_verify_result_t cert_verify_callback(SSL* ssl, CONSCRYPT_UNUSED uint8
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
     jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_verifyCertificateChain;
 
-    const SSL_CIPHER* cipher = SSL_get_pending_cipher(ssl);
-    const char* authMethod = SSL_CIPHER_get_kx_name(cipher);
+    const char* authMethod = pending_auth_method(ssl);
 
     JNI_TRACE(
             "ssl=%p cert_verify_callback calling verifyCertificateChain "
             "authMethod=%s",
             ssl, authMethod);
+    HandshakeTimer::Phase phase(appData->handshakeTimer.get(), HandshakeTimer::kCertVerification);
     ScopedLocalRef<jstring> authMethodString(env, env->NewStringUTF(authMethod));
     env->CallVoidMethod(sslHandshakeCallbacks, methodID, array.get(), authMethodString.get());
 
     ssl_verify_result_t result = env->ExceptionCheck() ? ssl_verify_invalid : ssl_verify_ok;
+    if (result == ssl_verify_ok) {
+        verify_cache_insert(ssl, appData);
+    }
     JNI_TRACE("ssl=%p cert_verify_callback => %d", ssl, result);
     return result;
 }
@@ -8313,6 +9057,48 @@ static void info_callback(const SSL* ssl, int type, int value) {
     }
 
     AppData* appData = toAppData(ssl);
+    if (type & SSL_CB_HANDSHAKE_START) {
+        appData->stats.add(ConnectionStats::kHandshakes);
+    }
+    HandshakeTimer* timer = appData->handshakeTimer.get();
+    if (timer != nullptr) {
+        if (type & SSL_CB_HANDSHAKE_START) {
+            timer->start(SSL_is_server(ssl));
+        } else {
+            timer->finish(SSL_session_reused(ssl));
+        }
+    }
+    if (type & SSL_CB_HANDSHAKE_DONE) {
+        // The handshake state, and with it the selected credential, is gone
+        // once SSL_do_handshake returns.
+        SSL_CREDENTIAL* selected =
+                const_cast<SSL_CREDENTIAL*>(SSL_get0_selected_credential(ssl));
+        if (selected != nullptr) {
+            SSL_CREDENTIAL_up_ref(selected);
+        }
+        appData->selectedCredential.reset(selected);
+        // BoringSSL looked the peer's chain up in certificatePool(), unless
+        // the session was resumed with the chain it already had.
+        const STACK_OF(CRYPTO_BUFFER)* peerCerts = SSL_get0_peer_certificates(ssl);
+        if (peerCerts != nullptr && !SSL_session_reused(ssl)) {
+            size_t numCerts = sk_CRYPTO_BUFFER_num(peerCerts);
+            size_t bytes = 0;
+            for (size_t i = 0; i < numCerts; i++) {
+                bytes += CRYPTO_BUFFER_len(sk_CRYPTO_BUFFER_value(peerCerts, i));
+            }
+            countPoolLookups(numCerts, bytes);
+        }
+    }
+    if ((type & SSL_CB_HANDSHAKE_DONE) && appData->shedHandshakeConfig &&
+        !appData->handshakeConfigShed) {
+        // BoringSSL drops its own handshake configuration once the handshake
+        // is done; drop ours along with it.
+        appData->shedHandshakeState();
+        if (appData->engineBio != nullptr) {
+            appData->engineBio->setReleaseBuffers(true);
+        }
+        appData->handshakeConfigShed = true;
+    }
     JNIEnv* env = appData->env;
     if (env == nullptr) {
         CONSCRYPT_LOG_ERROR("AppData->env missing in info_callback");
@@ -8336,6 +9122,18 @@ static void info_callback(const SSL* ssl, int type, int value) {
     JNI_TRACE("ssl=%p info_callback completed", ssl);
 }
 
+/**
+ * Call back for every record header and handshake message, used to count
+ * records and KeyUpdates in the connection's statistics.
+ */
+static void msg_callback(int is_write, CONSCRYPT_UNUSED int version, int content_type,
+                         const void* buf, size_t len, SSL* ssl, CONSCRYPT_UNUSED void* arg) {
+    AppData* appData = toAppData(ssl);
+    if (appData != nullptr) {
+        appData->stats.countMessage(is_write, content_type, buf, len);
+    }
+}
+
 /**
  * Call back to ask for a certificate. There are three possible exit codes:
  *
@@ -8367,6 +9165,7 @@ static int cert_cb(SSL* ssl, CONSCRYPT_UNUSED void* arg) {
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
 
     jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_clientCertificateRequested;
+    HandshakeTimer::Phase phase(appData->handshakeTimer.get(), HandshakeTimer::kCertSelection);
 
     // Call Java callback which can reconfigure the client certificate.
     const uint8_t* ctype = nullptr;
@@ -8428,6 +9227,34 @@ static enum ssl_select_cert_result_t select_certificate_cb(const SSL_CLIENT_HELL
     JNI_TRACE("ssl=%p select_certificate_cb_callback", ssl);
 
     AppData* appData = toAppData(ssl);
+    HandshakeTimer* timer = appData->handshakeTimer.get();
+    if (timer != nullptr) {
+        timer->markHello();
+    }
+    if (appData->asyncCertSelection) {
+        // BoringSSL calls back again once the handshake is resumed after a retry.
+        switch (appData->certSelectState.load()) {
+            case AppData::ASYNC_PENDING:
+                JNI_TRACE("ssl=%p select_certificate_cb => retry (selection pending)", ssl);
+                return ssl_select_cert_retry;
+            case AppData::ASYNC_OK:
+                appData->certSelectState = AppData::ASYNC_NONE;
+                if (timer != nullptr) {
+                    timer->endAsync(HandshakeTimer::kCertSelection);
+                }
+                JNI_TRACE("ssl=%p select_certificate_cb => success", ssl);
+                return ssl_select_cert_success;
+            case AppData::ASYNC_FAILED:
+                appData->certSelectState = AppData::ASYNC_NONE;
+                if (timer != nullptr) {
+                    timer->endAsync(HandshakeTimer::kCertSelection);
+                }
+                JNI_TRACE("ssl=%p select_certificate_cb => error", ssl);
+                return ssl_select_cert_error;
+            default:
+                break;
+        }
+    }
     JNIEnv* env = appData->env;
     if (env == nullptr) {
         CONSCRYPT_LOG_ERROR("AppData->env missing in select_certificate_cb");
@@ -8464,12 +9291,25 @@ static enum ssl_select_cert_result_t select_certificate_cb(const SSL_CLIENT_HELL
     }
 
     JNI_TRACE("ssl=%p select_certificate_cb calling serverCertificateRequested", ssl);
-    env->CallVoidMethod(sslHandshakeCallbacks, methodID, signatureAlgs);
+    {
+        HandshakeTimer::Phase phase(timer, HandshakeTimer::kCertSelection);
+        env->CallVoidMethod(sslHandshakeCallbacks, methodID, signatureAlgs);
+    }
 
     if (env->ExceptionCheck()) {
         JNI_TRACE("ssl=%p select_certificate_cb exception", ssl);
         return ssl_select_cert_error;
     }
+    if (appData->asyncCertSelection) {
+        // The Java layer completes the selection later and reports it with
+        // NativeCrypto_SSL_set_cert_selection_result.
+        appData->certSelectState = AppData::ASYNC_PENDING;
+        if (timer != nullptr) {
+            timer->beginAsync();
+        }
+        JNI_TRACE("ssl=%p select_certificate_cb => retry (selection requested)", ssl);
+        return ssl_select_cert_retry;
+    }
     JNI_TRACE("ssl=%p select_certificate_cb completed", ssl);
     return ssl_select_cert_success;
 }
@@ -8766,7 +9606,12 @@ static jlong NativeCrypto_SSL_CTX_new(JNIEnv* env, jclass) {
 
     SSL_CTX_set_mode(sslCtx.get(), mode);
 
+    // Intern the certificates and CA names received from peers, so that
+    // connections to the same peers share them.
+    SSL_CTX_set0_buffer_pool(sslCtx.get(), certificatePool());
+
     SSL_CTX_set_info_callback(sslCtx.get(), info_callback);
+    SSL_CTX_set_msg_callback(sslCtx.get(), msg_callback);
     SSL_CTX_set_cert_cb(sslCtx.get(), cert_cb, nullptr);
     SSL_CTX_set_select_certificate_cb(sslCtx.get(), select_certificate_cb);
     if (conscrypt::trace::kWithJniTraceKeys) {
@@ -8782,6 +9627,7 @@ static jlong NativeCrypto_SSL_CTX_new(JNIEnv* env, jclass) {
     SSL_CTX_sess_set_get_cb(sslCtx.get(), server_session_requested_callback);
 
     JNI_TRACE("NativeCrypto_SSL_CTX_new => %p", sslCtx.get());
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kSslCtx, 1);
     return (jlong)sslCtx.release();
 }
 
@@ -8797,6 +9643,7 @@ static void NativeCrypto_SSL_CTX_free(JNIEnv* env, jclass, jlong ssl_ctx_address
         return;
     }
     SSL_CTX_free(ssl_ctx);
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kSslCtx, -1);
 }
 
 static void NativeCrypto_SSL_CTX_set_session_id_context(JNIEnv* env, jclass, jlong ssl_ctx_address,
@@ -8836,6 +9683,97 @@ static void NativeCrypto_SSL_CTX_set_session_id_context(JNIEnv* env, jclass, jlo
     JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_session_id_context => ok", ssl_ctx);
 }
 
+/**
+ * Offers and accepts compressed certificate chains (RFC 8879) on connections
+ * of the context. Returns false if this build has no compression algorithm.
+ * Must be called at most once per context.
+ */
+static jboolean NativeCrypto_SSL_CTX_enable_cert_compression(JNIEnv* env, jclass,
+                                                             jlong ssl_ctx_address,
+                                                             CONSCRYPT_UNUSED jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_enable_cert_compression", ssl_ctx);
+    if (ssl_ctx == nullptr) {
+        return JNI_FALSE;
+    }
+    bool enabled = conscrypt::cert_compression::enable(ssl_ctx);
+    ERR_clear_error();
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_enable_cert_compression => %d", ssl_ctx, enabled);
+    return enabled ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Caches successful certificate verifications of connections of the SSL_CTX
+ * that opted in with SSL_set_verify_cache_scope, for at most ttlMillis. Zero
+ * maxEntries disables the cache.
+ */
+static void NativeCrypto_SSL_CTX_set_verify_cache(JNIEnv* env, jclass, jlong ssl_ctx_address,
+                                                  CONSCRYPT_UNUSED jobject holder,
+                                                  jint maxEntries, jlong ttlMillis) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_verify_cache maxEntries=%d ttlMillis=%lld",
+              ssl_ctx, maxEntries, static_cast<long long>(ttlMillis));  // NOLINT(runtime/int)
+    if (ssl_ctx == nullptr) {
+        return;
+    }
+    if (maxEntries < 0 || ttlMillis < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "maxEntries < 0 || ttlMillis < 0");
+        return;
+    }
+    VerifyCache* cache = VerifyCache::getOrCreate(ssl_ctx);
+    if (cache == nullptr) {
+        conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate verification cache");
+        return;
+    }
+    cache->configure(static_cast<size_t>(maxEntries), ttlMillis);
+}
+
+static void NativeCrypto_SSL_CTX_clear_verify_cache(JNIEnv* env, jclass, jlong ssl_ctx_address,
+                                                    CONSCRYPT_UNUSED jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_clear_verify_cache", ssl_ctx);
+    if (ssl_ctx == nullptr) {
+        return;
+    }
+    VerifyCache* cache = VerifyCache::get(ssl_ctx);
+    if (cache != nullptr) {
+        cache->clear();
+    }
+}
+
+/**
+ * Returns the hits, misses and entries of the verification cache of the
+ * SSL_CTX, or null if it has none.
+ */
+static jlongArray NativeCrypto_SSL_CTX_get_verify_cache_stats(JNIEnv* env, jclass,
+                                                              jlong ssl_ctx_address,
+                                                              CONSCRYPT_UNUSED jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_get_verify_cache_stats", ssl_ctx);
+    if (ssl_ctx == nullptr) {
+        return nullptr;
+    }
+    VerifyCache* cache = VerifyCache::get(ssl_ctx);
+    if (cache == nullptr) {
+        return nullptr;
+    }
+    jlong values[VerifyCache::kStatCount];
+    cache->stats(values);
+    ScopedLocalRef<jlongArray> result(env, env->NewLongArray(VerifyCache::kStatCount));
+    if (result.get() == nullptr) {
+        JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_get_verify_cache_stats => threw exception",
+                  ssl_ctx);
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result.get(), 0, VerifyCache::kStatCount, values);
+    return result.release();
+}
+
 static jlong NativeCrypto_SSL_CTX_set_timeout(JNIEnv* env, jclass, jlong ssl_ctx_address,
                                               CONSCRYPT_UNUSED jobject holder, jlong seconds) {
     CHECK_ERROR_QUEUE_ON_RETURN;
@@ -8882,6 +9820,7 @@ static jlong NativeCrypto_SSL_new(JNIEnv* env, jclass, jlong ssl_ctx_address,
     SSL_set_custom_verify(ssl.get(), SSL_VERIFY_PEER, cert_verify_callback);
 
     JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_new => ssl=%p appData=%p", ssl_ctx, ssl.get(), appData);
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kSsl, 1);
     return (jlong)ssl.release();
 }
 
@@ -8975,66 +9914,138 @@ static void NativeCrypto_SSL_set1_tls_channel_id(JNIEnv* env, jclass, jlong ssl_
     JNI_TRACE("ssl=%p SSL_set1_tls_channel_id => ok", ssl);
 }
 
-static void NativeCrypto_setLocalCertsAndPrivateKey(JNIEnv* env, jclass, jlong ssl_address,
-                                                    CONSCRYPT_UNUSED jobject ssl_holder,
-                                                    jobjectArray encodedCertificatesJava,
-                                                    jobject pkeyRef) {
-    CHECK_ERROR_QUEUE_ON_RETURN;
-    SSL* ssl = to_SSL(env, ssl_address, true);
-    JNI_TRACE(
-            "ssl=%p NativeCrypto_SSL_set_chain_and_key certificates=%p, "
-            "privateKey=%p",
-            ssl, encodedCertificatesJava, pkeyRef);
-    if (ssl == nullptr) {
-        return;
+/**
+ * Copies the encoded certificates of a Java byte[][] chain into CRYPTO_BUFFERs.
+ * refs owns the buffers and buffers points at them, in the form BoringSSL
+ * takes a chain. Returns false with an exception pending on failure.
+ */
+static bool copyCertificateChain(JNIEnv* env, jobjectArray encodedCertificatesJava,
+                                 std::vector<bssl::UniquePtr<CRYPTO_BUFFER>>* refs,
+                                 std::vector<CRYPTO_BUFFER*>* buffers) {
+    size_t numCerts = static_cast<size_t>(env->GetArrayLength(encodedCertificatesJava));
+    refs->resize(numCerts);
+    buffers->resize(numCerts);
+    for (size_t i = 0; i < numCerts; ++i) {
+        ScopedLocalRef<jbyteArray> certArray(
+                env, reinterpret_cast<jbyteArray>(
+                             env->GetObjectArrayElement(encodedCertificatesJava, i)));
+        (*refs)[i] = ByteArrayToCryptoBuffer(env, certArray.get(), certificatePool());
+        if (!(*refs)[i]) {
+            return false;
+        }
+        (*buffers)[i] = (*refs)[i].get();
     }
+    return true;
+}
+
+/**
+ * Builds a certificate credential from a chain and its private key, once, so
+ * that it can be attached to any number of SSLs with SSL_add1_credential
+ * rather than copying the chain into every connection.
+ */
+static jlong NativeCrypto_SSL_CREDENTIAL_new_x509(JNIEnv* env, jclass,
+                                                  jobjectArray encodedCertificatesJava,
+                                                  jobject pkeyRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("SSL_CREDENTIAL_new_x509 certificates=%p, privateKey=%p", encodedCertificatesJava,
+              pkeyRef);
     if (encodedCertificatesJava == nullptr) {
         conscrypt::jniutil::throwNullPointerException(env, "certificates == null");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_chain_and_key => certificates == null", ssl);
-        return;
+        JNI_TRACE("SSL_CREDENTIAL_new_x509 => certificates == null");
+        return 0;
     }
     size_t numCerts = static_cast<size_t>(env->GetArrayLength(encodedCertificatesJava));
     if (numCerts == 0) {
         conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
                                            "certificates.length == 0");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_chain_and_key => certificates.length == 0", ssl);
-        return;
-    }
-    if (pkeyRef == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "privateKey == null");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_chain_and_key => privateKey == null", ssl);
-        return;
+        JNI_TRACE("SSL_CREDENTIAL_new_x509 => certificates.length == 0");
+        return 0;
     }
-
-    // Get the private key.
     EVP_PKEY* pkey = fromContextObject<EVP_PKEY>(env, pkeyRef);
     if (pkey == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "pkey == null");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_chain_and_key => pkey == null", ssl);
-        return;
+        JNI_TRACE("SSL_CREDENTIAL_new_x509 => pkey == null");
+        return 0;
     }
 
-    // Copy the certificates.
-    std::vector<bssl::UniquePtr<CRYPTO_BUFFER>> certBufferRefs(numCerts);
-    std::vector<CRYPTO_BUFFER*> certBuffers(numCerts);
-    for (size_t i = 0; i < numCerts; ++i) {
-        ScopedLocalRef<jbyteArray> certArray(
-                env, reinterpret_cast<jbyteArray>(
-                             env->GetObjectArrayElement(encodedCertificatesJava, i)));
-        certBufferRefs[i] = ByteArrayToCryptoBuffer(env, certArray.get(), nullptr);
-        if (!certBufferRefs[i]) {
-            return;
-        }
-        certBuffers[i] = certBufferRefs[i].get();
+    std::vector<bssl::UniquePtr<CRYPTO_BUFFER>> certBufferRefs;
+    std::vector<CRYPTO_BUFFER*> certBuffers;
+    if (!copyCertificateChain(env, encodedCertificatesJava, &certBufferRefs, &certBuffers)) {
+        return 0;
+    }
+
+    bssl::UniquePtr<SSL_CREDENTIAL> cred(SSL_CREDENTIAL_new_x509());
+    if (!cred || !SSL_CREDENTIAL_set1_cert_chain(cred.get(), certBuffers.data(), numCerts) ||
+        !SSL_CREDENTIAL_set1_private_key(cred.get(), pkey)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "SSL_CREDENTIAL_new_x509");
+        JNI_TRACE("SSL_CREDENTIAL_new_x509 => error");
+        return 0;
     }
+    JNI_TRACE("SSL_CREDENTIAL_new_x509 => %p", cred.get());
+    return reinterpret_cast<uintptr_t>(cred.release());
+}
 
-    if (!SSL_set_chain_and_key(ssl, certBuffers.data(), numCerts, pkey, nullptr)) {
+static void NativeCrypto_SSL_CREDENTIAL_free(JNIEnv* env, jclass, jlong credRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CREDENTIAL* cred = reinterpret_cast<SSL_CREDENTIAL*>(static_cast<uintptr_t>(credRef));
+    JNI_TRACE("SSL_CREDENTIAL_free(%p)", cred);
+    if (cred == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "credential == null");
+        return;
+    }
+    SSL_CREDENTIAL_free(cred);
+}
+
+/**
+ * Adds a credential built by SSL_CREDENTIAL_new_x509 to the candidates of the
+ * SSL. The SSL takes a reference rather than a copy. When several are added,
+ * BoringSSL picks the first one, in the order added, that the peer supports.
+ */
+static void NativeCrypto_SSL_add1_credential(JNIEnv* env, jclass, jlong ssl_address,
+                                             CONSCRYPT_UNUSED jobject ssl_holder,
+                                             jobject credRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_add1_credential credential=%p", ssl, credRef);
+    if (ssl == nullptr) {
+        return;
+    }
+    SSL_CREDENTIAL* cred = fromContextObject<SSL_CREDENTIAL>(env, credRef);
+    if (cred == nullptr) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_add1_credential => cred == null", ssl);
+        return;
+    }
+    if (!SSL_add1_credential(ssl, cred)) {
         conscrypt::jniutil::throwSSLExceptionWithSslErrors(env, ssl, SSL_ERROR_NONE,
                                                            "Error configuring certificate");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_chain_and_key => error", ssl);
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_add1_credential => error", ssl);
         return;
     }
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_chain_and_key => ok", ssl);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_add1_credential => ok", ssl);
+}
+
+/**
+ * Returns the address of the credential chosen by the current handshake or,
+ * once it is done, by the last one; 0 if none was chosen, e.g. on resumption.
+ */
+static jlong NativeCrypto_SSL_get_selected_credential(JNIEnv* env, jclass, jlong ssl_address,
+                                                      CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_selected_credential", ssl);
+    if (ssl == nullptr) {
+        return 0;
+    }
+    const SSL_CREDENTIAL* cred = SSL_get0_selected_credential(ssl);
+    if (cred == nullptr) {
+        AppData* appData = toAppData(ssl);
+        if (appData == nullptr) {
+            conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+            return 0;
+        }
+        cred = appData->selectedCredential.get();
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_selected_credential => %p", ssl, cred);
+    return reinterpret_cast<uintptr_t>(cred);
 }
 
 static void NativeCrypto_SSL_set_client_CA_list(JNIEnv* env, jclass, jlong ssl_address,
@@ -9070,7 +10081,8 @@ static void NativeCrypto_SSL_set_client_CA_list(JNIEnv* env, jclass, jlong ssl_a
     for (int i = 0; i < length; i++) {
         ScopedLocalRef<jbyteArray> principal(
                 env, reinterpret_cast<jbyteArray>(env->GetObjectArrayElement(principals, i)));
-        bssl::UniquePtr<CRYPTO_BUFFER> buf = ByteArrayToCryptoBuffer(env, principal.get(), nullptr);
+        bssl::UniquePtr<CRYPTO_BUFFER> buf =
+                ByteArrayToCryptoBuffer(env, principal.get(), certificatePool());
         if (!buf) {
             return;
         }
@@ -9635,6 +10647,133 @@ static void NativeCrypto_SSL_set_verify(JNIEnv* env, jclass, jlong ssl_address,
     SSL_set_custom_verify(ssl, static_cast<int>(mode), cert_verify_callback);
 }
 
+/**
+ * Enables or disables asynchronous verification of the peer certificate chain.
+ * When enabled, the handshake returns SSL_ERROR_WANT_CERTIFICATE_VERIFY instead
+ * of calling verifyCertificateChain, and the outcome is reported later with
+ * NativeCrypto_SSL_set_cert_verify_result.
+ */
+static void NativeCrypto_SSL_set_async_cert_verification(JNIEnv* env, jclass, jlong ssl_address,
+                                                         CONSCRYPT_UNUSED jobject ssl_holder,
+                                                         jboolean enabled) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_async_cert_verification enabled=%d", ssl, enabled);
+    if (ssl == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_async_cert_verification => appData == null", ssl);
+        return;
+    }
+    appData->asyncCertVerification = enabled == JNI_TRUE;
+}
+
+/**
+ * Returns the key exchange name of the pending cipher, which is the authMethod
+ * passed to the trust manager when verifying the peer certificate chain.
+ */
+static jstring NativeCrypto_SSL_get_pending_cipher_auth_method(JNIEnv* env, jclass,
+                                                              jlong ssl_address,
+                                                              CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_pending_cipher_auth_method", ssl);
+    if (ssl == nullptr) {
+        return nullptr;
+    }
+    const char* authMethod = pending_auth_method(ssl);
+    if (authMethod == nullptr) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_get_pending_cipher_auth_method cipher => null", ssl);
+        return nullptr;
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_pending_cipher_auth_method => %s", ssl, authMethod);
+    return env->NewStringUTF(authMethod);
+}
+
+/**
+ * Posts the outcome of an asynchronous certificate verification. The handshake
+ * picks it up the next time it is resumed. May be called from any thread.
+ */
+static void NativeCrypto_SSL_set_cert_verify_result(JNIEnv* env, jclass, jlong ssl_address,
+                                                    CONSCRYPT_UNUSED jobject ssl_holder,
+                                                    jboolean verified) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_cert_verify_result verified=%d", ssl, verified);
+    if (ssl == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_cert_verify_result => appData == null", ssl);
+        return;
+    }
+    int expected = AppData::ASYNC_PENDING;
+    if (!appData->certVerifyState.compare_exchange_strong(
+                expected, verified ? AppData::ASYNC_OK : AppData::ASYNC_FAILED)) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalStateException",
+                                           "No certificate verification pending");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_cert_verify_result => not pending", ssl);
+    }
+}
+
+/**
+ * Enables or disables asynchronous selection of the server certificate. When
+ * enabled, select_certificate_cb still calls serverCertificateRequested but then
+ * suspends the handshake with SSL_ERROR_PENDING_CERTIFICATE until the Java layer
+ * reports completion with NativeCrypto_SSL_set_cert_selection_result.
+ */
+static void NativeCrypto_SSL_set_async_cert_selection(JNIEnv* env, jclass, jlong ssl_address,
+                                                      CONSCRYPT_UNUSED jobject ssl_holder,
+                                                      jboolean enabled) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_async_cert_selection enabled=%d", ssl, enabled);
+    if (ssl == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_async_cert_selection => appData == null", ssl);
+        return;
+    }
+    appData->asyncCertSelection = enabled == JNI_TRUE;
+}
+
+/**
+ * Reports whether a pending asynchronous certificate selection succeeded. The
+ * handshake picks it up the next time it is resumed. May be called from any
+ * thread.
+ */
+static void NativeCrypto_SSL_set_cert_selection_result(JNIEnv* env, jclass, jlong ssl_address,
+                                                       CONSCRYPT_UNUSED jobject ssl_holder,
+                                                       jboolean selected) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_cert_selection_result selected=%d", ssl, selected);
+    if (ssl == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_cert_selection_result => appData == null", ssl);
+        return;
+    }
+    int expected = AppData::ASYNC_PENDING;
+    if (!appData->certSelectState.compare_exchange_strong(
+                expected, selected ? AppData::ASYNC_OK : AppData::ASYNC_FAILED)) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalStateException",
+                                           "No certificate selection pending");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_cert_selection_result => not pending", ssl);
+    }
+}
+
 /**
  * Sets the ciphers suites that are enabled in the SSL
  */
@@ -9759,6 +10898,34 @@ static jstring NativeCrypto_SSL_get_servername(JNIEnv* env, jclass, jlong ssl_ad
     return env->NewStringUTF(servername);
 }
 
+/**
+ * Lets verifications of the peer's chain be cached in the verification cache
+ * of the SSL_CTX. Only verifications made within the same scope are reused;
+ * the scope encodes everything besides the chain that they depend on.
+ */
+static void NativeCrypto_SSL_set_verify_cache_scope(JNIEnv* env, jclass, jlong ssl_address,
+                                                    CONSCRYPT_UNUSED jobject ssl_holder,
+                                                    jstring scope) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_verify_cache_scope scope=%p", ssl, scope);
+    if (ssl == nullptr) {
+        return;
+    }
+    ScopedUtfChars scopeChars(env, scope);
+    if (scopeChars.c_str() == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        return;
+    }
+    appData->verifyCacheScope.assign(scopeChars.c_str(), scopeChars.size());
+    appData->verifyCacheEnabled = true;
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_verify_cache_scope => %s", ssl, scopeChars.c_str());
+}
+
 /**
  * Selects the ALPN protocol to use. The list of protocols in "primary" is
  * considered the order which should take precedence.
@@ -10020,7 +11187,10 @@ static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address
             JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake setCallbackState => exception", ssl);
             return;
         }
-        ret = SSL_do_handshake(ssl);
+        {
+            HandshakeTimer::Step step(appData->handshakeTimer.get());
+            ret = SSL_do_handshake(ssl);
+        }
         appData->clearCallbackState();
         // cert_verify_callback threw exception
         if (env->ExceptionCheck()) {
@@ -10038,6 +11208,7 @@ static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address
         }
         // error case
         sslError.reset(ssl, ret);
+        appData->stats.countError(sslError.get());
         JNI_TRACE(
                 "ssl=%p NativeCrypto_SSL_do_handshake ret=%d errno=%d sslError=%d "
                 "timeout_millis=%d",
@@ -10221,6 +11392,386 @@ static jobjectArray NativeCrypto_SSL_get0_peer_certificates(JNIEnv* env, jclass,
     return array.release();
 }
 
+/**
+ * Like SSL_get0_peer_certificates, but returns handles to the certificates'
+ * buffers rather than copies of them. See CryptoBuffersToHandleArray.
+ */
+static jlongArray NativeCrypto_SSL_get0_peer_certificate_refs(JNIEnv* env, jclass,
+                                                              jlong ssl_address,
+                                                              CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get0_peer_certificate_refs", ssl);
+    if (ssl == nullptr) {
+        return nullptr;
+    }
+
+    const STACK_OF(CRYPTO_BUFFER)* chain = SSL_get0_peer_certificates(ssl);
+    if (chain == nullptr) {
+        return nullptr;
+    }
+
+    ScopedLocalRef<jlongArray> array(env, CryptoBuffersToHandleArray(env, chain));
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get0_peer_certificate_refs => %p", ssl, array.get());
+    return array.release();
+}
+
+#if CONSCRYPT_KTLS
+
+/**
+ * Linux kernel TLS (kTLS) support for socket-mode connections. Once the
+ * handshake is complete, the traffic keys and sequence numbers are handed to
+ * the kernel with setsockopt(SOL_TLS) so that sslRead() and sslWrite() turn
+ * into plain socket I/O. Only the AEAD ciphers the kernel understands are
+ * offloaded; everything else keeps using BoringSSL.
+ */
+static const int kKtlsTx = 1;
+static const int kKtlsRx = 2;
+
+static const unsigned char kTlsRecordTypeAlert = 21;
+static const unsigned char kTlsRecordTypeHandshake = 22;
+static const unsigned char kTlsRecordTypeApplicationData = 23;
+
+static void ktlsPutSequence(uint8_t out[8], uint64_t seq) {
+    for (int i = 7; i >= 0; i--) {
+        out[i] = static_cast<uint8_t>(seq);
+        seq >>= 8;
+    }
+}
+
+/**
+ * HKDF-Expand-Label from RFC 8446, section 7.1, with an empty context.
+ */
+static bool ktlsExpandLabel(uint8_t* out, size_t out_len, const EVP_MD* digest,
+                            bssl::Span<const uint8_t> secret, const char* label) {
+    static const char kPrefix[] = "tls13 ";
+    size_t prefix_len = sizeof(kPrefix) - 1;
+    size_t label_len = strlen(label);
+    std::vector<uint8_t> info;
+    info.push_back(static_cast<uint8_t>(out_len >> 8));
+    info.push_back(static_cast<uint8_t>(out_len));
+    info.push_back(static_cast<uint8_t>(prefix_len + label_len));
+    info.insert(info.end(), kPrefix, kPrefix + prefix_len);
+    info.insert(info.end(), label, label + label_len);
+    info.push_back(0);
+    return HKDF_expand(out, out_len, digest, secret.data(), secret.size(), info.data(),
+                       info.size()) == 1;
+}
+
+/**
+ * Computes the AEAD key and the fixed part of the nonce for one direction of
+ * the connection. For TLS 1.2 the nonce is the implicit part of the IV from the
+ * key block, for TLS 1.3 it is the full per-record IV.
+ */
+static bool ktlsTrafficKeys(SSL* ssl, bool write, uint8_t* key, size_t key_len, uint8_t* iv,
+                            size_t* iv_len) {
+    if (SSL_version(ssl) == TLS1_3_VERSION) {
+        bssl::Span<const uint8_t> readSecret;
+        bssl::Span<const uint8_t> writeSecret;
+        if (!bssl::SSL_get_traffic_secrets(ssl, &readSecret, &writeSecret)) {
+            return false;
+        }
+        const EVP_MD* digest = SSL_CIPHER_get_handshake_digest(SSL_get_current_cipher(ssl));
+        bssl::Span<const uint8_t> secret = write ? writeSecret : readSecret;
+        *iv_len = 12;
+        return ktlsExpandLabel(key, key_len, digest, secret, "key") &&
+               ktlsExpandLabel(iv, *iv_len, digest, secret, "iv");
+    }
+
+    // TLS 1.2: client_write_key, server_write_key, client_write_IV, server_write_IV.
+    // AEAD ciphers have no MAC keys.
+    size_t blockLen = SSL_get_key_block_len(ssl);
+    if (blockLen < 2 * key_len || (blockLen - 2 * key_len) % 2 != 0) {
+        return false;
+    }
+    std::vector<uint8_t> block(blockLen);
+    if (!SSL_generate_key_block(ssl, block.data(), block.size())) {
+        return false;
+    }
+    *iv_len = (blockLen - 2 * key_len) / 2;
+    bool clientSide = (write == !SSL_is_server(ssl));
+    memcpy(key, block.data() + (clientSide ? 0 : key_len), key_len);
+    memcpy(iv, block.data() + 2 * key_len + (clientSide ? 0 : *iv_len), *iv_len);
+    OPENSSL_cleanse(block.data(), block.size());
+    return true;
+}
+
+template <typename CryptoInfo>
+static bool ktlsInstallGcm(SSL* ssl, int fd, bool write, uint16_t cipherType) {
+    CryptoInfo info;
+    memset(&info, 0, sizeof(info));
+    info.info.version = SSL_version(ssl) == TLS1_3_VERSION ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+    info.info.cipher_type = cipherType;
+    uint64_t seq = write ? SSL_get_write_sequence(ssl) : SSL_get_read_sequence(ssl);
+    ktlsPutSequence(info.rec_seq, seq);
+
+    uint8_t iv[EVP_MAX_IV_LENGTH];
+    size_t ivLen;
+    if (!ktlsTrafficKeys(ssl, write, info.key, sizeof(info.key), iv, &ivLen)) {
+        return false;
+    }
+    if (ivLen == sizeof(info.salt)) {
+        // TLS 1.2: the explicit part of the nonce is the sequence number, as in BoringSSL.
+        memcpy(info.salt, iv, sizeof(info.salt));
+        memcpy(info.iv, info.rec_seq, sizeof(info.iv));
+    } else if (ivLen == sizeof(info.salt) + sizeof(info.iv)) {
+        memcpy(info.salt, iv, sizeof(info.salt));
+        memcpy(info.iv, iv + sizeof(info.salt), sizeof(info.iv));
+    } else {
+        return false;
+    }
+    int rc = setsockopt(fd, SOL_TLS, write ? TLS_TX : TLS_RX, &info, sizeof(info));
+    OPENSSL_cleanse(&info, sizeof(info));
+    OPENSSL_cleanse(iv, sizeof(iv));
+    return rc == 0;
+}
+
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+static bool ktlsInstallChaCha(SSL* ssl, int fd, bool write) {
+    tls12_crypto_info_chacha20_poly1305 info;
+    memset(&info, 0, sizeof(info));
+    info.info.version = SSL_version(ssl) == TLS1_3_VERSION ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+    info.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+    uint64_t seq = write ? SSL_get_write_sequence(ssl) : SSL_get_read_sequence(ssl);
+    ktlsPutSequence(info.rec_seq, seq);
+
+    size_t ivLen;
+    if (!ktlsTrafficKeys(ssl, write, info.key, sizeof(info.key), info.iv, &ivLen) ||
+        ivLen != sizeof(info.iv)) {
+        OPENSSL_cleanse(&info, sizeof(info));
+        return false;
+    }
+    int rc = setsockopt(fd, SOL_TLS, write ? TLS_TX : TLS_RX, &info, sizeof(info));
+    OPENSSL_cleanse(&info, sizeof(info));
+    return rc == 0;
+}
+#endif  // TLS_CIPHER_CHACHA20_POLY1305
+
+static bool ktlsInstall(SSL* ssl, int fd, bool write) {
+    switch (SSL_CIPHER_get_cipher_nid(SSL_get_current_cipher(ssl))) {
+        case NID_aes_128_gcm:
+            return ktlsInstallGcm<tls12_crypto_info_aes_gcm_128>(ssl, fd, write,
+                                                                 TLS_CIPHER_AES_GCM_128);
+        case NID_aes_256_gcm:
+            return ktlsInstallGcm<tls12_crypto_info_aes_gcm_256>(ssl, fd, write,
+                                                                 TLS_CIPHER_AES_GCM_256);
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        case NID_chacha20_poly1305:
+            return ktlsInstallChaCha(ssl, fd, write);
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * Reads application data from a socket with kTLS receive offload. Alerts and
+ * post-handshake messages arrive as records of other types, which the kernel
+ * reports through a control message.
+ */
+static int ktlsRead(JNIEnv* env, SSL* ssl, jobject fdObject, AppData* appData, char* buf,
+                    jint len, int read_timeout_millis) {
+    while (appData->aliveAndKicking) {
+        NetFd fd(env, fdObject);
+        if (fd.isClosed()) {
+            return THROWN_EXCEPTION;
+        }
+
+        char control[CMSG_SPACE(sizeof(unsigned char))];
+        struct iovec iov;
+        iov.iov_base = buf;
+        iov.iov_len = static_cast<size_t>(len);
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t result = recvmsg(fd.get(), &msg, MSG_DONTWAIT);
+        JNI_TRACE("ssl=%p ktlsRead recvmsg result=%zd", ssl, result);
+        if (result == 0) {
+            // Connection closed without proper shutdown.
+            return -1;
+        }
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                conscrypt::jniutil::throwException(env, "java/net/SocketException",
+                                                   strerror(errno));
+                return THROWN_EXCEPTION;
+            }
+            {
+                std::lock_guard<std::mutex> appDataLock(appData->mutex);
+                appData->waitingThreads++;
+            }
+            int selectResult =
+                    sslSelect(env, SSL_ERROR_WANT_READ, fdObject, appData, read_timeout_millis);
+            if (selectResult == THROWN_EXCEPTION) {
+                return THROWN_EXCEPTION;
+            }
+            if (selectResult == -1) {
+                return THROW_SSLEXCEPTION;
+            }
+            if (selectResult == 0) {
+                return THROW_SOCKETTIMEOUTEXCEPTION;
+            }
+            continue;
+        }
+
+        unsigned char recordType = kTlsRecordTypeApplicationData;
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg != nullptr && cmsg->cmsg_level == SOL_TLS &&
+            cmsg->cmsg_type == TLS_GET_RECORD_TYPE) {
+            recordType = *reinterpret_cast<unsigned char*>(CMSG_DATA(cmsg));
+        }
+        if (recordType == kTlsRecordTypeApplicationData) {
+            return static_cast<int>(result);
+        }
+        if (recordType == kTlsRecordTypeAlert) {
+            if (result >= 2 && buf[1] == SSL_AD_CLOSE_NOTIFY) {
+                SSL_set_shutdown(ssl, SSL_get_shutdown(ssl) | SSL_RECEIVED_SHUTDOWN);
+                return -1;
+            }
+            conscrypt::jniutil::throwSSLExceptionStr(env, "Received fatal alert");
+            return THROWN_EXCEPTION;
+        }
+        if (recordType == kTlsRecordTypeHandshake && result >= 1 &&
+            buf[0] == SSL3_MT_NEW_SESSION_TICKET) {
+            // The kernel owns the read keys, so session tickets are dropped.
+            continue;
+        }
+        conscrypt::jniutil::throwSSLExceptionStr(
+                env, "Unsupported post-handshake message with kernel TLS");
+        return THROWN_EXCEPTION;
+    }
+    return -1;
+}
+
+/**
+ * Writes application data to a socket with kTLS transmit offload.
+ */
+static int ktlsWrite(JNIEnv* env, SSL* ssl, jobject fdObject, AppData* appData, const char* buf,
+                     jint len, int write_timeout_millis) {
+    int count = len;
+    while (appData->aliveAndKicking && len > 0) {
+        NetFd fd(env, fdObject);
+        if (fd.isClosed()) {
+            return THROWN_EXCEPTION;
+        }
+        ssize_t result = send(fd.get(), buf, static_cast<size_t>(len), MSG_DONTWAIT | MSG_NOSIGNAL);
+        JNI_TRACE("ssl=%p ktlsWrite send result=%zd", ssl, result);
+        if (result > 0) {
+            buf += result;
+            len -= static_cast<jint>(result);
+            continue;
+        }
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            conscrypt::jniutil::throwException(env, "java/net/SocketException", strerror(errno));
+            return THROWN_EXCEPTION;
+        }
+        {
+            std::lock_guard<std::mutex> appDataLock(appData->mutex);
+            appData->waitingThreads++;
+        }
+        int selectResult =
+                sslSelect(env, SSL_ERROR_WANT_WRITE, fdObject, appData, write_timeout_millis);
+        if (selectResult == THROWN_EXCEPTION) {
+            return THROWN_EXCEPTION;
+        }
+        if (selectResult == -1) {
+            return THROW_SSLEXCEPTION;
+        }
+        if (selectResult == 0) {
+            return THROW_SOCKETTIMEOUTEXCEPTION;
+        }
+    }
+    return count;
+}
+
+/**
+ * Sends part of a file on a socket with kTLS transmit offload. The kernel
+ * encrypts straight from the page cache, so the file contents never enter
+ * user space. Returns the number of bytes sent, which is less than count only
+ * if the end of the file is reached.
+ */
+static int64_t ktlsSendFile(JNIEnv* env, SSL* ssl, jobject fdObject, AppData* appData, int fileFd,
+                            ktls_off_t offset, int64_t count, int write_timeout_millis) {
+    int64_t sent = 0;
+    while (appData->aliveAndKicking && sent < count) {
+        NetFd fd(env, fdObject);
+        if (fd.isClosed()) {
+            return THROWN_EXCEPTION;
+        }
+        // sendfile() transfers at most 0x7ffff000 bytes per call.
+        size_t chunk = static_cast<size_t>(std::min<int64_t>(count - sent, 0x40000000));
+        ssize_t result = ktls_sendfile(fd.get(), fileFd, &offset, chunk);
+        JNI_TRACE("ssl=%p ktlsSendFile sendfile result=%zd", ssl, result);
+        if (result > 0) {
+            sent += result;
+            continue;
+        }
+        if (result == 0) {
+            // End of file.
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            conscrypt::jniutil::throwException(env, "java/net/SocketException", strerror(errno));
+            return THROWN_EXCEPTION;
+        }
+        {
+            std::lock_guard<std::mutex> appDataLock(appData->mutex);
+            appData->waitingThreads++;
+        }
+        int selectResult =
+                sslSelect(env, SSL_ERROR_WANT_WRITE, fdObject, appData, write_timeout_millis);
+        if (selectResult == THROWN_EXCEPTION) {
+            return THROWN_EXCEPTION;
+        }
+        if (selectResult == -1) {
+            return THROW_SSLEXCEPTION;
+        }
+        if (selectResult == 0) {
+            return THROW_SOCKETTIMEOUTEXCEPTION;
+        }
+    }
+    return sent;
+}
+
+/**
+ * Sends a close_notify alert on a socket with kTLS transmit offload, since
+ * BoringSSL no longer owns the write keys.
+ */
+static void ktlsSendCloseNotify(int fd) {
+    unsigned char alert[2] = {SSL3_AL_WARNING, SSL_AD_CLOSE_NOTIFY};
+    char control[CMSG_SPACE(sizeof(unsigned char))];
+    struct iovec iov;
+    iov.iov_base = alert;
+    iov.iov_len = sizeof(alert);
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+    *reinterpret_cast<unsigned char*>(CMSG_DATA(cmsg)) = kTlsRecordTypeAlert;
+    CONSCRYPT_UNUSED ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+}
+
+#endif  // CONSCRYPT_KTLS
+
 static int sslRead(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* buf, jint len,
                    SslError* sslError, int read_timeout_millis) {
     JNI_TRACE("ssl=%p sslRead buf=%p len=%d", ssl, buf, len);
@@ -10238,6 +11789,13 @@ static int sslRead(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* b
     if (appData == nullptr) {
         return THROW_SSLEXCEPTION;
     }
+#if CONSCRYPT_KTLS
+    if (appData->ktlsRx) {
+        int result = ktlsRead(env, ssl, fdObject, appData, buf, len, read_timeout_millis);
+        appData->stats.countRead(result, SSL_ERROR_NONE);
+        return result;
+    }
+#endif
 
     while (appData->aliveAndKicking) {
         errno = 0;
@@ -10264,6 +11822,7 @@ static int sslRead(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* b
             return THROWN_EXCEPTION;
         }
         sslError->reset(ssl, result);
+        appData->stats.countRead(result, sslError->get());
 
         JNI_TRACE("ssl=%p sslRead SSL_read result=%d sslError=%d", ssl, result, sslError->get());
         if (conscrypt::trace::kWithJniTraceData) {
@@ -10492,6 +12051,49 @@ static jint NativeCrypto_SSL_read(JNIEnv* env, jclass, jlong ssl_address,
     return result;
 }
 
+/**
+ * Applies the dynamic record sizing policy of the connection, if any, before a
+ * write: records stay small until enough data has been written, or enough time
+ * has passed, since the handshake or since the connection was last idle, and
+ * are full-sized after that.
+ */
+static void recordSizingBeforeWrite(SSL* ssl, AppData* appData) {
+    if (appData->recordSizeSmall == 0) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (appData->recordSizeIdleMillis > 0 && appData->recordSizeWritten > 0 &&
+        now - appData->recordSizeLastWrite >
+                std::chrono::milliseconds(appData->recordSizeIdleMillis)) {
+        appData->recordSizeWritten = 0;
+    }
+    bool boosted = appData->recordSizeWritten >= appData->recordSizeBoostBytes ||
+                   (appData->recordSizeBoostMillis > 0 && appData->recordSizeWritten > 0 &&
+                    now - appData->recordSizeFirstWrite >=
+                            std::chrono::milliseconds(appData->recordSizeBoostMillis));
+    uint16_t size = boosted ? static_cast<uint16_t>(SSL3_RT_MAX_PLAIN_LENGTH)
+                            : appData->recordSizeSmall;
+    if (size != appData->recordSizeCurrent) {
+        SSL_set_max_send_fragment(ssl, size);
+        appData->recordSizeCurrent = size;
+    }
+}
+
+/**
+ * Accounts for the plaintext written by an SSL_write that returned result.
+ */
+static void recordSizingAfterWrite(AppData* appData, int result) {
+    if (appData->recordSizeSmall == 0 || result <= 0) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (appData->recordSizeWritten == 0) {
+        appData->recordSizeFirstWrite = now;
+    }
+    appData->recordSizeWritten += static_cast<uint64_t>(result);
+    appData->recordSizeLastWrite = now;
+}
+
 static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const char* buf, jint len,
                     SslError* sslError, int write_timeout_millis) {
     JNI_TRACE("ssl=%p sslWrite buf=%p len=%d write_timeout_millis=%d", ssl, buf, len,
@@ -10510,6 +12112,13 @@ static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const
     if (appData == nullptr) {
         return THROW_SSLEXCEPTION;
     }
+#if CONSCRYPT_KTLS
+    if (appData->ktlsTx) {
+        int result = ktlsWrite(env, ssl, fdObject, appData, buf, len, write_timeout_millis);
+        appData->stats.countWrite(result);
+        return result;
+    }
+#endif
 
     int count = len;
 
@@ -10531,7 +12140,9 @@ static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const
             return THROWN_EXCEPTION;
         }
         JNI_TRACE("ssl=%p sslWrite SSL_write len=%d", ssl, len);
+        recordSizingBeforeWrite(ssl, appData);
         int result = SSL_write(ssl, buf, len);
+        recordSizingAfterWrite(appData, result);
         appData->clearCallbackState();
         // callbacks can happen if server requests renegotiation
         if (env->ExceptionCheck()) {
@@ -10539,6 +12150,8 @@ static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const
             return THROWN_EXCEPTION;
         }
         sslError->reset(ssl, result);
+        appData->stats.countWrite(result);
+        appData->stats.countError(sslError->get());
 
         JNI_TRACE("ssl=%p sslWrite SSL_write result=%d sslError=%d", ssl, result, sslError->get());
         if (conscrypt::trace::kWithJniTraceData) {
@@ -10730,29 +12343,419 @@ static void NativeCrypto_SSL_write(JNIEnv* env, jclass, jlong ssl_address,
 }
 
 /**
- * Interrupt any pending I/O before closing the socket.
+ * Reads up to length bytes of a file at position into buffer, leaving the
+ * file's position alone. Unlike FileChannel#read, an interrupt does not close
+ * the file. Returns the number of bytes read, or -1 at the end of the file.
+ */
+static jint NativeCrypto_pread(JNIEnv* env, jclass, jobject fileObject, jbyteArray buffer,
+                               jint offset, jint length, jlong position) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("pread(%p, %p, %d, %d, %lld)", fileObject, buffer, offset, length,
+              static_cast<long long>(position));  // NOLINT(runtime/int)
+    if (fileObject == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "file == null");
+        return -1;
+    }
+    ScopedByteArrayRW bytes(env, buffer);
+    if (bytes.get() == nullptr) {
+        JNI_TRACE("pread(%p) => buffer == null", fileObject);
+        return -1;
+    }
+    if (ARRAY_OFFSET_LENGTH_INVALID(bytes, offset, length)) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "buffer");
+        JNI_TRACE("pread(%p) => invalid range", fileObject);
+        return -1;
+    }
+    if (position < 0) {
+        conscrypt::jniutil::throwIllegalArgumentException(env, "position < 0");
+        JNI_TRACE("pread(%p) => position < 0", fileObject);
+        return -1;
+    }
+#ifdef _WIN32
+    conscrypt::jniutil::throwException(env, "java/lang/UnsupportedOperationException",
+                                       "pread is not supported on Windows");
+    return -1;
+#else
+    int fd = conscrypt::jniutil::jniGetFDFromFileDescriptor(env, fileObject);
+    if (fd == -1) {
+        conscrypt::jniutil::throwIOException(env, "File closed");
+        JNI_TRACE("pread(%p) => file closed", fileObject);
+        return -1;
+    }
+    void* data = bytes.get() + offset;
+    ssize_t result;
+    do {
+#if defined(__linux__)
+        result = pread64(fd, data, static_cast<size_t>(length), static_cast<off64_t>(position));
+#else
+        result = pread(fd, data, static_cast<size_t>(length), static_cast<off_t>(position));
+#endif
+    } while (result == -1 && errno == EINTR);
+    if (result == -1) {
+        conscrypt::jniutil::throwIOException(env, strerror(errno));
+        JNI_TRACE("pread(%p) => error %s", fileObject, strerror(errno));
+        return -1;
+    }
+    JNI_TRACE("pread(%p) => %zd", fileObject, result);
+    return result == 0 && length > 0 ? -1 : static_cast<jint>(result);
+#endif
+}
+
+/**
+ * Writes count bytes of a file, starting at offset, to a connection whose
+ * transmit direction has been handed to the kernel with SSL_enable_ktls.
+ */
+static jlong NativeCrypto_SSL_sendfile(JNIEnv* env, jclass, jlong ssl_address,
+                                       CONSCRYPT_UNUSED jobject ssl_holder, jobject fdObject,
+                                       jobject fileObject, jlong offset, jlong count,
+                                       jint write_timeout_millis) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE(
+            "ssl=%p NativeCrypto_SSL_sendfile fd=%p file=%p offset=%lld count=%lld "
+            "write_timeout_millis=%d",
+            ssl, fdObject, fileObject, static_cast<long long>(offset),  // NOLINT(runtime/int)
+            static_cast<long long>(count), write_timeout_millis);       // NOLINT(runtime/int)
+    if (ssl == nullptr) {
+        return 0;
+    }
+    if (fdObject == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_sendfile => fd == null", ssl);
+        return 0;
+    }
+    if (fileObject == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "file == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_sendfile => file == null", ssl);
+        return 0;
+    }
+    if (offset < 0 || count < 0) {
+        conscrypt::jniutil::throwIllegalArgumentException(env, "offset < 0 || count < 0");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_sendfile => invalid range", ssl);
+        return 0;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_sendfile => appData == null", ssl);
+        return 0;
+    }
+#if CONSCRYPT_KTLS
+    if (appData->ktlsTx) {
+        int fileFd = conscrypt::jniutil::jniGetFDFromFileDescriptor(env, fileObject);
+        if (fileFd == -1) {
+            conscrypt::jniutil::throwIOException(env, "File closed");
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_sendfile => file closed", ssl);
+            return 0;
+        }
+        if (count > std::numeric_limits<ktls_off_t>::max() - offset) {
+            conscrypt::jniutil::throwIllegalArgumentException(
+                    env, "offset + count exceeds the largest supported file offset");
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_sendfile => offset too large", ssl);
+            return 0;
+        }
+        int64_t ret = ktlsSendFile(env, ssl, fdObject, appData, fileFd,
+                                   static_cast<ktls_off_t>(offset), count, write_timeout_millis);
+        switch (ret) {
+            case THROW_SSLEXCEPTION:
+                conscrypt::jniutil::throwSSLExceptionStr(env, "Write error");
+                return 0;
+            case THROW_SOCKETTIMEOUTEXCEPTION:
+                conscrypt::jniutil::throwSocketTimeoutException(env, "Write timed out");
+                return 0;
+            case THROWN_EXCEPTION:
+                return 0;
+            default:
+                JNI_TRACE("ssl=%p NativeCrypto_SSL_sendfile => %lld", ssl,
+                          static_cast<long long>(ret));  // NOLINT(runtime/int)
+                return static_cast<jlong>(ret);
+        }
+    }
+#endif
+    conscrypt::jniutil::throwException(env, "java/lang/IllegalStateException",
+                                       "Kernel TLS transmit offload is not enabled");
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_sendfile => no kTLS", ssl);
+    return 0;
+}
+
+/**
+ * Interrupt any pending I/O before closing the socket.
+ */
+static void NativeCrypto_SSL_interrupt(JNIEnv* env, jclass, jlong ssl_address,
+                                       CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, false);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_interrupt", ssl);
+    if (ssl == nullptr) {
+        return;
+    }
+
+    /*
+     * Mark the connection as quasi-dead, then send something to the emergency
+     * file descriptor, so any blocking select() calls are woken up.
+     */
+    AppData* appData = toAppData(ssl);
+    if (appData != nullptr) {
+        appData->aliveAndKicking = false;
+
+        // At most two threads can be waiting. Outside Windows the second call
+        // is coalesced, but sslSelect leaves the signal in place once the
+        // connection is dead, so it still reaches both.
+        sslNotify(appData);
+        sslNotify(appData);
+    }
+}
+
+/**
+ * Opts the connection in to releasing its handshake configuration once the
+ * handshake is done: BoringSSL frees its certificate chain, private key and
+ * cipher configuration, AppData frees its copy of the ALPN protocols, and the
+ * buffers of the engine BIO are freed whenever they are empty. Shedding the
+ * configuration rules out renegotiation, which is therefore refused.
+ */
+static void NativeCrypto_SSL_set_shed_handshake_config(JNIEnv* env, jclass, jlong ssl_address,
+                                                       CONSCRYPT_UNUSED jobject ssl_holder,
+                                                       jboolean enabled) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_shed_handshake_config enabled=%d", ssl, enabled);
+    if (ssl == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_shed_handshake_config => appData == null", ssl);
+        return;
+    }
+    SSL_set_shed_handshake_config(ssl, enabled ? 1 : 0);
+    if (enabled) {
+        SSL_set_renegotiate_mode(ssl, ssl_renegotiate_never);
+    }
+    appData->shedHandshakeConfig = enabled;
+}
+
+/**
+ * Returns the number of bytes of native memory Conscrypt holds for the
+ * connection: its AppData, including copied ALPN protocols, and the buffers of
+ * its engine BIO, if any. Memory allocated by BoringSSL itself is not
+ * included: BoringSSL does not account for it per connection, and sizing its
+ * private structures from here would silently go stale. The certificates, key
+ * and cipher configuration freed by SSL_set_shed_handshake_config are
+ * therefore not visible in it; only the AppData and engine BIO savings are.
+ */
+static jlong NativeCrypto_SSL_get_native_footprint(JNIEnv* env, jclass, jlong ssl_address,
+                                                   CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_native_footprint", ssl);
+    if (ssl == nullptr) {
+        return 0;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        return 0;
+    }
+    size_t bytes = appData->footprint();
+    if (appData->engineBio != nullptr) {
+        bytes += sizeof(conscrypt::EngineBio) + appData->engineBio->allocatedBytes();
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_native_footprint => %zu", ssl, bytes);
+    return static_cast<jlong>(bytes);
+}
+
+/**
+ * Starts or stops recording where the time of the connection's handshakes
+ * goes. See HandshakeTimer.
+ */
+static void NativeCrypto_SSL_set_handshake_timing(JNIEnv* env, jclass, jlong ssl_address,
+                                                  CONSCRYPT_UNUSED jobject ssl_holder,
+                                                  jboolean enabled) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_handshake_timing enabled=%d", ssl, enabled);
+    if (ssl == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_handshake_timing => appData == null", ssl);
+        return;
+    }
+    appData->setHandshakeTiming(enabled);
+}
+
+/**
+ * Returns the timings of the last completed handshake, indexed by
+ * HandshakeTimer::Field, or null if none was recorded.
+ */
+static jlongArray NativeCrypto_SSL_get_handshake_timings(JNIEnv* env, jclass, jlong ssl_address,
+                                                         CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_handshake_timings", ssl);
+    if (ssl == nullptr) {
+        return nullptr;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr || !appData->handshakeTimer || !appData->handshakeTimer->finished()) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_get_handshake_timings => null", ssl);
+        return nullptr;
+    }
+    ScopedLocalRef<jlongArray> result(env, env->NewLongArray(HandshakeTimer::kFieldCount));
+    if (result.get() == nullptr) {
+        return nullptr;
+    }
+    static_assert(sizeof(jlong) == sizeof(int64_t), "jlong must be 64 bits");
+    env->SetLongArrayRegion(result.get(), 0, HandshakeTimer::kFieldCount,
+                            reinterpret_cast<const jlong*>(appData->handshakeTimer->values()));
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_handshake_timings => %p", ssl, result.get());
+    return result.release();
+}
+
+/**
+ * Returns the traffic counters of the connection, indexed by
+ * ConnectionStats::Counter.
+ */
+static jlongArray NativeCrypto_SSL_get_connection_stats(JNIEnv* env, jclass, jlong ssl_address,
+                                                        CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_connection_stats", ssl);
+    if (ssl == nullptr) {
+        return nullptr;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_get_connection_stats => appData == null", ssl);
+        return nullptr;
+    }
+    jlong values[ConnectionStats::kCounterCount];
+    for (int i = 0; i < ConnectionStats::kCounterCount; i++) {
+        values[i] = static_cast<jlong>(
+                appData->stats.get(static_cast<ConnectionStats::Counter>(i)));
+    }
+    ScopedLocalRef<jlongArray> result(env, env->NewLongArray(ConnectionStats::kCounterCount));
+    if (result.get() == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result.get(), 0, ConnectionStats::kCounterCount, values);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_connection_stats => %p", ssl, result.get());
+    return result.release();
+}
+
+/**
+ * Configures dynamic record sizing. While smallRecordSize is non-zero, records
+ * carry at most smallRecordSize bytes of plaintext until boostBytes have been
+ * written, so that the first bytes of a response can be decrypted before a
+ * full 16KB record has crossed a fresh congestion window. A slow writer would
+ * stay on small records for long after the window has opened, so they also end
+ * boostMillis (no limit, if 0) after the first small record was written.
+ * Records are then full-sized until the connection has been idle for
+ * idleMillis (never, if 0). Connections whose transmit direction is handled by
+ * kTLS are not affected.
  */
-static void NativeCrypto_SSL_interrupt(JNIEnv* env, jclass, jlong ssl_address,
-                                       CONSCRYPT_UNUSED jobject ssl_holder) {
+static void NativeCrypto_SSL_set_dynamic_record_sizing(JNIEnv* env, jclass, jlong ssl_address,
+                                                       CONSCRYPT_UNUSED jobject ssl_holder,
+                                                       jint smallRecordSize, jlong boostBytes,
+                                                       jlong boostMillis, jlong idleMillis) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    SSL* ssl = to_SSL(env, ssl_address, false);
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_interrupt", ssl);
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_dynamic_record_sizing small=%d boost=%lld/%lldms "
+              "idle=%lld",
+              ssl, smallRecordSize, static_cast<long long>(boostBytes),  // NOLINT(runtime/int)
+              static_cast<long long>(boostMillis),                       // NOLINT(runtime/int)
+              static_cast<long long>(idleMillis));                       // NOLINT(runtime/int)
     if (ssl == nullptr) {
         return;
     }
+    if ((smallRecordSize != 0 &&
+         (smallRecordSize < 512 || smallRecordSize > SSL3_RT_MAX_PLAIN_LENGTH)) ||
+        boostBytes < 0 || boostMillis < 0 || idleMillis < 0) {
+        conscrypt::jniutil::throwIllegalArgumentException(env, "Invalid record sizing parameters");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_dynamic_record_sizing => invalid", ssl);
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_dynamic_record_sizing => appData == null", ssl);
+        return;
+    }
+    appData->recordSizeSmall = static_cast<uint16_t>(smallRecordSize);
+    appData->recordSizeBoostBytes = static_cast<uint64_t>(boostBytes);
+    appData->recordSizeBoostMillis = boostMillis;
+    appData->recordSizeIdleMillis = idleMillis;
+    appData->recordSizeWritten = 0;
+    if (smallRecordSize == 0 && appData->recordSizeCurrent != 0) {
+        SSL_set_max_send_fragment(ssl, SSL3_RT_MAX_PLAIN_LENGTH);
+        appData->recordSizeCurrent = 0;
+    }
+}
 
-    /*
-     * Mark the connection as quasi-dead, then send something to the emergency
-     * file descriptor, so any blocking select() calls are woken up.
-     */
+/**
+ * Hands the traffic keys of a connection that has completed its handshake to
+ * the kernel, so that reads and writes on the socket no longer go through
+ * BoringSSL. The receive direction is installed first: if only that succeeds,
+ * BoringSSL still owns the write keys and can send alerts.
+ *
+ * Returns a combination of kKtlsRx and kKtlsTx for the directions that were
+ * offloaded, or 0 if the kernel or the negotiated parameters don't allow it.
+ */
+static jint NativeCrypto_SSL_enable_ktls(JNIEnv* env, jclass, jlong ssl_address,
+                                         CONSCRYPT_UNUSED jobject ssl_holder, jobject fdObject) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls fd=%p", ssl, fdObject);
+    if (ssl == nullptr) {
+        return 0;
+    }
+    if (fdObject == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => fd == null", ssl);
+        return 0;
+    }
+#if CONSCRYPT_KTLS
     AppData* appData = toAppData(ssl);
-    if (appData != nullptr) {
-        appData->aliveAndKicking = false;
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => appData == null", ssl);
+        return 0;
+    }
+    int version = SSL_version(ssl);
+    if (!SSL_is_init_finished(ssl) || SSL_in_false_start(ssl) || SSL_has_pending(ssl) ||
+        (version != TLS1_2_VERSION && version != TLS1_3_VERSION)) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => not eligible", ssl);
+        return 0;
+    }
 
-        // At most two threads can be waiting.
-        sslNotify(appData);
-        sslNotify(appData);
+    NetFd fd(env, fdObject);
+    if (fd.isClosed()) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => socket closed", ssl);
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> appDataLock(appData->mutex);
+    int enabled = 0;
+    if (setsockopt(fd.get(), SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == 0 &&
+        ktlsInstall(ssl, fd.get(), false)) {
+        appData->ktlsRx = true;
+        enabled |= kKtlsRx;
+        if (ktlsInstall(ssl, fd.get(), true)) {
+            appData->ktlsTx = true;
+            enabled |= kKtlsTx;
+        }
     }
+    ERR_clear_error();
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => %d", ssl, enabled);
+    return enabled;
+#else
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => unsupported", ssl);
+    return 0;
+#endif
 }
 
 /**
@@ -10794,6 +12797,18 @@ static void NativeCrypto_SSL_shutdown(JNIEnv* env, jclass, jlong ssl_address,
             conscrypt::netutil::setBlocking(fd, true);
         }
 #endif
+#if CONSCRYPT_KTLS
+        if (appData->ktlsTx) {
+            // The kernel owns the write keys, so BoringSSL can't send the alert.
+            appData->clearCallbackState();
+            if (fd != -1 && !(SSL_get_shutdown(ssl) & SSL_SENT_SHUTDOWN)) {
+                ktlsSendCloseNotify(fd);
+                SSL_set_shutdown(ssl, SSL_get_shutdown(ssl) | SSL_SENT_SHUTDOWN);
+            }
+            ERR_clear_error();
+            return;
+        }
+#endif
 
         int ret = SSL_shutdown(ssl);
         appData->clearCallbackState();
@@ -10865,6 +12880,7 @@ static void NativeCrypto_SSL_free(JNIEnv* env, jclass, jlong ssl_address,
     SSL_set_app_data(ssl, nullptr);
     delete appData;
     SSL_free(ssl);
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kSsl, -1);
 }
 
 static jbyteArray get_session_id(JNIEnv* env, SSL_SESSION* ssl_session) {
@@ -11098,6 +13114,7 @@ static void NativeCrypto_SSL_SESSION_up_ref(JNIEnv* env, jclass, jlong ssl_sessi
         return;
     }
     SSL_SESSION_up_ref(ssl_session);
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kSslSession, 1);
 }
 
 /**
@@ -11111,6 +13128,7 @@ static void NativeCrypto_SSL_SESSION_free(JNIEnv* env, jclass, jlong ssl_session
         return;
     }
     SSL_SESSION_free(ssl_session);
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kSslSession, -1);
 }
 
 /**
@@ -11153,6 +13171,7 @@ static jlong NativeCrypto_d2i_SSL_SESSION(JNIEnv* env, jclass, jbyteArray javaBy
     }
 
     JNI_TRACE("NativeCrypto_d2i_SSL_SESSION => %p", ssl_session);
+    conscrypt::memory_stats::add(conscrypt::memory_stats::kSslSession, 1);
     return reinterpret_cast<uintptr_t>(ssl_session);
 }
 
@@ -11471,7 +13490,13 @@ static jint NativeCrypto_SSL_get_error(JNIEnv* env, jclass, jlong ssl_address,
     if (ssl == nullptr) {
         return 0;
     }
-    return SSL_get_error(ssl, ret);
+    int error = SSL_get_error(ssl, ret);
+    AppData* appData = toAppData(ssl);
+    if (appData != nullptr) {
+        // The engine reports the errors of its writes through here.
+        appData->stats.countError(error);
+    }
+    return error;
 }
 
 static void NativeCrypto_SSL_clear_error(JNIEnv*, jclass) {
@@ -11521,14 +13546,18 @@ static jlong NativeCrypto_SSL_BIO_new(JNIEnv* env, jclass, jlong ssl_address,
 
     BIO* internal_bio;
     BIO* network_bio;
-    if (BIO_new_bio_pair(&internal_bio, 0, &network_bio, 0) != 1) {
+    if (!conscrypt::EngineBio::newPair(&internal_bio, &network_bio)) {
         conscrypt::jniutil::throwSSLExceptionWithSslErrors(env, ssl, SSL_ERROR_NONE,
-                                                           "BIO_new_bio_pair failed");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_BIO_new => BIO_new_bio_pair exception", ssl);
+                                                           "EngineBio::newPair failed");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_BIO_new => EngineBio::newPair exception", ssl);
         return 0;
     }
 
     SSL_set_bio(ssl, internal_bio, internal_bio);
+    AppData* appData = toAppData(ssl);
+    if (appData != nullptr) {
+        appData->engineBio = conscrypt::EngineBio::from(internal_bio);
+    }
 
     JNI_TRACE("ssl=%p NativeCrypto_SSL_BIO_new => network_bio=%p", ssl, network_bio);
     return reinterpret_cast<uintptr_t>(network_bio);
@@ -11568,7 +13597,11 @@ static jint NativeCrypto_ENGINE_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_
         return 0;
     }
 
-    int ret = SSL_do_handshake(ssl);
+    int ret;
+    {
+        HandshakeTimer::Step step(appData->handshakeTimer.get());
+        ret = SSL_do_handshake(ssl);
+    }
     appData->clearCallbackState();
     if (env->ExceptionCheck()) {
         // cert_verify_callback threw exception
@@ -11579,8 +13612,10 @@ static jint NativeCrypto_ENGINE_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_
 
     SslError sslError(ssl, ret);
     int code = sslError.get();
+    appData->stats.countError(code);
 
-    if (ret > 0 || code == SSL_ERROR_WANT_READ || code == SSL_ERROR_WANT_WRITE) {
+    if (ret > 0 || code == SSL_ERROR_WANT_READ || code == SSL_ERROR_WANT_WRITE ||
+        code == SSL_ERROR_WANT_CERTIFICATE_VERIFY || code == SSL_ERROR_PENDING_CERTIFICATE) {
         // Non-exceptional case.
         JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_do_handshake shc=%p => ret=%d", ssl, shc, code);
         return code;
@@ -11734,6 +13769,7 @@ static jint NativeCrypto_ENGINE_SSL_read_direct(JNIEnv* env, jclass, jlong ssl_a
     }
 
     SslError sslError(ssl, result);
+    appData->stats.countRead(result, sslError.get());
     switch (sslError.get()) {
         case SSL_ERROR_NONE: {
             // Successfully read at least one byte. Just return the result.
@@ -11744,7 +13780,9 @@ static jint NativeCrypto_ENGINE_SSL_read_direct(JNIEnv* env, jclass, jlong ssl_a
             return -SSL_ERROR_ZERO_RETURN;
         }
         case SSL_ERROR_WANT_READ:
-        case SSL_ERROR_WANT_WRITE: {
+        case SSL_ERROR_WANT_WRITE:
+        case SSL_ERROR_WANT_CERTIFICATE_VERIFY:
+        case SSL_ERROR_PENDING_CERTIFICATE: {
             // Return the negative of these values.
             result = -sslError.get();
             break;
@@ -11843,6 +13881,166 @@ static int NativeCrypto_ENGINE_SSL_write_BIO_direct(JNIEnv* env, jclass, jlong s
     return result;
 }
 
+/**
+ * Layout of the value returned by ENGINE_SSL_unwrap_direct; see
+ * NativeCrypto.UNWRAP_* on the Java side.
+ */
+static const jlong kUnwrapLengthMask = 0xFFFFFF;
+static const int kUnwrapProducedShift = 24;
+static const int kUnwrapErrorShift = 48;
+static const jlong kUnwrapPendingPlaintext = static_cast<jlong>(1) << 56;
+
+/**
+ * Fused engine unwrap: lends one packet of ciphertext to the network BIO and
+ * then reads plaintext into the destination buffers, one SSL_read per buffer,
+ * stopping at the first buffer that isn't filled completely. This replaces the
+ * separate ENGINE_SSL_write_BIO_direct, ENGINE_SSL_read_direct and
+ * SSL_pending_readable_bytes calls of the unwrap path.
+ *
+ * Returns the bytes consumed and produced, the SSL error that stopped the
+ * reads (SSL_ERROR_NONE if none did), and whether more plaintext is pending,
+ * packed as described by the kUnwrap constants. Errors that end the
+ * connection are thrown as exceptions, as in ENGINE_SSL_read_direct.
+ */
+static jlong NativeCrypto_ENGINE_SSL_unwrap_direct(JNIEnv* env, jclass, jlong ssl_address,
+                                                   CONSCRYPT_UNUSED jobject ssl_holder,
+                                                   jlong bioRef, jlong srcAddress, jint srcLength,
+                                                   jlongArray dstAddresses, jintArray dstLengths,
+                                                   jint dstCount, jobject shc) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    if (ssl == nullptr) {
+        return -1;
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct srcLength=%d dstCount=%d shc=%p", ssl,
+              srcLength, dstCount, shc);
+    if (shc == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE(
+                "ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct => sslHandshakeCallbacks "
+                "== null",
+                ssl);
+        return -1;
+    }
+    BIO* bio = to_BIO(env, bioRef);
+    if (bio == nullptr) {
+        return -1;
+    }
+    if (dstAddresses == nullptr || dstLengths == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env,
+                                                      "dstAddresses == null || dstLengths == null");
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct => null array", ssl);
+        return -1;
+    }
+    if (srcLength < 0 || srcLength > kUnwrapLengthMask || dstCount < 0 ||
+        dstCount > env->GetArrayLength(dstAddresses) ||
+        dstCount > env->GetArrayLength(dstLengths)) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "srcLength or dstCount");
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct => invalid length", ssl);
+        return -1;
+    }
+    std::vector<jlong> addresses(static_cast<size_t>(dstCount));
+    std::vector<jint> lengths(static_cast<size_t>(dstCount));
+    env->GetLongArrayRegion(dstAddresses, 0, dstCount, addresses.data());
+    env->GetIntArrayRegion(dstLengths, 0, dstCount, lengths.data());
+
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct => appData == null", ssl);
+        return -1;
+    }
+    if (!appData->setCallbackState(env, shc, nullptr)) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to set appdata callback");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct => exception", ssl);
+        return -1;
+    }
+
+    // Lend the ciphertext to the network BIO, so the SSL reads its records
+    // straight out of the caller's buffer. As in ENGINE_SSL_write_BIO_direct,
+    // nothing is consumed unless the whole packet fits, since whatever the
+    // reads below leave behind is copied into the BIO when the loan ends.
+    conscrypt::EngineBio* engineBio = conscrypt::EngineBio::from(bio);
+    jlong consumed = 0;
+    if (srcLength > 0 && engineBio->inboundSpace() >= static_cast<size_t>(srcLength)) {
+        JNI_TRACE_PACKET_DATA(ssl, 'O', reinterpret_cast<const char*>(srcAddress),
+                              static_cast<size_t>(srcLength));
+        engineBio->lendInput(reinterpret_cast<const uint8_t*>(srcAddress),
+                             static_cast<size_t>(srcLength));
+        consumed = srcLength;
+    }
+
+    jlong produced = 0;
+    int stopError = SSL_ERROR_NONE;
+    for (size_t i = 0; i < addresses.size(); i++) {
+        jint length = lengths[i];
+        if (length <= 0) {
+            continue;
+        }
+        if (length > SSL3_RT_MAX_PACKET_SIZE) {
+            length = SSL3_RT_MAX_PACKET_SIZE;
+        }
+        if (produced + length > kUnwrapLengthMask) {
+            break;
+        }
+        errno = 0;
+        int result = SSL_read(ssl, reinterpret_cast<char*>(addresses[i]), length);
+        if (env->ExceptionCheck()) {
+            // An exception was thrown by one of the callbacks. Just propagate that
+            // exception.
+            engineBio->returnInput();
+            appData->clearCallbackState();
+            ERR_clear_error();
+            JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct => THROWN_EXCEPTION", ssl);
+            return -1;
+        }
+        if (result > 0) {
+            produced += result;
+            appData->stats.countRead(result, SSL_ERROR_NONE);
+            if (result < lengths[i]) {
+                // The caller stops at the first buffer that isn't full.
+                break;
+            }
+            continue;
+        }
+
+        SslError sslError(ssl, result);
+        int code = sslError.get();
+        appData->stats.countError(code);
+        if (code == SSL_ERROR_ZERO_RETURN || code == SSL_ERROR_WANT_READ ||
+            code == SSL_ERROR_WANT_WRITE || code == SSL_ERROR_WANT_CERTIFICATE_VERIFY ||
+            code == SSL_ERROR_PENDING_CERTIFICATE ||
+            (code == SSL_ERROR_SYSCALL && result != 0 && errno == EINTR)) {
+            stopError = code;
+            break;
+        }
+        engineBio->returnInput();
+        appData->clearCallbackState();
+        if (code == SSL_ERROR_SYSCALL && result == 0) {
+            conscrypt::jniutil::throwException(env, "java/io/EOFException", "Read error");
+        } else {
+            conscrypt::jniutil::throwSSLExceptionWithSslErrors(env, ssl, sslError.release(),
+                                                               "Read error");
+        }
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct => exception", ssl);
+        return -1;
+    }
+    engineBio->returnInput();
+    appData->clearCallbackState();
+
+    jlong packed = consumed | (produced << kUnwrapProducedShift) |
+                   (static_cast<jlong>(stopError) << kUnwrapErrorShift);
+    if (SSL_pending(ssl) > 0) {
+        packed |= kUnwrapPendingPlaintext;
+    }
+    JNI_TRACE(
+            "ssl=%p NativeCrypto_ENGINE_SSL_unwrap_direct => consumed=%d produced=%d error=%d",
+            ssl, static_cast<int>(consumed), static_cast<int>(produced), stopError);
+    return packed;
+}
+
 static int NativeCrypto_ENGINE_SSL_read_BIO_direct(JNIEnv* env, jclass, jlong ssl_address,
                                                    CONSCRYPT_UNUSED jobject ssl_holder,
                                                    jlong bioRef, jlong address, jint outputSize,
@@ -11937,11 +14135,14 @@ static void NativeCrypto_ENGINE_SSL_force_read(JNIEnv* env, jclass, jlong ssl_ad
     }
 
     SslError sslError(ssl, result);
+    appData->stats.countError(sslError.get());
     switch (sslError.get()) {
         case SSL_ERROR_NONE:
         case SSL_ERROR_ZERO_RETURN:
         case SSL_ERROR_WANT_READ:
-        case SSL_ERROR_WANT_WRITE: {
+        case SSL_ERROR_WANT_WRITE:
+        case SSL_ERROR_WANT_CERTIFICATE_VERIFY:
+        case SSL_ERROR_PENDING_CERTIFICATE: {
             // The call succeeded, lacked data, or the SSL is closed.  All is well.
             break;
         }
@@ -12018,7 +14219,10 @@ static int NativeCrypto_ENGINE_SSL_write_direct(JNIEnv* env, jclass, jlong ssl_a
 
     errno = 0;
 
+    recordSizingBeforeWrite(ssl, appData);
     int result = SSL_write(ssl, sourcePtr, len);
+    recordSizingAfterWrite(appData, result);
+    appData->stats.countWrite(result);
     appData->clearCallbackState();
     JNI_TRACE(
             "ssl=%p NativeCrypto_ENGINE_SSL_write_direct address=%p length=%d shc=%p "
@@ -12027,6 +14231,242 @@ static int NativeCrypto_ENGINE_SSL_write_direct(JNIEnv* env, jclass, jlong ssl_a
     return result;
 }
 
+/**
+ * Gathering variant of ENGINE_SSL_write_direct: copies count address/length
+ * pairs into a single plaintext record and writes it with one SSL_write, so
+ * that many small buffers don't each produce a JNI call and a record of their
+ * own. The lengths must add up to at most SSL3_RT_MAX_PLAIN_LENGTH.
+ */
+static int NativeCrypto_ENGINE_SSL_write_direct_gather(JNIEnv* env, jclass, jlong ssl_address,
+                                                       CONSCRYPT_UNUSED jobject ssl_holder,
+                                                       jlongArray addresses, jintArray lengths,
+                                                       jint count, jobject shc) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    if (ssl == nullptr) {
+        return -1;
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_gather count=%d shc=%p", ssl, count,
+              shc);
+    if (shc == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE(
+                "ssl=%p NativeCrypto_ENGINE_SSL_write_direct_gather => sslHandshakeCallbacks "
+                "== null",
+                ssl);
+        return -1;
+    }
+    if (addresses == nullptr || lengths == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "addresses == null || lengths == null");
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_gather => null array", ssl);
+        return -1;
+    }
+    if (count < 0 || count > env->GetArrayLength(addresses) ||
+        count > env->GetArrayLength(lengths)) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "count");
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_gather => invalid count", ssl);
+        return -1;
+    }
+
+    std::vector<jlong> addressValues(static_cast<size_t>(count));
+    std::vector<jint> lengthValues(static_cast<size_t>(count));
+    env->GetLongArrayRegion(addresses, 0, count, addressValues.data());
+    env->GetIntArrayRegion(lengths, 0, count, lengthValues.data());
+
+    uint8_t record[SSL3_RT_MAX_PLAIN_LENGTH];
+    size_t total = 0;
+    for (size_t i = 0; i < addressValues.size(); i++) {
+        jint len = lengthValues[i];
+        if (len < 0 || static_cast<size_t>(len) > sizeof(record) - total) {
+            conscrypt::jniutil::throwIllegalArgumentException(env, "Invalid total length");
+            JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_gather => too long", ssl);
+            return -1;
+        }
+        memcpy(record + total, reinterpret_cast<const uint8_t*>(addressValues[i]),
+               static_cast<size_t>(len));
+        total += static_cast<size_t>(len);
+    }
+
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_gather appData => null", ssl);
+        return -1;
+    }
+    if (!appData->setCallbackState(env, shc, nullptr)) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to set appdata callback");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_gather => exception", ssl);
+        return -1;
+    }
+
+    errno = 0;
+
+    recordSizingBeforeWrite(ssl, appData);
+    int result = SSL_write(ssl, record, static_cast<int>(total));
+    recordSizingAfterWrite(appData, result);
+    appData->stats.countWrite(result);
+    appData->clearCallbackState();
+    JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_gather length=%zu shc=%p => ret=%d",
+              ssl, total, shc, result);
+    return result;
+}
+
+/**
+ * Fused engine wrap: lends the destination buffer to the network BIO and writes
+ * the count address/length pairs of plaintext as a single record, so the
+ * record is sealed straight into the destination rather than staged in the
+ * BIO. A single pair is written in place; several are gathered as in
+ * ENGINE_SSL_write_direct_gather. Anything that doesn't fit the destination,
+ * or that is queued behind earlier output, stays in the BIO for
+ * ENGINE_SSL_read_BIO_direct.
+ *
+ * Returns the bytes consumed and produced and the SSL error of a failed write,
+ * packed as for ENGINE_SSL_unwrap_direct.
+ */
+static jlong NativeCrypto_ENGINE_SSL_wrap_direct(JNIEnv* env, jclass, jlong ssl_address,
+                                                 CONSCRYPT_UNUSED jobject ssl_holder, jlong bioRef,
+                                                 jlongArray srcAddresses, jintArray srcLengths,
+                                                 jint srcCount, jlong dstAddress, jint dstLength,
+                                                 jobject shc) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    if (ssl == nullptr) {
+        return -1;
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct srcCount=%d dstLength=%d shc=%p", ssl,
+              srcCount, dstLength, shc);
+    if (shc == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE(
+                "ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct => sslHandshakeCallbacks "
+                "== null",
+                ssl);
+        return -1;
+    }
+    BIO* bio = to_BIO(env, bioRef);
+    if (bio == nullptr) {
+        return -1;
+    }
+    if (srcAddresses == nullptr || srcLengths == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env,
+                                                      "srcAddresses == null || srcLengths == null");
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct => null array", ssl);
+        return -1;
+    }
+    if (srcCount < 1 || srcCount > env->GetArrayLength(srcAddresses) ||
+        srcCount > env->GetArrayLength(srcLengths) || dstLength < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "srcCount or dstLength");
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct => invalid length", ssl);
+        return -1;
+    }
+
+    std::vector<jlong> addressValues(static_cast<size_t>(srcCount));
+    std::vector<jint> lengthValues(static_cast<size_t>(srcCount));
+    env->GetLongArrayRegion(srcAddresses, 0, srcCount, addressValues.data());
+    env->GetIntArrayRegion(srcLengths, 0, srcCount, lengthValues.data());
+
+    uint8_t record[SSL3_RT_MAX_PLAIN_LENGTH];
+    const uint8_t* plaintext = reinterpret_cast<const uint8_t*>(addressValues[0]);
+    size_t total = 0;
+    if (srcCount == 1) {
+        if (lengthValues[0] < 0 ||
+            static_cast<size_t>(lengthValues[0]) > SSL3_RT_MAX_PLAIN_LENGTH) {
+            conscrypt::jniutil::throwIllegalArgumentException(env, "Invalid total length");
+            JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct => too long", ssl);
+            return -1;
+        }
+        total = static_cast<size_t>(lengthValues[0]);
+    } else {
+        for (size_t i = 0; i < addressValues.size(); i++) {
+            jint len = lengthValues[i];
+            if (len < 0 || static_cast<size_t>(len) > sizeof(record) - total) {
+                conscrypt::jniutil::throwIllegalArgumentException(env, "Invalid total length");
+                JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct => too long", ssl);
+                return -1;
+            }
+            memcpy(record + total, reinterpret_cast<const uint8_t*>(addressValues[i]),
+                   static_cast<size_t>(len));
+            total += static_cast<size_t>(len);
+        }
+        plaintext = record;
+    }
+
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct appData => null", ssl);
+        return -1;
+    }
+    if (!appData->setCallbackState(env, shc, nullptr)) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to set appdata callback");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct => exception", ssl);
+        return -1;
+    }
+
+    conscrypt::EngineBio* engineBio = conscrypt::EngineBio::from(bio);
+    engineBio->lendOutput(reinterpret_cast<uint8_t*>(dstAddress),
+                          static_cast<size_t>(dstLength));
+    errno = 0;
+    recordSizingBeforeWrite(ssl, appData);
+    int result = SSL_write(ssl, plaintext, static_cast<int>(total));
+    recordSizingAfterWrite(appData, result);
+    appData->stats.countWrite(result);
+    jlong produced = static_cast<jlong>(engineBio->returnOutput());
+    appData->clearCallbackState();
+    if (env->ExceptionCheck()) {
+        // An exception was thrown by one of the callbacks. Just propagate that
+        // exception.
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct => THROWN_EXCEPTION", ssl);
+        return -1;
+    }
+    JNI_TRACE_PACKET_DATA(ssl, 'I', reinterpret_cast<const char*>(dstAddress),
+                          static_cast<size_t>(produced));
+
+    jlong consumed = 0;
+    int error = SSL_ERROR_NONE;
+    if (result > 0) {
+        consumed = result;
+    } else {
+        // The caller reports the error, so there's no use for the queue.
+        error = SSL_get_error(ssl, result);
+        appData->stats.countError(error);
+        ERR_clear_error();
+    }
+    JNI_TRACE(
+            "ssl=%p NativeCrypto_ENGINE_SSL_wrap_direct => consumed=%d produced=%d error=%d",
+            ssl, static_cast<int>(consumed), static_cast<int>(produced), error);
+    return consumed | (produced << kUnwrapProducedShift) |
+           (static_cast<jlong>(error) << kUnwrapErrorShift);
+}
+
+/**
+ * Returns the process-wide counters of conscrypt::memory_stats, in the order
+ * of memory_stats::Counter.
+ */
+static jlongArray NativeCrypto_get_native_memory_stats(JNIEnv* env, jclass) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("NativeCrypto_get_native_memory_stats");
+    namespace memory_stats = conscrypt::memory_stats;
+    jlong values[memory_stats::kCounterCount];
+    for (int i = 0; i < memory_stats::kCounterCount; i++) {
+        values[i] = memory_stats::get(static_cast<memory_stats::Counter>(i));
+    }
+    ScopedLocalRef<jlongArray> result(env, env->NewLongArray(memory_stats::kCounterCount));
+    if (result.get() == nullptr) {
+        JNI_TRACE("NativeCrypto_get_native_memory_stats => threw exception");
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result.get(), 0, memory_stats::kCounterCount, values);
+    return result.release();
+}
+
 /**
  * public static native bool usesBoringSsl_FIPS_mode();
  */
@@ -12275,6 +14715,7 @@ static void NativeCrypto_BIO_write(JNIEnv* env, jclass, jlong bioRef, jbyteArray
         JNI_TRACE("BIO_write(%p, %p, %d, %d) => IO error", bio, inputJavaBytes, offset, length);
         return;
     }
+    flush_written_bio(env, bio);
 
     JNI_TRACE("BIO_write(%p, %p, %d, %d) => success", bio, inputJavaBytes, offset, length);
 }
@@ -12338,7 +14779,11 @@ static jlong NativeCrypto_SSL_get1_session(JNIEnv* env, jclass, jlong ssl_addres
     if (ssl == nullptr) {
         return 0;
     }
-    return reinterpret_cast<uintptr_t>(SSL_get1_session(ssl));
+    SSL_SESSION* ssl_session = SSL_get1_session(ssl);
+    if (ssl_session != nullptr) {
+        conscrypt::memory_stats::add(conscrypt::memory_stats::kSslSession, 1);
+    }
+    return reinterpret_cast<uintptr_t>(ssl_session);
 }
 
 static void NativeCrypto_SSL_set_enable_ech_grease(JNIEnv* env, jclass, jlong ssl_address,
@@ -12569,6 +15014,10 @@ static jboolean NativeCrypto_SSL_CTX_ech_enable_server(JNIEnv* env, jclass, jlon
 #define REF_X509_REVOKED "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/OpenSSLX509CRLEntry;"
 #define REF_SSL "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeSsl;"
 #define REF_SSL_CTX "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/AbstractSessionContext;"
+#define REF_SSL_CREDENTIAL \
+    "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$SSL_CREDENTIAL;"
+#define REF_REVOCATION_INDEX \
+    "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$REVOCATION_INDEX;"
 static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(CMAC_CTX_new, "()J"),
         CONSCRYPT_NATIVE_METHOD(CMAC_CTX_free, "(J)V"),
@@ -12599,6 +15048,7 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(EVP_parse_public_key, "([B)J"),
         CONSCRYPT_NATIVE_METHOD(PEM_read_bio_PUBKEY, "(J)J"),
         CONSCRYPT_NATIVE_METHOD(PEM_read_bio_PrivateKey, "(J)J"),
+        CONSCRYPT_NATIVE_METHOD(PEM_read_all, "([BI)[J"),
         CONSCRYPT_NATIVE_METHOD(getRSAPrivateKeyWrapper, "(Ljava/security/PrivateKey;[B)J"),
         CONSCRYPT_NATIVE_METHOD(getECPrivateKeyWrapper,
                                 "(Ljava/security/PrivateKey;" REF_EC_GROUP ")J"),
@@ -12726,6 +15176,9 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(BIO_free_all, "(J)V"),
         CONSCRYPT_NATIVE_METHOD(d2i_X509_bio, "(J)J"),
         CONSCRYPT_NATIVE_METHOD(d2i_X509, "([B)J"),
+        CONSCRYPT_NATIVE_METHOD(d2i_X509_batch, "([B[I[I)[J"),
+        CONSCRYPT_NATIVE_METHOD(X509_parse_from_buffer, "(J)J"),
+        CONSCRYPT_NATIVE_METHOD(CRYPTO_BUFFER_free, "(J)V"),
         CONSCRYPT_NATIVE_METHOD(i2d_X509, "(J" REF_X509 ")[B"),
         CONSCRYPT_NATIVE_METHOD(i2d_X509_PUBKEY, "(J" REF_X509 ")[B"),
         CONSCRYPT_NATIVE_METHOD(PEM_read_bio_X509, "(J)J"),
@@ -12765,13 +15218,15 @@ static JNINativeMethod sNativeCryptoMethods[] = {
                                 "(JI" REF_X509_REVOKED ")[Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(get_X509_GENERAL_NAME_stack,
                                 "(J" REF_X509 "I)[[Ljava/lang/Object;"),
+        CONSCRYPT_NATIVE_METHOD(X509_matches_host, "(J" REF_X509 "Ljava/lang/String;I)Z"),
         CONSCRYPT_NATIVE_METHOD(X509_get_notBefore, "(J" REF_X509 ")J"),
         CONSCRYPT_NATIVE_METHOD(X509_get_notAfter, "(J" REF_X509 ")J"),
         CONSCRYPT_NATIVE_METHOD(X509_get_version, "(J" REF_X509 ")J"),
         CONSCRYPT_NATIVE_METHOD(X509_get_serialNumber, "(J" REF_X509 ")[B"),
         CONSCRYPT_NATIVE_METHOD(X509_verify, "(J" REF_X509 REF_EVP_PKEY ")V"),
         CONSCRYPT_NATIVE_METHOD(get_X509_tbs_cert, "(J" REF_X509 ")[B"),
-        CONSCRYPT_NATIVE_METHOD(get_X509_tbs_cert_without_ext,
+        CONSCRYPT_NATIVE_METHOD(get_X509_fields, "(J" REF_X509 ")[B"),
+            CONSCRYPT_NATIVE_METHOD(get_X509_tbs_cert_without_ext,
                                 "(J" REF_X509 "Ljava/lang/String;)[B"),
         CONSCRYPT_NATIVE_METHOD(get_X509_signature, "(J" REF_X509 ")[B"),
         CONSCRYPT_NATIVE_METHOD(get_X509_CRL_signature, "(J" REF_X509_CRL ")[B"),
@@ -12782,6 +15237,11 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(X509_CRL_get0_by_cert, "(J" REF_X509_CRL "J" REF_X509 ")J"),
         CONSCRYPT_NATIVE_METHOD(X509_CRL_get0_by_serial, "(J" REF_X509_CRL "[B)J"),
         CONSCRYPT_NATIVE_METHOD(X509_CRL_get_REVOKED, "(J" REF_X509_CRL ")[J"),
+        CONSCRYPT_NATIVE_METHOD(X509_REVOKED_get_revocationDates, "([J)[J"),
+        CONSCRYPT_NATIVE_METHOD(X509_CRL_revocation_index_new, "(J" REF_X509_CRL ")J"),
+        CONSCRYPT_NATIVE_METHOD(X509_CRL_revocation_index_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(X509_CRL_revocation_index_lookup,
+                                "(" REF_REVOCATION_INDEX "[B[I)[Z"),
         CONSCRYPT_NATIVE_METHOD(i2d_X509_CRL, "(J" REF_X509_CRL ")[B"),
         CONSCRYPT_NATIVE_METHOD(X509_CRL_free, "(J" REF_X509_CRL ")V"),
         CONSCRYPT_NATIVE_METHOD(X509_CRL_print, "(JJ" REF_X509_CRL ")V"),
@@ -12795,7 +15255,7 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(X509_REVOKED_free, "(J" REF_X509_REVOKED ")V"),
         CONSCRYPT_NATIVE_METHOD(i2d_X509_REVOKED, "(J" REF_X509_REVOKED ")[B"),
         CONSCRYPT_NATIVE_METHOD(X509_supported_extension, "(J)I"),
-        CONSCRYPT_NATIVE_METHOD(ASN1_TIME_to_Calendar, "(JLjava/util/Calendar;)V"),
+        CONSCRYPT_NATIVE_METHOD(ASN1_TIME_to_millis, "(J)J"),
         CONSCRYPT_NATIVE_METHOD(asn1_read_init, "([B)J"),
         CONSCRYPT_NATIVE_METHOD(asn1_read_sequence, "(J)J"),
         CONSCRYPT_NATIVE_METHOD(asn1_read_next_tag_is, "(JI)Z"),
@@ -12822,11 +15282,18 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(SSL_CTX_free, "(J" REF_SSL_CTX ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_session_id_context, "(J" REF_SSL_CTX "[B)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_timeout, "(J" REF_SSL_CTX "J)J"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CTX_enable_cert_compression, "(J" REF_SSL_CTX ")Z"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_verify_cache, "(J" REF_SSL_CTX "IJ)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CTX_clear_verify_cache, "(J" REF_SSL_CTX ")V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CTX_get_verify_cache_stats, "(J" REF_SSL_CTX ")[J"),
         CONSCRYPT_NATIVE_METHOD(SSL_new, "(J" REF_SSL_CTX ")J"),
         CONSCRYPT_NATIVE_METHOD(SSL_enable_tls_channel_id, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_tls_channel_id, "(J" REF_SSL ")[B"),
         CONSCRYPT_NATIVE_METHOD(SSL_set1_tls_channel_id, "(J" REF_SSL REF_EVP_PKEY ")V"),
-        CONSCRYPT_NATIVE_METHOD(setLocalCertsAndPrivateKey, "(J" REF_SSL "[[B" REF_EVP_PKEY ")V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CREDENTIAL_new_x509, "([[B" REF_EVP_PKEY ")J"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CREDENTIAL_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_add1_credential, "(J" REF_SSL REF_SSL_CREDENTIAL ")V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get_selected_credential, "(J" REF_SSL ")J"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_client_CA_list, "(J" REF_SSL "[[B)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_mode, "(J" REF_SSL "J)J"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_options, "(J" REF_SSL "J)J"),
@@ -12848,18 +15315,36 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(SSL_set_accept_state, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_connect_state, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_verify, "(J" REF_SSL "I)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_async_cert_verification, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get_pending_cipher_auth_method,
+                                "(J" REF_SSL ")Ljava/lang/String;"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_cert_verify_result, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_async_cert_selection, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_cert_selection_result, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_dynamic_record_sizing, "(J" REF_SSL "IJJJ)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_shed_handshake_config, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get_native_footprint, "(J" REF_SSL ")J"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_handshake_timing, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get_handshake_timings, "(J" REF_SSL ")[J"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get_connection_stats, "(J" REF_SSL ")[J"),
+        CONSCRYPT_NATIVE_METHOD(SSL_enable_ktls, "(J" REF_SSL FILE_DESCRIPTOR ")I"),
+        CONSCRYPT_NATIVE_METHOD(pread, "(" FILE_DESCRIPTOR "[BIIJ)I"),
+        CONSCRYPT_NATIVE_METHOD(SSL_sendfile,
+                                "(J" REF_SSL FILE_DESCRIPTOR FILE_DESCRIPTOR "JJI)J"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_session, "(J" REF_SSL "J)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_session_creation_enabled, "(J" REF_SSL "Z)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_session_reused, "(J" REF_SSL ")Z"),
         CONSCRYPT_NATIVE_METHOD(SSL_accept_renegotiations, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_tlsext_host_name, "(J" REF_SSL "Ljava/lang/String;)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_servername, "(J" REF_SSL ")Ljava/lang/String;"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_verify_cache_scope, "(J" REF_SSL "Ljava/lang/String;)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_do_handshake, "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS "I)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_current_cipher, "(J" REF_SSL ")Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(SSL_set1_groups, "(J" REF_SSL "[I)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_curve_name, "(J" REF_SSL ")Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_version, "(J" REF_SSL ")Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(SSL_get0_peer_certificates, "(J" REF_SSL ")[[B"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get0_peer_certificate_refs, "(J" REF_SSL ")[J"),
         CONSCRYPT_NATIVE_METHOD(SSL_read, "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS "[BIII)I"),
         CONSCRYPT_NATIVE_METHOD(SSL_write, "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS "[BIII)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_interrupt, "(J" REF_SSL ")V"),
@@ -12898,10 +15383,17 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_do_handshake, "(J" REF_SSL SSL_CALLBACKS ")I"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_read_direct, "(J" REF_SSL "JI" SSL_CALLBACKS ")I"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_write_direct, "(J" REF_SSL "JI" SSL_CALLBACKS ")I"),
+        CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_unwrap_direct,
+                                "(J" REF_SSL "JJI[J[II" SSL_CALLBACKS ")J"),
+        CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_write_direct_gather,
+                                "(J" REF_SSL "[J[II" SSL_CALLBACKS ")I"),
+        CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_wrap_direct,
+                                "(J" REF_SSL "J[J[IIJI" SSL_CALLBACKS ")J"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_write_BIO_direct, "(J" REF_SSL "JJI" SSL_CALLBACKS ")I"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_read_BIO_direct, "(J" REF_SSL "JJI" SSL_CALLBACKS ")I"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_force_read, "(J" REF_SSL SSL_CALLBACKS ")V"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_shutdown, "(J" REF_SSL SSL_CALLBACKS ")V"),
+        CONSCRYPT_NATIVE_METHOD(get_native_memory_stats, "()[J"),
         CONSCRYPT_NATIVE_METHOD(usesBoringSsl_FIPS_mode, "()Z"),
         CONSCRYPT_NATIVE_METHOD(Scrypt_generate_key, "([B[BIIII)[B"),
         CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_spake_credential, "([B[B[B[BZIJ" REF_SSL_CTX ")V"),
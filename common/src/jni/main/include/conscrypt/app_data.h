@@ -19,14 +19,20 @@
 
 #include <conscrypt/NetFd.h>
 #include <conscrypt/compat.h>
+#include <conscrypt/connection_stats.h>
+#include <conscrypt/handshake_timer.h>
 #include <conscrypt/jniutil.h>
+#include <conscrypt/memory_stats.h>
 #include <conscrypt/netutil.h>
 #include <conscrypt/trace.h>
 #include <jni.h>
+#include <openssl/ssl.h>
 
 #include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
+#include <string>
 
 #ifdef _WIN32
 // Needed for inet_ntop
@@ -40,10 +46,16 @@
 #include <arpa/inet.h>
 #include <poll.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#define CONSCRYPT_HAVE_EVENTFD 1
+#endif
 #endif  // !_WIN32
 
 namespace conscrypt {
 
+class EngineBio;
+
 /**
  * Our additional application data needed for getting synchronization right.
  * This maybe warrants a bit of lengthy prose:
@@ -56,7 +68,7 @@ namespace conscrypt {
  * the Java layer ensures that no more threads will enter the native code at the
  * same time.
  *
- * (3) The pipe is used primarily as a means of cancelling a blocking select()
+ * (3) The wakeup descriptor is used primarily as a means of cancelling a blocking select()
  * when we want to close the connection (aka "emergency button"). It is also
  * necessary for dealing with a possible race condition situation: There might
  * be cases where both threads see an SSL_ERROR_WANT_READ or
@@ -67,14 +79,16 @@ namespace conscrypt {
  *
  * The idea for solving the problem looks like this: Whenever a thread is
  * successful in moving around data on the network, and it knows there is
- * another thread stuck in a select(), it will write a byte to the pipe, waking
- * up the other thread. A thread that returned from select(), on the other hand,
- * knows whether it's been woken up by the pipe. If so, it will consume the
- * byte, and the original state of affairs has been restored.
+ * another thread stuck in a select(), it will signal the wakeup descriptor,
+ * waking up the other thread. A thread that returned from select(), on the
+ * other hand, knows whether it's been woken up by the descriptor. If so, it will
+ * consume the signal, and the original state of affairs has been restored.
  *
- * The pipe may seem like a bit of overhead, but it fits in nicely with the
- * other file descriptors of the select(), so there's only one condition to wait
- * for.
+ * The descriptor is an eventfd where available and a pipe elsewhere. It is only
+ * created the first time a thread actually blocks in select(), so connections
+ * that never wait on a socket (e.g. SSLEngine) don't pay for it. Signals are
+ * coalesced through wakeupPending: while one is outstanding, further
+ * notifications don't touch the descriptor.
  *
  * (4) Finally, a mutex is needed to make sure that at most one thread is in
  * either SSL_read() or SSL_write() at any given time. This is an OpenSSL
@@ -97,6 +111,15 @@ namespace conscrypt {
  * array data so the callback doesn't need to acquire resources that it cannot
  * release.
  *
+ * When asynchronous certificate verification or selection is enabled,
+ * certVerifyState and certSelectState track the work that the Java layer
+ * performs off the handshake thread. They are atomic because the result is
+ * posted from another thread.
+ *
+ * Once the kernel has taken over the record layer of a socket (kTLS), ktlsRx
+ * and ktlsTx make sslRead() and sslWrite() bypass BoringSSL for the
+ * respective direction.
+ *
  * Because renegotiation can be requested by the peer at any time,
  * care should be taken to maintain an appropriate JNIEnv on any
  * downcall to openssl since it could result in an upcall to Java. The
@@ -106,12 +129,21 @@ namespace conscrypt {
  */
 class AppData {
 public:
+    enum AsyncState {
+        ASYNC_NONE,
+        ASYNC_PENDING,
+        ASYNC_OK,
+        ASYNC_FAILED,
+    };
+
     std::atomic<bool> aliveAndKicking;
     int waitingThreads;
 #ifdef _WIN32
     HANDLE interruptEvent;
 #else
-    int fdsEmergency[2];
+    std::atomic<int> wakeupFd;
+    int wakeupWriteFd;
+    std::atomic<bool> wakeupPending;
 #endif
     std::mutex mutex;
     JNIEnv* env;
@@ -119,6 +151,42 @@ public:
     char* applicationProtocolsData;
     size_t applicationProtocolsLength;
     bool hasApplicationProtocolSelector;
+    bool asyncCertVerification;
+    std::atomic<int> certVerifyState;
+    bool asyncCertSelection;
+    std::atomic<int> certSelectState;
+    bool ktlsRx;
+    bool ktlsTx;
+    // Dynamic record sizing, disabled while recordSizeSmall is 0. See
+    // NativeCrypto_SSL_set_dynamic_record_sizing.
+    uint16_t recordSizeSmall;
+    uint16_t recordSizeCurrent;
+    uint64_t recordSizeBoostBytes;
+    int64_t recordSizeBoostMillis;
+    int64_t recordSizeIdleMillis;
+    uint64_t recordSizeWritten;
+    std::chrono::steady_clock::time_point recordSizeFirstWrite;
+    std::chrono::steady_clock::time_point recordSizeLastWrite;
+    // Set by SSL_set_shed_handshake_config; handshakeConfigShed once the
+    // handshake-only state has actually been released.
+    bool shedHandshakeConfig;
+    bool handshakeConfigShed;
+    // The engine BIO of SSLEngine connections, owned by the SSL's BIOs.
+    EngineBio* engineBio;
+    // Set while handshake timings are recorded. See
+    // NativeCrypto_SSL_set_handshake_timing.
+    std::unique_ptr<HandshakeTimer> handshakeTimer;
+    // Traffic counters, returned by NativeCrypto_SSL_get_connection_stats.
+    ConnectionStats stats;
+    // The credential chosen by the last completed handshake. The reference
+    // keeps its address from being reused by another credential while it is
+    // reported as the selected one.
+    bssl::UniquePtr<SSL_CREDENTIAL> selectedCredential;
+    // Set by SSL_set_verify_cache_scope when verifications of this connection
+    // may be cached in the VerifyCache of its SSL_CTX, with the scope they are
+    // valid in.
+    bool verifyCacheEnabled;
+    std::string verifyCacheScope;
 
     /**
      * Creates the application data context for the SSL*.
@@ -132,15 +200,6 @@ public:
             return nullptr;
         }
         appData.get()->interruptEvent = interruptEvent;
-#else
-        if (pipe(appData.get()->fdsEmergency) == -1) {
-            CONSCRYPT_LOG_ERROR("AppData::create pipe(2) failed: %s", strerror(errno));
-            return nullptr;
-        }
-        if (!netutil::setBlocking(appData.get()->fdsEmergency[0], false)) {
-            CONSCRYPT_LOG_ERROR("AppData::create fcntl(2) failed: %s", strerror(errno));
-            return nullptr;
-        }
 #endif
         return appData.release();
     }
@@ -152,15 +211,57 @@ public:
             CloseHandle(interruptEvent);
         }
 #else
-        if (fdsEmergency[0] != -1) {
-            close(fdsEmergency[0]);
+        int fd = wakeupFd;
+        if (fd != -1) {
+            close(fd);
         }
-        if (fdsEmergency[1] != -1) {
-            close(fdsEmergency[1]);
+        if (wakeupWriteFd != -1 && wakeupWriteFd != fd) {
+            close(wakeupWriteFd);
         }
 #endif
         clearApplicationProtocols();
         clearCallbackState();
+        setHandshakeTiming(false);
+        memory_stats::add(memory_stats::kAppData, -1);
+        memory_stats::add(memory_stats::kAppDataBytes, -static_cast<int64_t>(sizeof(AppData)));
+    }
+
+    /**
+     * Returns the number of bytes of native memory held by this object,
+     * including the copied ALPN protocol list.
+     */
+    size_t footprint() const {
+        size_t bytes = sizeof(AppData);
+        if (applicationProtocolsData != nullptr) {
+            bytes += applicationProtocolsLength;
+        }
+        if (handshakeTimer) {
+            bytes += sizeof(HandshakeTimer);
+        }
+        return bytes;
+    }
+
+    /**
+     * Starts or stops recording the timings of handshakes. Stopping discards
+     * what has been recorded.
+     */
+    void setHandshakeTiming(bool enabled) {
+        if (enabled && !handshakeTimer) {
+            handshakeTimer.reset(new HandshakeTimer());
+            memory_stats::add(memory_stats::kAppDataBytes,
+                              static_cast<int64_t>(sizeof(HandshakeTimer)));
+        } else if (!enabled && handshakeTimer) {
+            handshakeTimer.reset();
+            memory_stats::add(memory_stats::kAppDataBytes,
+                              -static_cast<int64_t>(sizeof(HandshakeTimer)));
+        }
+    }
+
+    /**
+     * Frees the state that is only needed during the handshake.
+     */
+    void shedHandshakeState() {
+        clearApplicationProtocols();
     }
 
     /**
@@ -188,6 +289,8 @@ public:
             applicationProtocolsLength =
                     static_cast<size_t>(e->GetArrayLength(applicationProtocolsJava));
             applicationProtocolsData = new char[applicationProtocolsLength];
+            memory_stats::add(memory_stats::kAppDataBytes,
+                              static_cast<int64_t>(applicationProtocolsLength));
             memcpy(applicationProtocolsData, applicationProtocols, applicationProtocolsLength);
             e->ReleaseByteArrayElements(applicationProtocolsJava, applicationProtocols, JNI_ABORT);
         }
@@ -222,6 +325,91 @@ public:
         env = nullptr;
     }
 
+#ifndef _WIN32
+    /**
+     * Creates the wakeup descriptor if this is the first time a thread is about
+     * to block on the socket. Must be called with the mutex held.
+     */
+    bool ensureWakeupFd() {
+        if (wakeupFd != -1) {
+            return true;
+        }
+#ifdef CONSCRYPT_HAVE_EVENTFD
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd == -1) {
+            CONSCRYPT_LOG_ERROR("AppData::ensureWakeupFd eventfd(2) failed: %s",
+                                strerror(errno));
+            return false;
+        }
+        wakeupWriteFd = fd;
+#else
+        int fds[2];
+        if (pipe(fds) == -1) {
+            CONSCRYPT_LOG_ERROR("AppData::ensureWakeupFd pipe(2) failed: %s", strerror(errno));
+            return false;
+        }
+        if (!netutil::setBlocking(fds[0], false) || !netutil::setBlocking(fds[1], false)) {
+            CONSCRYPT_LOG_ERROR("AppData::ensureWakeupFd fcntl(2) failed: %s", strerror(errno));
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        wakeupWriteFd = fds[1];
+        int fd = fds[0];
+#endif
+        wakeupFd = fd;
+        // A notification that arrived before the descriptor existed must not
+        // be lost.
+        if (wakeupPending) {
+            signalWakeupFd();
+        }
+        return true;
+    }
+
+    /**
+     * Wakes up a thread blocked in select(). Repeated calls are coalesced until
+     * the signal is consumed with consumeWakeup.
+     */
+    void notifyWakeup() {
+        if (wakeupPending.exchange(true)) {
+            return;
+        }
+        if (wakeupFd != -1) {
+            signalWakeupFd();
+        }
+    }
+
+    /**
+     * Consumes an outstanding wakeup signal. Must be called with the mutex held.
+     */
+    void consumeWakeup() {
+        wakeupPending = false;
+        char buf[8];
+        for (;;) {
+            ssize_t n = read(wakeupFd, buf, sizeof(buf));
+            if (n > 0 || (n == -1 && errno == EINTR)) {
+                continue;
+            }
+            break;
+        }
+    }
+
+    /**
+     * Writes to the wakeup descriptor unconditionally, bypassing coalescing.
+     */
+    void signalWakeupFd() {
+#ifdef CONSCRYPT_HAVE_EVENTFD
+        uint64_t token = 1;
+#else
+        char token = '*';
+#endif
+        ssize_t n;
+        do {
+            n = write(wakeupWriteFd, &token, sizeof(token));
+        } while (n == -1 && errno == EINTR);
+    }
+#endif  // !_WIN32
+
 private:
     AppData()
         : aliveAndKicking(true),
@@ -230,18 +418,39 @@ private:
           sslHandshakeCallbacks(nullptr),
           applicationProtocolsData(nullptr),
           applicationProtocolsLength(static_cast<size_t>(-1)),
-          hasApplicationProtocolSelector(false) {
+          hasApplicationProtocolSelector(false),
+          asyncCertVerification(false),
+          certVerifyState(ASYNC_NONE),
+          asyncCertSelection(false),
+          certSelectState(ASYNC_NONE),
+          ktlsRx(false),
+          ktlsTx(false),
+          recordSizeSmall(0),
+          recordSizeCurrent(0),
+          recordSizeBoostBytes(0),
+          recordSizeBoostMillis(0),
+          recordSizeIdleMillis(0),
+          recordSizeWritten(0),
+          shedHandshakeConfig(false),
+          handshakeConfigShed(false),
+          engineBio(nullptr),
+          verifyCacheEnabled(false) {
 #ifdef _WIN32
         interruptEvent = nullptr;
 #else
-        fdsEmergency[0] = -1;
-        fdsEmergency[1] = -1;
+        wakeupFd = -1;
+        wakeupWriteFd = -1;
+        wakeupPending = false;
 #endif
+        memory_stats::add(memory_stats::kAppData, 1);
+        memory_stats::add(memory_stats::kAppDataBytes, static_cast<int64_t>(sizeof(AppData)));
     }
 
     void clearApplicationProtocols() {
         if (applicationProtocolsData != nullptr) {
             delete[] applicationProtocolsData;
+            memory_stats::add(memory_stats::kAppDataBytes,
+                              -static_cast<int64_t>(applicationProtocolsLength));
             applicationProtocolsData = nullptr;
             applicationProtocolsLength = static_cast<size_t>(-1);
         }
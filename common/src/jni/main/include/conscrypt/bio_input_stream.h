@@ -22,6 +22,8 @@
 #include <nativehelper/scoped_local_ref.h>
 #include <openssl/ssl.h>
 
+#include <algorithm>
+
 namespace conscrypt {
 
 class BioInputStream : public BioStream {
@@ -29,15 +31,60 @@ public:
     BioInputStream(jobject stream, bool isFinite) : BioStream(stream), isFinite_(isFinite) {}
 
     int read(char* buf, int len) {
-        return read_internal(buf, len, jniutil::inputStream_readMethod);
+        JNIEnv* env = jniutil::getJNIEnv();
+        if (!checkEnv(env)) {
+            return -1;
+        }
+
+        jbyteArray javaBytes = mBuffer.get(env, kBufferSize);
+        if (javaBytes == nullptr) {
+            JNI_TRACE("BioInputStream::read failed call to NewByteArray");
+            return -1;
+        }
+
+        // OpenSSLBIOInputStream fills each chunk unless it reaches EOF, so a
+        // short chunk ends the read.
+        int total = 0;
+        while (total < len) {
+            jint chunk = std::min(len - total, static_cast<int>(kBufferSize));
+            jint read = env->CallIntMethod(getStream(), jniutil::inputStream_readRangeMethod,
+                                           javaBytes, 0, chunk);
+            read = copyRead(env, javaBytes, read, buf + total);
+            if (read < 0) {
+                return -1;
+            }
+            total += read;
+            if (read < chunk) {
+                break;
+            }
+        }
+        return total;
     }
 
     int gets(char* buf, int len) {
+        JNIEnv* env = jniutil::getJNIEnv();
+        if (!checkEnv(env)) {
+            return -1;
+        }
+
         if (len > PEM_LINE_LENGTH) {
             len = PEM_LINE_LENGTH;
         }
 
-        int read = read_internal(buf, len - 1, jniutil::openSslInputStream_readLineMethod);
+        // OpenSSLBIOInputStream#gets reads up to the length of the array, so
+        // the array must be exactly as long as the request.
+        jbyteArray javaBytes = mLineBuffer.get(env, len - 1);
+        if (javaBytes == nullptr) {
+            JNI_TRACE("BioInputStream::gets failed call to NewByteArray");
+            return -1;
+        }
+
+        jint read = env->CallIntMethod(getStream(), jniutil::openSslInputStream_readLineMethod,
+                                       javaBytes);
+        read = copyRead(env, javaBytes, read, buf);
+        if (read < 0) {
+            return -1;
+        }
         buf[read] = '\0';
         JNI_TRACE("BIO::gets \"%s\"", buf);
         return read;
@@ -49,26 +96,25 @@ public:
 
 private:
     const bool isFinite_;
+    ReusableByteArray mBuffer;
+    ReusableByteArray mLineBuffer;
 
-    int read_internal(char* buf, int len, jmethodID method) {
-        JNIEnv* env = jniutil::getJNIEnv();
+    static bool checkEnv(JNIEnv* env) {
         if (env == nullptr) {
             JNI_TRACE("BioInputStream::read could not get JNIEnv");
-            return -1;
+            return false;
         }
 
         if (env->ExceptionCheck()) {
             JNI_TRACE("BioInputStream::read called with pending exception");
-            return -1;
-        }
-
-        ScopedLocalRef<jbyteArray> javaBytes(env, env->NewByteArray(len));
-        if (javaBytes.get() == nullptr) {
-            JNI_TRACE("BioInputStream::read failed call to NewByteArray");
-            return -1;
+            return false;
         }
+        return true;
+    }
 
-        jint read = env->CallIntMethod(getStream(), method, javaBytes.get());
+    // Copies the result of a call that read into javaBytes to buf. Returns the
+    // number of bytes copied, 0 at EOF, or -1 if the call threw.
+    int copyRead(JNIEnv* env, jbyteArray javaBytes, jint read, char* buf) {
         if (env->ExceptionCheck()) {
             JNI_TRACE("BioInputStream::read failed call to InputStream#read");
             return -1;
@@ -79,7 +125,7 @@ private:
             setEof(true);
             read = 0;
         } else if (read > 0) {
-            env->GetByteArrayRegion(javaBytes.get(), 0, read, reinterpret_cast<jbyte*>(buf));
+            env->GetByteArrayRegion(javaBytes, 0, read, reinterpret_cast<jbyte*>(buf));
         }
 
         return read;
@@ -20,11 +20,24 @@
 #include <conscrypt/bio_stream.h>
 #include <jni.h>
 
+#include <algorithm>
+
 namespace conscrypt {
 
+/**
+ * BIO for OutputStream. Writes are gathered in a Java array and handed to the
+ * stream in one call when the array fills or the BIO is flushed, as printing a
+ * certificate takes hundreds of small writes. Callers must BIO_flush before
+ * returning to Java; anything still pending when the BIO is freed is written
+ * then.
+ */
 class BioOutputStream : public BioStream {
 public:
-    explicit BioOutputStream(jobject stream) : BioStream(stream) {}
+    explicit BioOutputStream(jobject stream) : BioStream(stream), mPending(0) {}
+
+    ~BioOutputStream() override {
+        writePending();
+    }
 
     int write(const char* buf, int len) {
         JNIEnv* env = jniutil::getJNIEnv();
@@ -38,21 +51,59 @@ public:
             return -1;
         }
 
-        ScopedLocalRef<jbyteArray> javaBytes(env, env->NewByteArray(len));
-        if (javaBytes.get() == nullptr) {
+        jbyteArray javaBytes = mBuffer.get(env, kBufferSize);
+        if (javaBytes == nullptr) {
             JNI_TRACE("BioOutputStream::write => failed call to NewByteArray");
             return -1;
         }
 
-        env->SetByteArrayRegion(javaBytes.get(), 0, len, reinterpret_cast<const jbyte*>(buf));
+        int written = 0;
+        while (written < len) {
+            jsize chunk = std::min(len - written, static_cast<int>(kBufferSize - mPending));
+            env->SetByteArrayRegion(javaBytes, mPending, chunk,
+                                    reinterpret_cast<const jbyte*>(buf + written));
+            mPending += chunk;
+            written += chunk;
+            if (mPending == kBufferSize && !writePending()) {
+                return -1;
+            }
+        }
+
+        return len;
+    }
 
-        env->CallVoidMethod(getStream(), jniutil::outputStream_writeMethod, javaBytes.get());
-        if (env->ExceptionCheck()) {
-            JNI_TRACE("BioOutputStream::write => failed call to OutputStream#write");
+    int flush() override {
+        if (!writePending()) {
             return -1;
         }
+        return BioStream::flush();
+    }
 
-        return len;
+private:
+    ReusableByteArray mBuffer;
+    jsize mPending;
+
+    // Hands the gathered bytes to the stream. Returns false if that threw.
+    bool writePending() {
+        if (mPending == 0) {
+            return true;
+        }
+
+        JNIEnv* env = jniutil::getJNIEnv();
+        if (env == nullptr || env->ExceptionCheck()) {
+            JNI_TRACE("BioOutputStream::writePending => called with pending exception");
+            return false;
+        }
+
+        jsize pending = mPending;
+        mPending = 0;
+        env->CallVoidMethod(getStream(), jniutil::outputStream_writeRangeMethod,
+                            mBuffer.get(env, kBufferSize), 0, pending);
+        if (env->ExceptionCheck()) {
+            JNI_TRACE("BioOutputStream::writePending => failed call to OutputStream#write");
+            return false;
+        }
+        return true;
     }
 };
 
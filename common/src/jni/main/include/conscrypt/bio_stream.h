@@ -20,9 +20,57 @@
 #include <conscrypt/jniutil.h>
 #include <conscrypt/trace.h>
 #include <jni.h>
+#include <nativehelper/scoped_local_ref.h>
 
 namespace conscrypt {
 
+/**
+ * A Java byte array held as a global reference, so that a stream can hand the
+ * same array to Java on every call instead of allocating a new one.
+ */
+class ReusableByteArray {
+public:
+    ReusableByteArray() : mArray(nullptr), mSize(0) {}
+
+    ~ReusableByteArray() {
+        if (mArray != nullptr) {
+            JNIEnv* env = jniutil::getJNIEnv();
+            env->DeleteGlobalRef(mArray);
+        }
+    }
+
+    /**
+     * Returns an array of exactly size bytes, reusing the previous one if it
+     * has that size, or nullptr with an exception pending.
+     */
+    jbyteArray get(JNIEnv* env, jsize size) {
+        if (mArray != nullptr && mSize == size) {
+            return mArray;
+        }
+        if (mArray != nullptr) {
+            env->DeleteGlobalRef(mArray);
+            mArray = nullptr;
+        }
+        ScopedLocalRef<jbyteArray> array(env, env->NewByteArray(size));
+        if (array.get() == nullptr) {
+            return nullptr;
+        }
+        mArray = reinterpret_cast<jbyteArray>(env->NewGlobalRef(array.get()));
+        if (mArray == nullptr) {
+            return nullptr;
+        }
+        mSize = size;
+        return mArray;
+    }
+
+private:
+    jbyteArray mArray;
+    jsize mSize;
+
+    ReusableByteArray(const ReusableByteArray&) = delete;
+    ReusableByteArray& operator=(const ReusableByteArray&) = delete;
+};
+
 /**
  * BIO for InputStream
  */
@@ -33,7 +81,7 @@ public:
         mStream = env->NewGlobalRef(stream);
     }
 
-    ~BioStream() {
+    virtual ~BioStream() {
         JNIEnv* env = jniutil::getJNIEnv();
 
         env->DeleteGlobalRef(mStream);
@@ -44,7 +92,7 @@ public:
         return mEof;
     }
 
-    int flush() {
+    virtual int flush() {
         JNIEnv* env = jniutil::getJNIEnv();
         if (env == nullptr) {
             return -1;
@@ -64,6 +112,9 @@ public:
     }
 
 protected:
+    /** Size of the array used to move bytes between the BIO and the stream. */
+    static const jsize kBufferSize = 8192;
+
     jobject getStream() {
         return mStream;
     }
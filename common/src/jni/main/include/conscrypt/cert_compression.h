@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_CERT_COMPRESSION_H_
+#define CONSCRYPT_CERT_COMPRESSION_H_
+
+#include <conscrypt/macros.h>
+#include <conscrypt/trace.h>
+#include <openssl/bytestring.h>
+#include <openssl/pool.h>
+#include <openssl/ssl.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string_view>
+#include <vector>
+
+// zlib ships with Linux, macOS and Android, and the builds for those link
+// against it. Elsewhere certificate compression is not available.
+#if !defined(_WIN32) && defined(__has_include)
+#if __has_include(<zlib.h>)
+#include <zlib.h>
+#define CONSCRYPT_ZLIB 1
+#endif
+#endif
+
+namespace conscrypt {
+namespace cert_compression {
+
+#if CONSCRYPT_ZLIB
+
+/**
+ * Remembers the compressed form of the last few Certificate messages, so that
+ * a server sending the same chain on every handshake compresses it once
+ * rather than on every handshake. Shared by all contexts; entries are keyed
+ * by the full uncompressed message.
+ */
+class Cache {
+public:
+    static Cache& instance() {
+        static Cache* cache = new Cache();
+        return *cache;
+    }
+
+    /**
+     * Appends the compressed form of in to out if it is cached, returning
+     * whether it was.
+     */
+    bool lookup(const uint8_t* in, size_t inLen, CBB* out) {
+        size_t hash = hashOf(in, inLen);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Entry& entry : entries_) {
+            if (entry.hash == hash && entry.input.size() == inLen &&
+                memcmp(entry.input.data(), in, inLen) == 0) {
+                return CBB_add_bytes(out, entry.compressed.data(), entry.compressed.size());
+            }
+        }
+        return false;
+    }
+
+    void insert(const uint8_t* in, size_t inLen, const uint8_t* compressed,
+                size_t compressedLen) {
+        Entry entry;
+        entry.hash = hashOf(in, inLen);
+        entry.input.assign(in, in + inLen);
+        entry.compressed.assign(compressed, compressed + compressedLen);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.size() < kMaxEntries) {
+            entries_.push_back(std::move(entry));
+        } else {
+            entries_[next_] = std::move(entry);
+            next_ = (next_ + 1) % kMaxEntries;
+        }
+    }
+
+private:
+    static constexpr size_t kMaxEntries = 16;
+
+    struct Entry {
+        size_t hash;
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> compressed;
+    };
+
+    static size_t hashOf(const uint8_t* in, size_t inLen) {
+        return std::hash<std::string_view>()(
+                std::string_view(reinterpret_cast<const char*>(in), inLen));
+    }
+
+    std::mutex mutex_;
+    std::vector<Entry> entries_;
+    size_t next_ = 0;
+};
+
+inline int zlibCompress(SSL* ssl, CBB* out, const uint8_t* in, size_t inLen) {
+    Cache& cache = Cache::instance();
+    if (cache.lookup(in, inLen, out)) {
+        JNI_TRACE("ssl=%p zlibCompress => cached", ssl);
+        return 1;
+    }
+    uLongf compressedLen = compressBound(static_cast<uLong>(inLen));
+    uint8_t* compressed;
+    if (!CBB_reserve(out, &compressed, compressedLen)) {
+        return 0;
+    }
+    if (compress2(compressed, &compressedLen, in, static_cast<uLong>(inLen),
+                  Z_BEST_COMPRESSION) != Z_OK ||
+        !CBB_did_write(out, compressedLen)) {
+        JNI_TRACE("ssl=%p zlibCompress => error", ssl);
+        return 0;
+    }
+    cache.insert(in, inLen, compressed, compressedLen);
+    JNI_TRACE("ssl=%p zlibCompress %zu => %zu", ssl, inLen, static_cast<size_t>(compressedLen));
+    return 1;
+}
+
+inline int zlibDecompress(SSL* ssl, CRYPTO_BUFFER** out, size_t uncompressedLen,
+                          const uint8_t* in, size_t inLen) {
+    uint8_t* data;
+    bssl::UniquePtr<CRYPTO_BUFFER> buffer(CRYPTO_BUFFER_alloc(&data, uncompressedLen));
+    if (!buffer) {
+        return 0;
+    }
+    uLongf decompressedLen = static_cast<uLongf>(uncompressedLen);
+    if (uncompress(data, &decompressedLen, in, static_cast<uLong>(inLen)) != Z_OK ||
+        decompressedLen != uncompressedLen) {
+        JNI_TRACE("ssl=%p zlibDecompress => error", ssl);
+        return 0;
+    }
+    *out = buffer.release();
+    return 1;
+}
+
+#endif  // CONSCRYPT_ZLIB
+
+/**
+ * Offers and accepts compressed certificates (RFC 8879) on connections of
+ * ctx. Returns false if no compression algorithm is available in this build.
+ */
+inline bool enable(CONSCRYPT_UNUSED SSL_CTX* ctx) {
+#if CONSCRYPT_ZLIB
+    return SSL_CTX_add_cert_compression_alg(ctx, TLSEXT_cert_compression_zlib, zlibCompress,
+                                            zlibDecompress) == 1;
+#else
+    return false;
+#endif
+}
+
+}  // namespace cert_compression
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_CERT_COMPRESSION_H_
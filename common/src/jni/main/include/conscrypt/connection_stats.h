@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_CONNECTION_STATS_H_
+#define CONSCRYPT_CONNECTION_STATS_H_
+
+#include <openssl/ssl.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+
+namespace conscrypt {
+
+/**
+ * Counters describing the traffic of a single connection, kept so that chatty
+ * or stalled connections can be found without a JNI_TRACE build.
+ *
+ * The reader and writer threads of a socket update the counters concurrently,
+ * so they are relaxed atomics; a snapshot is not consistent across counters.
+ */
+class ConnectionStats {
+public:
+    // The order matches the array returned by SSL_get_connection_stats.
+    enum Counter {
+        kRecordsSealed,
+        kRecordsOpened,
+        kPlaintextBytesWritten,
+        kPlaintextBytesRead,
+        // Records including their headers, as seen by BoringSSL; traffic
+        // handled by kernel TLS is not included.
+        kCiphertextBytesWritten,
+        kCiphertextBytesRead,
+        kWantRead,
+        kWantWrite,
+        // Times a socket thread blocked in sslSelect, and the total time.
+        kSelectWaits,
+        kSelectWaitNanos,
+        // Times sslNotify woke up, or tried to wake up, a blocked thread.
+        kNotifyWakeups,
+        // Handshakes started, including the initial one.
+        kHandshakes,
+        kKeyUpdatesSent,
+        kKeyUpdatesReceived,
+        kCounterCount,
+    };
+
+    /**
+     * Times one wait in sslSelect.
+     */
+    class Wait {
+    public:
+        explicit Wait(ConnectionStats* stats)
+            : stats_(stats), begin_(std::chrono::steady_clock::now()) {}
+
+        ~Wait() {
+            auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - begin_);
+            stats_->add(kSelectWaits);
+            stats_->add(kSelectWaitNanos, static_cast<uint64_t>(nanos.count()));
+        }
+
+        Wait(const Wait&) = delete;
+        Wait& operator=(const Wait&) = delete;
+
+    private:
+        ConnectionStats* stats_;
+        std::chrono::steady_clock::time_point begin_;
+    };
+
+    void add(Counter counter, uint64_t delta = 1) {
+        counters_[counter].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    uint64_t get(Counter counter) const {
+        return counters_[counter].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Counts the outcome of an SSL_read or SSL_peek that returned result.
+     */
+    void countRead(int result, int sslError) {
+        if (result > 0) {
+            add(kPlaintextBytesRead, static_cast<uint64_t>(result));
+        } else {
+            countError(sslError);
+        }
+    }
+
+    /**
+     * Counts the plaintext written by an SSL_write that returned result.
+     */
+    void countWrite(int result) {
+        if (result > 0) {
+            add(kPlaintextBytesWritten, static_cast<uint64_t>(result));
+        }
+    }
+
+    void countError(int sslError) {
+        if (sslError == SSL_ERROR_WANT_READ) {
+            add(kWantRead);
+        } else if (sslError == SSL_ERROR_WANT_WRITE) {
+            add(kWantWrite);
+        }
+    }
+
+    /**
+     * Counts the records and KeyUpdate messages reported to the message
+     * callback of the SSL.
+     */
+    void countMessage(int isWrite, int contentType, const void* buf, size_t len) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(buf);
+        if (contentType == SSL3_RT_HEADER && len >= SSL3_RT_HEADER_LENGTH) {
+            uint64_t recordBytes = len + ((static_cast<uint64_t>(bytes[3]) << 8) | bytes[4]);
+            if (isWrite) {
+                add(kRecordsSealed);
+                add(kCiphertextBytesWritten, recordBytes);
+            } else {
+                add(kRecordsOpened);
+                add(kCiphertextBytesRead, recordBytes);
+            }
+        } else if (contentType == SSL3_RT_HANDSHAKE && len > 0 &&
+                   bytes[0] == SSL3_MT_KEY_UPDATE) {
+            add(isWrite ? kKeyUpdatesSent : kKeyUpdatesReceived);
+        }
+    }
+
+private:
+    std::atomic<uint64_t> counters_[kCounterCount]{};
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_CONNECTION_STATS_H_
@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_ENGINE_BIO_H_
+#define CONSCRYPT_ENGINE_BIO_H_
+
+#include <conscrypt/memory_stats.h>
+#include <openssl/bio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace conscrypt {
+
+/**
+ * In-memory transport of an SSLEngine connection, used in place of
+ * BIO_new_bio_pair.
+ *
+ * Two BIOs share one EngineBio: the SSL side is given to SSL_set_bio and the
+ * network side is handed to Java, which writes received ciphertext into it and
+ * reads ciphertext to send out of it, just as with a BIO pair. In addition, a
+ * native call may lend the caller's buffers for its duration. While a buffer
+ * is lent, the SSL reads ciphertext straight out of the lent input and writes
+ * records straight into the lent output, so the internal buffers only hold
+ * what doesn't fit.
+ */
+class EngineBio {
+public:
+    // Same as the default size of the buffers of a BIO pair.
+    static constexpr size_t kBufferSize = 17 * 1024;
+
+    /**
+     * Creates the SSL and network BIOs of a new EngineBio. Returns false if
+     * either couldn't be allocated.
+     */
+    static bool newPair(BIO** sslBio, BIO** networkBio) {
+        const BIO_METHOD* sslMethod = method(true);
+        const BIO_METHOD* networkMethod = method(false);
+        if (sslMethod == nullptr || networkMethod == nullptr) {
+            return false;
+        }
+        BIO* ssl = BIO_new(sslMethod);
+        BIO* network = BIO_new(networkMethod);
+        if (ssl == nullptr || network == nullptr) {
+            BIO_free(ssl);
+            BIO_free(network);
+            return false;
+        }
+        EngineBio* engineBio = new EngineBio();
+        BIO_set_data(ssl, engineBio);
+        BIO_set_init(ssl, 1);
+        BIO_set_data(network, engineBio);
+        BIO_set_init(network, 1);
+        *sslBio = ssl;
+        *networkBio = network;
+        return true;
+    }
+
+    /**
+     * Returns the EngineBio behind either of its BIOs.
+     */
+    static EngineBio* from(BIO* bio) {
+        return static_cast<EngineBio*>(BIO_get_data(bio));
+    }
+
+    /**
+     * The number of bytes of ciphertext that can still be accepted from the
+     * network, whether written or lent.
+     */
+    size_t inboundSpace() const {
+        return inbound_.space();
+    }
+
+    /**
+     * Lends ciphertext for the SSL to read. The caller must have checked that
+     * len is at most inboundSpace().
+     */
+    void lendInput(const uint8_t* data, size_t len) {
+        lentIn_ = data;
+        lentInLength_ = len;
+        lentInOffset_ = 0;
+    }
+
+    /**
+     * Ends the loan of the input, copying whatever the SSL didn't read into the
+     * internal buffer, so that all of it counts as consumed.
+     */
+    void returnInput() {
+        if (lentInOffset_ < lentInLength_) {
+            inbound_.write(lentIn_ + lentInOffset_, lentInLength_ - lentInOffset_);
+        }
+        lentIn_ = nullptr;
+        lentInLength_ = 0;
+        lentInOffset_ = 0;
+    }
+
+    /**
+     * Lends a buffer for the SSL to write records into.
+     */
+    void lendOutput(uint8_t* data, size_t len) {
+        lentOut_ = data;
+        lentOutLength_ = len;
+        lentOutOffset_ = 0;
+    }
+
+    /**
+     * Ends the loan of the output and returns the number of bytes written into
+     * it. Anything that didn't fit is left in the internal buffer.
+     */
+    size_t returnOutput() {
+        size_t written = lentOutOffset_;
+        lentOut_ = nullptr;
+        lentOutLength_ = 0;
+        lentOutOffset_ = 0;
+        return written;
+    }
+
+    /**
+     * Makes the internal buffers free their storage whenever they become
+     * empty, trading an allocation per burst of traffic for not keeping two
+     * mostly idle 17KB buffers per connection.
+     */
+    void setReleaseBuffers(bool release) {
+        inbound_.setReleaseWhenEmpty(release);
+        outbound_.setReleaseWhenEmpty(release);
+    }
+
+    /**
+     * The number of bytes of storage currently held by the internal buffers.
+     */
+    size_t allocatedBytes() const {
+        return inbound_.allocatedBytes() + outbound_.allocatedBytes();
+    }
+
+private:
+    /**
+     * A fixed-capacity byte queue, allocated on first use.
+     */
+    class Buffer {
+    public:
+        ~Buffer() {
+            memory_stats::add(memory_stats::kEngineBioBytes,
+                              -static_cast<int64_t>(storage_.capacity()));
+        }
+
+        size_t size() const {
+            return end_ - start_;
+        }
+
+        size_t space() const {
+            return kBufferSize - size();
+        }
+
+        size_t allocatedBytes() const {
+            return storage_.capacity();
+        }
+
+        void setReleaseWhenEmpty(bool release) {
+            releaseWhenEmpty_ = release;
+            releaseIfEmpty();
+        }
+
+        size_t write(const uint8_t* data, size_t len) {
+            len = std::min(len, space());
+            if (len == 0) {
+                return 0;
+            }
+            if (storage_.empty()) {
+                storage_.resize(kBufferSize);
+                memory_stats::add(memory_stats::kEngineBioBytes,
+                                  static_cast<int64_t>(storage_.capacity()));
+            }
+            if (end_ + len > kBufferSize) {
+                memmove(storage_.data(), storage_.data() + start_, size());
+                end_ -= start_;
+                start_ = 0;
+            }
+            memcpy(storage_.data() + end_, data, len);
+            end_ += len;
+            return len;
+        }
+
+        size_t read(uint8_t* data, size_t len) {
+            len = std::min(len, size());
+            if (len == 0) {
+                return 0;
+            }
+            memcpy(data, storage_.data() + start_, len);
+            start_ += len;
+            if (start_ == end_) {
+                start_ = end_ = 0;
+                releaseIfEmpty();
+            }
+            return len;
+        }
+
+    private:
+        void releaseIfEmpty() {
+            if (releaseWhenEmpty_ && size() == 0 && !storage_.empty()) {
+                memory_stats::add(memory_stats::kEngineBioBytes,
+                                  -static_cast<int64_t>(storage_.capacity()));
+                std::vector<uint8_t>().swap(storage_);
+            }
+        }
+
+        std::vector<uint8_t> storage_;
+        size_t start_ = 0;
+        size_t end_ = 0;
+        bool releaseWhenEmpty_ = false;
+    };
+
+    EngineBio() : refs_(2), sslClosed_(false), networkClosed_(false) {
+        memory_stats::add(memory_stats::kEngineBio, 1);
+        memory_stats::add(memory_stats::kEngineBioBytes, static_cast<int64_t>(sizeof(EngineBio)));
+    }
+
+    ~EngineBio() {
+        memory_stats::add(memory_stats::kEngineBio, -1);
+        memory_stats::add(memory_stats::kEngineBioBytes,
+                          -static_cast<int64_t>(sizeof(EngineBio)));
+    }
+
+    size_t lentInRemaining() const {
+        return lentInLength_ - lentInOffset_;
+    }
+
+    // Ciphertext received from the network and not yet read by the SSL.
+    size_t readForSsl(uint8_t* data, size_t len) {
+        size_t n = inbound_.read(data, len);
+        if (n < len && lentIn_ != nullptr) {
+            size_t lent = std::min(len - n, lentInRemaining());
+            memcpy(data + n, lentIn_ + lentInOffset_, lent);
+            lentInOffset_ += lent;
+            n += lent;
+        }
+        return n;
+    }
+
+    // Records written by the SSL. These go into the lent output as long as
+    // nothing is queued ahead of them.
+    size_t writeFromSsl(const uint8_t* data, size_t len) {
+        size_t n = 0;
+        if (outbound_.size() == 0 && lentOut_ != nullptr) {
+            n = std::min(len, lentOutLength_ - lentOutOffset_);
+            memcpy(lentOut_ + lentOutOffset_, data, n);
+            lentOutOffset_ += n;
+        }
+        if (n < len) {
+            n += outbound_.write(data + n, len - n);
+        }
+        return n;
+    }
+
+    static int sslRead(BIO* bio, char* out, int len) {
+        BIO_clear_retry_flags(bio);
+        EngineBio* engineBio = from(bio);
+        if (len <= 0) {
+            return 0;
+        }
+        size_t n = engineBio->readForSsl(reinterpret_cast<uint8_t*>(out),
+                                         static_cast<size_t>(len));
+        if (n > 0) {
+            return static_cast<int>(n);
+        }
+        if (engineBio->networkClosed_) {
+            return 0;
+        }
+        BIO_set_retry_read(bio);
+        return -1;
+    }
+
+    static int sslWrite(BIO* bio, const char* in, int len) {
+        BIO_clear_retry_flags(bio);
+        EngineBio* engineBio = from(bio);
+        if (len <= 0) {
+            return 0;
+        }
+        if (engineBio->networkClosed_) {
+            return -1;
+        }
+        size_t n = engineBio->writeFromSsl(reinterpret_cast<const uint8_t*>(in),
+                                           static_cast<size_t>(len));
+        if (n > 0) {
+            return static_cast<int>(n);
+        }
+        BIO_set_retry_write(bio);
+        return -1;
+    }
+
+    static int networkRead(BIO* bio, char* out, int len) {
+        BIO_clear_retry_flags(bio);
+        EngineBio* engineBio = from(bio);
+        if (len <= 0) {
+            return 0;
+        }
+        size_t n = engineBio->outbound_.read(reinterpret_cast<uint8_t*>(out),
+                                             static_cast<size_t>(len));
+        if (n > 0) {
+            return static_cast<int>(n);
+        }
+        if (engineBio->sslClosed_) {
+            return 0;
+        }
+        BIO_set_retry_read(bio);
+        return -1;
+    }
+
+    static int networkWrite(BIO* bio, const char* in, int len) {
+        BIO_clear_retry_flags(bio);
+        EngineBio* engineBio = from(bio);
+        if (len <= 0) {
+            return 0;
+        }
+        if (engineBio->sslClosed_) {
+            return -1;
+        }
+        size_t n = engineBio->inbound_.write(reinterpret_cast<const uint8_t*>(in),
+                                             static_cast<size_t>(len));
+        if (n > 0) {
+            return static_cast<int>(n);
+        }
+        BIO_set_retry_write(bio);
+        return -1;
+    }
+
+    // NOLINTNEXTLINE(runtime/int)
+    static long ctrl(BIO* bio, int cmd, bool sslSide) {
+        EngineBio* engineBio = from(bio);
+        const Buffer& readable = sslSide ? engineBio->inbound_ : engineBio->outbound_;
+        const Buffer& writable = sslSide ? engineBio->outbound_ : engineBio->inbound_;
+        switch (cmd) {
+            case BIO_CTRL_PENDING:
+                // NOLINTNEXTLINE(runtime/int)
+                return static_cast<long>(readable.size() +
+                                         (sslSide ? engineBio->lentInRemaining() : 0));
+            case BIO_CTRL_WPENDING:
+                // NOLINTNEXTLINE(runtime/int)
+                return static_cast<long>(writable.size());
+            case BIO_C_GET_WRITE_GUARANTEE:
+                // NOLINTNEXTLINE(runtime/int)
+                return static_cast<long>(writable.space());
+            case BIO_CTRL_FLUSH:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    // NOLINTNEXTLINE(runtime/int)
+    static long sslCtrl(BIO* bio, int cmd, long, void*) {
+        return ctrl(bio, cmd, true);
+    }
+
+    // NOLINTNEXTLINE(runtime/int)
+    static long networkCtrl(BIO* bio, int cmd, long, void*) {
+        return ctrl(bio, cmd, false);
+    }
+
+    static int destroy(BIO* bio, bool sslSide) {
+        if (bio == nullptr) {
+            return 0;
+        }
+        EngineBio* engineBio = from(bio);
+        BIO_set_data(bio, nullptr);
+        BIO_set_init(bio, 0);
+        if (engineBio == nullptr) {
+            return 1;
+        }
+        if (sslSide) {
+            engineBio->sslClosed_ = true;
+        } else {
+            engineBio->networkClosed_ = true;
+        }
+        if (engineBio->refs_.fetch_sub(1) == 1) {
+            delete engineBio;
+        }
+        return 1;
+    }
+
+    static int sslDestroy(BIO* bio) {
+        return destroy(bio, true);
+    }
+
+    static int networkDestroy(BIO* bio) {
+        return destroy(bio, false);
+    }
+
+    static const BIO_METHOD* method(bool sslSide) {
+        static const BIO_METHOD* sslMethod = []() -> const BIO_METHOD* {
+            BIO_METHOD* method = BIO_meth_new(0, "conscrypt engine ssl");
+            if (!method || !BIO_meth_set_read(method, sslRead) ||
+                !BIO_meth_set_write(method, sslWrite) || !BIO_meth_set_ctrl(method, sslCtrl) ||
+                !BIO_meth_set_destroy(method, sslDestroy)) {
+                BIO_meth_free(method);
+                return nullptr;
+            }
+            return method;
+        }();
+        static const BIO_METHOD* networkMethod = []() -> const BIO_METHOD* {
+            BIO_METHOD* method = BIO_meth_new(0, "conscrypt engine network");
+            if (!method || !BIO_meth_set_read(method, networkRead) ||
+                !BIO_meth_set_write(method, networkWrite) ||
+                !BIO_meth_set_ctrl(method, networkCtrl) ||
+                !BIO_meth_set_destroy(method, networkDestroy)) {
+                BIO_meth_free(method);
+                return nullptr;
+            }
+            return method;
+        }();
+        return sslSide ? sslMethod : networkMethod;
+    }
+
+    std::atomic<int> refs_;
+    std::atomic<bool> sslClosed_;
+    std::atomic<bool> networkClosed_;
+
+    Buffer inbound_;
+    Buffer outbound_;
+
+    const uint8_t* lentIn_ = nullptr;
+    size_t lentInLength_ = 0;
+    size_t lentInOffset_ = 0;
+
+    uint8_t* lentOut_ = nullptr;
+    size_t lentOutLength_ = 0;
+    size_t lentOutOffset_ = 0;
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_ENGINE_BIO_H_
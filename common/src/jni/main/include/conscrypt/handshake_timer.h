@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_HANDSHAKE_TIMER_H_
+#define CONSCRYPT_HANDSHAKE_TIMER_H_
+
+#include <stdint.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+
+namespace conscrypt {
+
+/**
+ * Records where the time of a handshake goes, so that its latency can be
+ * attributed to BoringSSL, to the Java callbacks, or to waiting for the peer.
+ *
+ * Each call into SSL_do_handshake is a step. Callbacks made during a step
+ * (certificate selection, private key operations on Java keys, certificate
+ * verification) are timed with a Phase and subtracted from the time spent in
+ * the library. Asynchronous selection and verification are timed from the
+ * request until BoringSSL consumes the result.
+ *
+ * All methods are called on the thread driving the handshake, so no locking
+ * is needed. Values are nanoseconds unless stated otherwise; offsets are
+ * relative to SSL_CB_HANDSHAKE_START.
+ */
+class HandshakeTimer {
+public:
+    // The order matches the array returned by SSL_get_handshake_timings.
+    enum Field {
+        // Offset of the ClientHello: when it was written (client) or received
+        // (server).
+        kHelloOffset,
+        // Offset of the end of the handshake, i.e. its total duration.
+        kFinishedOffset,
+        // Time spent in SSL_do_handshake, not counting the callbacks below.
+        kLibrary,
+        kCertSelection,
+        kPrivateKey,
+        kCertVerification,
+        // Number of SSL_do_handshake calls, roughly one per flight awaited.
+        kSteps,
+        // 1 if the session was resumed, 0 for a full handshake.
+        kResumed,
+        kFieldCount,
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Times one call into SSL_do_handshake and makes the timer current on
+     * this thread for its duration.
+     */
+    class Step {
+    public:
+        explicit Step(HandshakeTimer* timer) : timer_(timer), previous_(current()) {
+            if (timer_ != nullptr) {
+                begin_ = Clock::now();
+                current() = timer_;
+            }
+        }
+
+        ~Step() {
+            if (timer_ != nullptr) {
+                current() = previous_;
+                timer_->endStep(begin_);
+            }
+        }
+
+        Step(const Step&) = delete;
+        Step& operator=(const Step&) = delete;
+
+    private:
+        HandshakeTimer* timer_;
+        HandshakeTimer* previous_;
+        Clock::time_point begin_;
+    };
+
+    /**
+     * Times a callback made during a step and charges it to the given field.
+     */
+    class Phase {
+    public:
+        Phase(HandshakeTimer* timer, Field field) : timer_(timer), field_(field) {
+            if (timer_ != nullptr) {
+                begin_ = Clock::now();
+            }
+        }
+
+        ~Phase() {
+            if (timer_ != nullptr) {
+                int64_t nanos = elapsed(begin_, Clock::now());
+                timer_->values_[field_] += nanos;
+                timer_->callbacks_ += nanos;
+            }
+        }
+
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+
+    private:
+        HandshakeTimer* timer_;
+        Field field_;
+        Clock::time_point begin_;
+    };
+
+    /**
+     * Returns the timer of the handshake step running on this thread, if
+     * any. This reaches callbacks that are not handed the SSL, such as the
+     * signing methods of keys backed by Java.
+     */
+    static HandshakeTimer*& current() {
+        static thread_local HandshakeTimer* timer = nullptr;
+        return timer;
+    }
+
+    void start(bool server) {
+        for (int64_t& value : values_) {
+            value = 0;
+        }
+        startedAt_ = Clock::now();
+        callbacks_ = 0;
+        stepTotal_ = 0;
+        server_ = server;
+        started_ = true;
+        finished_ = false;
+    }
+
+    void markHello() {
+        if (started_ && values_[kHelloOffset] == 0) {
+            values_[kHelloOffset] = elapsed(startedAt_, Clock::now());
+        }
+    }
+
+    void finish(bool resumed) {
+        if (!started_ || finished_) {
+            return;
+        }
+        finishedAt_ = Clock::now();
+        values_[kFinishedOffset] = elapsed(startedAt_, finishedAt_);
+        values_[kResumed] = resumed ? 1 : 0;
+        finished_ = true;
+    }
+
+    /**
+     * Marks the start of an asynchronous selection or verification. It is
+     * charged to field once endAsync is called.
+     */
+    void beginAsync() {
+        asyncBegin_ = Clock::now();
+    }
+
+    void endAsync(Field field) {
+        values_[field] += elapsed(asyncBegin_, Clock::now());
+    }
+
+    bool finished() const {
+        return finished_;
+    }
+
+    const int64_t* values() const {
+        return values_;
+    }
+
+private:
+    static int64_t elapsed(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+    }
+
+    void endStep(Clock::time_point begin) {
+        // The step that starts the handshake enters before
+        // SSL_CB_HANDSHAKE_START, and the last one returns after
+        // SSL_CB_HANDSHAKE_DONE; only count the time in between.
+        if (!started_ || (finished_ && begin >= finishedAt_)) {
+            return;
+        }
+        Clock::time_point end = finished_ ? finishedAt_ : Clock::now();
+        if (begin < startedAt_) {
+            begin = startedAt_;
+        }
+        stepTotal_ += elapsed(begin, end);
+        values_[kSteps]++;
+        values_[kLibrary] = stepTotal_ > callbacks_ ? stepTotal_ - callbacks_ : 0;
+        if (!server_) {
+            // A client has written its ClientHello by the end of its first step.
+            markHello();
+        }
+    }
+
+    int64_t values_[kFieldCount] = {};
+    Clock::time_point startedAt_;
+    Clock::time_point finishedAt_;
+    Clock::time_point asyncBegin_;
+    int64_t callbacks_ = 0;
+    int64_t stepTotal_ = 0;
+    bool server_ = false;
+    bool started_ = false;
+    bool finished_ = false;
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_HANDSHAKE_TIMER_H_
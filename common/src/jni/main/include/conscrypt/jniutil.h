@@ -33,7 +33,6 @@ extern jclass nativeRefClass;
 extern jclass nativeRefHpkeCtxClass;
 
 extern jclass byteArrayClass;
-extern jclass calendarClass;
 extern jclass objectClass;
 extern jclass objectArrayClass;
 extern jclass integerClass;
@@ -44,11 +43,10 @@ extern jclass byteBufferClass;
 
 extern jfieldID nativeRef_address;
 
-extern jmethodID calendar_setMethod;
-extern jmethodID inputStream_readMethod;
+extern jmethodID inputStream_readRangeMethod;
 extern jmethodID integer_valueOfMethod;
 extern jmethodID openSslInputStream_readLineMethod;
-extern jmethodID outputStream_writeMethod;
+extern jmethodID outputStream_writeRangeMethod;
 extern jmethodID outputStream_flushMethod;
 extern jmethodID buffer_positionMethod;
 extern jmethodID buffer_limitMethod;
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_MEMORY_STATS_H_
+#define CONSCRYPT_MEMORY_STATS_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+namespace conscrypt {
+namespace memory_stats {
+
+/**
+ * Process-wide counts of the native objects Conscrypt creates, and of the
+ * bytes it allocates for them itself. The order matches the array returned by
+ * NativeCrypto.get_native_memory_stats.
+ */
+enum Counter {
+    // Live SSL objects, from SSL_new to SSL_free.
+    kSsl,
+    // Live SSL_CTX objects.
+    kSslCtx,
+    // SSL_SESSION references held by Java.
+    kSslSession,
+    // Live AppData objects and the bytes they hold, including ALPN copies.
+    kAppData,
+    kAppDataBytes,
+    // Live engine BIOs and the bytes they hold, including their buffers.
+    kEngineBio,
+    kEngineBioBytes,
+    // Certificates and CA names passed through the shared CRYPTO_BUFFER_POOL
+    // since startup, and their bytes. This is throughput, not memory held:
+    // BoringSSL does not report whether a lookup found an existing copy.
+    kPoolLookups,
+    kPoolLookupBytes,
+    kCounterCount,
+};
+
+inline std::atomic<int64_t> counters[kCounterCount];
+
+inline void add(Counter counter, int64_t delta) {
+    counters[counter].fetch_add(delta, std::memory_order_relaxed);
+}
+
+inline int64_t get(Counter counter) {
+    return counters[counter].load(std::memory_order_relaxed);
+}
+
+}  // namespace memory_stats
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_MEMORY_STATS_H_
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_REVOCATION_INDEX_H_
+#define CONSCRYPT_REVOCATION_INDEX_H_
+
+#include <openssl/asn1.h>
+#include <openssl/x509.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace conscrypt {
+
+/**
+ * The serial numbers listed by a CRL, copied out of it once so that many
+ * serials can be checked without converting each to an ASN1_INTEGER and
+ * searching the CRL. A Bloom filter in front of the set answers most serials
+ * that are not listed without touching the set.
+ *
+ * The index does not refer to the CRL and is immutable once built, so any
+ * number of threads may query it at once.
+ */
+class RevocationIndex {
+public:
+    explicit RevocationIndex(const X509_CRL* crl) {
+        const STACK_OF(X509_REVOKED)* revoked = X509_CRL_get_REVOKED(crl);
+        size_t count = revoked == nullptr ? 0 : sk_X509_REVOKED_num(revoked);
+
+        size_t bits = kMinBloomBits;
+        while (bits < count * kBloomBitsPerEntry) {
+            bits <<= 1;
+        }
+        bloom_.resize(bits / 64);
+        bloomMask_ = bits - 1;
+        serials_.reserve(count);
+
+        for (size_t i = 0; i < count; i++) {
+            const ASN1_INTEGER* serial =
+                    X509_REVOKED_get0_serialNumber(sk_X509_REVOKED_value(revoked, i));
+            std::string key = keyOf(serial);
+            addToBloom(std::hash<std::string>()(key));
+            serials_.insert(std::move(key));
+        }
+    }
+
+    size_t size() const {
+        return serials_.size();
+    }
+
+    /**
+     * Returns whether the CRL lists the serial number encoded in two's
+     * complement, big-endian, as by BigInteger#toByteArray.
+     */
+    bool contains(const uint8_t* serial, size_t len) const {
+        std::string key = keyOf(serial, len);
+        size_t hash = std::hash<std::string>()(key);
+        return mayContain(hash) && serials_.count(key) != 0;
+    }
+
+private:
+    static constexpr size_t kBloomBitsPerEntry = 16;
+    static constexpr size_t kMinBloomBits = 64;
+    static constexpr int kBloomHashes = 3;
+
+    // Keys are a sign byte followed by the magnitude without leading zeros,
+    // so that each number has exactly one key however it was encoded.
+    static std::string keyOf(const ASN1_INTEGER* serial) {
+        const uint8_t* data = ASN1_STRING_get0_data(serial);
+        size_t len = static_cast<size_t>(ASN1_STRING_length(serial));
+        while (len > 0 && data[0] == 0) {
+            data++;
+            len--;
+        }
+        bool negative = ASN1_STRING_type(serial) == V_ASN1_NEG_INTEGER && len > 0;
+        std::string key(1, negative ? '\1' : '\0');
+        key.append(reinterpret_cast<const char*>(data), len);
+        return key;
+    }
+
+    static std::string keyOf(const uint8_t* serial, size_t len) {
+        if (len == 0 || (serial[0] & 0x80) == 0) {
+            while (len > 0 && serial[0] == 0) {
+                serial++;
+                len--;
+            }
+            std::string key(1, '\0');
+            key.append(reinterpret_cast<const char*>(serial), len);
+            return key;
+        }
+
+        // Negate to get the magnitude: invert and add one, from the end.
+        std::vector<uint8_t> magnitude(serial, serial + len);
+        bool carry = true;
+        for (size_t i = len; i > 0; i--) {
+            magnitude[i - 1] = static_cast<uint8_t>(~magnitude[i - 1]);
+            if (carry) {
+                magnitude[i - 1]++;
+                carry = magnitude[i - 1] == 0;
+            }
+        }
+        size_t start = 0;
+        while (start < len && magnitude[start] == 0) {
+            start++;
+        }
+        std::string key(1, '\1');
+        key.append(reinterpret_cast<const char*>(magnitude.data() + start), len - start);
+        return key;
+    }
+
+    // Derives the probe positions from one hash by double hashing.
+    size_t bloomBit(size_t hash, int i) const {
+        uint64_t h = static_cast<uint64_t>(hash);
+        uint64_t step = (h >> 32) | 1;
+        return static_cast<size_t>((h + static_cast<uint64_t>(i) * step) & bloomMask_);
+    }
+
+    void addToBloom(size_t hash) {
+        for (int i = 0; i < kBloomHashes; i++) {
+            size_t bit = bloomBit(hash, i);
+            bloom_[bit / 64] |= uint64_t{1} << (bit % 64);
+        }
+    }
+
+    bool mayContain(size_t hash) const {
+        for (int i = 0; i < kBloomHashes; i++) {
+            size_t bit = bloomBit(hash, i);
+            if ((bloom_[bit / 64] & (uint64_t{1} << (bit % 64))) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<uint64_t> bloom_;
+    size_t bloomMask_;
+    std::unordered_set<std::string> serials_;
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_REVOCATION_INDEX_H_
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_VERIFY_CACHE_H_
+#define CONSCRYPT_VERIFY_CACHE_H_
+
+#include <conscrypt/macros.h>
+#include <openssl/err.h>
+#include <openssl/pool.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <mutex>   // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+namespace conscrypt {
+
+/**
+ * Remembers the peer chains that passed verification on connections of one
+ * SSL_CTX, so that a chain verified a moment ago is not handed to the trust
+ * manager again. Entries are keyed by a digest of the chain, what the peer
+ * stapled to it, the authentication method and a scope the Java side derives
+ * from everything else verification depends on, and expire after the
+ * configured TTL or when a certificate of the chain expires, whichever is
+ * sooner. Only successful verifications are cached.
+ *
+ * The cache belongs to the SSL_CTX and is freed with it.
+ */
+class VerifyCache {
+public:
+    // The order matches the array returned by SSL_CTX_get_verify_cache_stats.
+    enum Stat {
+        kHits,
+        kMisses,
+        kEntries,
+        kStatCount,
+    };
+
+    /**
+     * Returns the cache of ctx, or nullptr if none was configured.
+     */
+    static VerifyCache* get(const SSL_CTX* ctx) {
+        return reinterpret_cast<VerifyCache*>(SSL_CTX_get_ex_data(ctx, exDataIndex()));
+    }
+
+    /**
+     * Returns the cache of ctx, creating it if needed, or nullptr if that
+     * failed.
+     */
+    static VerifyCache* getOrCreate(SSL_CTX* ctx) {
+        VerifyCache* cache = get(ctx);
+        if (cache == nullptr) {
+            cache = new VerifyCache();
+            if (!SSL_CTX_set_ex_data(ctx, exDataIndex(), cache)) {
+                delete cache;
+                return nullptr;
+            }
+        }
+        return cache;
+    }
+
+    /**
+     * Computes the key of the peer chain of ssl, verified for authMethod
+     * within scope. The stapled OCSP response and the SCTs the peer sent are
+     * part of the key, as the trust manager may judge the chain by them.
+     */
+    static std::string keyOf(const SSL* ssl, const char* authMethod, const std::string& scope) {
+        SHA256_CTX sha;
+        SHA256_Init(&sha);
+        const STACK_OF(CRYPTO_BUFFER)* chain = SSL_get0_peer_certificates(ssl);
+        size_t numCerts = sk_CRYPTO_BUFFER_num(chain);
+        for (size_t i = 0; i < numCerts; i++) {
+            const CRYPTO_BUFFER* cert = sk_CRYPTO_BUFFER_value(chain, i);
+            update(&sha, CRYPTO_BUFFER_data(cert), CRYPTO_BUFFER_len(cert));
+        }
+        // Ends the chain; no certificate has this length.
+        update(&sha, nullptr, SIZE_MAX);
+
+        const uint8_t* data;
+        size_t len;
+        SSL_get0_ocsp_response(ssl, &data, &len);
+        update(&sha, data, len);
+        SSL_get0_signed_cert_timestamp_list(ssl, &data, &len);
+        update(&sha, data, len);
+        update(&sha, reinterpret_cast<const uint8_t*>(authMethod),
+               authMethod == nullptr ? 0 : strlen(authMethod));
+        update(&sha, reinterpret_cast<const uint8_t*>(scope.data()), scope.size());
+
+        uint8_t digest[SHA256_DIGEST_LENGTH];
+        SHA256_Final(digest, &sha);
+        return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+    }
+
+    /**
+     * Sets the maximum number of entries and their lifetime. Zero entries
+     * disables the cache without freeing it, as connections may be using it.
+     */
+    void configure(size_t maxEntries, int64_t ttlMillis) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maxEntries_ = maxEntries;
+        ttlMillis_ = ttlMillis;
+        if (maxEntries_ == 0) {
+            entries_.clear();
+        }
+    }
+
+    bool enabled() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return maxEntries_ > 0;
+    }
+
+    /**
+     * Returns whether key was verified and has not expired since.
+     */
+    bool lookup(const std::string& key) {
+        int64_t now = nowMillis();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end() && it->second > now) {
+            hits_++;
+            return true;
+        }
+        if (it != entries_.end()) {
+            entries_.erase(it);
+        }
+        misses_++;
+        return false;
+    }
+
+    /**
+     * Records that chain, with the given key, passed verification.
+     */
+    void insert(const std::string& key, const STACK_OF(CRYPTO_BUFFER)* chain) {
+        int64_t now = nowMillis();
+        int64_t expiry = chainExpiryMillis(chain);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (maxEntries_ == 0 || ttlMillis_ <= 0 || expiry <= now) {
+            return;
+        }
+        if (ttlMillis_ < expiry - now) {
+            expiry = now + ttlMillis_;
+        }
+        if (entries_.size() >= maxEntries_ && entries_.find(key) == entries_.end()) {
+            evict(now);
+        }
+        entries_[key] = expiry;
+    }
+
+    /**
+     * Forgets every verification, e.g. after the trust store changed.
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+    void stats(int64_t* out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out[kHits] = static_cast<int64_t>(hits_);
+        out[kMisses] = static_cast<int64_t>(misses_);
+        out[kEntries] = static_cast<int64_t>(entries_.size());
+    }
+
+private:
+    VerifyCache() = default;
+
+    static int exDataIndex() {
+        static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, freeExData);
+        return index;
+    }
+
+    static void freeExData(CONSCRYPT_UNUSED void* parent, void* ptr,
+                           CONSCRYPT_UNUSED CRYPTO_EX_DATA* ad, CONSCRYPT_UNUSED int index,
+                           CONSCRYPT_UNUSED long argl,  // NOLINT(runtime/int)
+                           CONSCRYPT_UNUSED void* argp) {
+        delete reinterpret_cast<VerifyCache*>(ptr);
+    }
+
+    // Hashes len and then the data, so that consecutive fields stay apart.
+    static void update(SHA256_CTX* sha, const uint8_t* data, size_t len) {
+        uint64_t len64 = len;
+        SHA256_Update(sha, &len64, sizeof(len64));
+        if (len > 0 && data != nullptr) {
+            SHA256_Update(sha, data, len);
+        }
+    }
+
+    static int64_t nowMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+    }
+
+    /**
+     * Returns when the first certificate of chain to expire does, in
+     * milliseconds since the epoch, or 0 if that cannot be determined.
+     */
+    static int64_t chainExpiryMillis(const STACK_OF(CRYPTO_BUFFER)* chain) {
+        size_t numCerts = sk_CRYPTO_BUFFER_num(chain);
+        if (numCerts == 0) {
+            return 0;
+        }
+        int64_t expiry = INT64_MAX / 1000;
+        for (size_t i = 0; i < numCerts; i++) {
+            bssl::UniquePtr<X509> cert(X509_parse_from_buffer(sk_CRYPTO_BUFFER_value(chain, i)));
+            int64_t notAfter;
+            if (!cert || !ASN1_TIME_to_posix(X509_get0_notAfter(cert.get()), &notAfter)) {
+                ERR_clear_error();
+                return 0;
+            }
+            expiry = std::min(expiry, notAfter);
+        }
+        return expiry * 1000;
+    }
+
+    // Drops the expired entries or, if there are none, an arbitrary one.
+    void evict(int64_t now) {
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (it->second <= now) {
+                it = entries_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (entries_.size() >= maxEntries_) {
+            entries_.erase(entries_.begin());
+        }
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, int64_t> entries_;
+    size_t maxEntries_ = 0;
+    int64_t ttlMillis_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_VERIFY_CACHE_H_
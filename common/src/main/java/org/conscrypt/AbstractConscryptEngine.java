@@ -76,6 +76,66 @@ abstract class AbstractConscryptEngine extends SSLEngine {
      */
     abstract void setHandshakeListener(HandshakeListener handshakeListener);
 
+    /**
+     * Enables verifying the peer certificate chain in a delegated task, reported through
+     * {@link javax.net.ssl.SSLEngineResult.HandshakeStatus#NEED_TASK}, instead of inline during
+     * {@code wrap} or {@code unwrap}.
+     *
+     * <p>This method needs to be invoked before the handshake starts.
+     *
+     * @throws IllegalStateException if the handshake has already started.
+     */
+    abstract void setAsyncCertificateVerification(boolean enabled);
+
+    /**
+     * Limits records to {@code smallRecordSize} bytes of plaintext after the handshake and after
+     * the engine has been idle for {@code idleTimeoutMillis}, until {@code boostThresholdBytes}
+     * have been written or {@code boostTimeoutMillis} have passed. A {@code smallRecordSize} of 0
+     * disables it.
+     */
+    abstract void setDynamicRecordSizing(int smallRecordSize, long boostThresholdBytes,
+            long boostTimeoutMillis, long idleTimeoutMillis);
+
+    /**
+     * Releases the certificates, keys and other configuration only needed for the handshake once
+     * it is done, at the cost of refusing renegotiation. Must be called before the handshake.
+     */
+    abstract void setShedHandshakeConfig(boolean enabled);
+
+    /**
+     * Returns the number of bytes of native memory held for this connection outside of
+     * BoringSSL.
+     */
+    abstract long getNativeFootprint();
+
+    /**
+     * Records where the time of the handshake goes. Must be called before the handshake.
+     */
+    abstract void setHandshakeTimingEnabled(boolean enabled);
+
+    /**
+     * Returns the timings of the last completed handshake, in the order of the fields of
+     * {@link Conscrypt.HandshakeTimings}, or {@code null} if they weren't recorded.
+     */
+    abstract long[] getHandshakeTimings();
+
+    /**
+     * Returns the traffic counters of the connection, in the order of the fields of
+     * {@link Conscrypt.ConnectionStats}, or {@code null} once it has been closed.
+     */
+    abstract long[] getConnectionStats();
+
+    /**
+     * Enables selecting the server certificate in a delegated task, reported through
+     * {@link javax.net.ssl.SSLEngineResult.HandshakeStatus#NEED_TASK}, instead of inline during
+     * {@code wrap} or {@code unwrap}.
+     *
+     * <p>This method needs to be invoked before the handshake starts.
+     *
+     * @throws IllegalStateException if the handshake has already started.
+     */
+    abstract void setAsyncCertificateSelection(boolean enabled);
+
     /**
      * This method enables Server Name Indication (SNI) and overrides the {@link PeerInfoProvider}
      * supplied during engine creation.
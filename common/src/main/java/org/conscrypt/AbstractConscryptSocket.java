@@ -43,6 +43,8 @@ import javax.net.ssl.SSLSocket;
  * Abstract base class for all Conscrypt {@link SSLSocket} classes.
  */
 abstract class AbstractConscryptSocket extends SSLSocket {
+    private static final int SEND_FILE_BUFFER_SIZE = 64 * 1024;
+
     final Socket socket;
     private final boolean autoClose;
 
@@ -629,6 +631,83 @@ abstract class AbstractConscryptSocket extends SSLSocket {
      */
     abstract void setUseSessionTickets(boolean useSessionTickets);
 
+    /**
+     * Requests that the record layer be handed over to the kernel (Linux kTLS) once the
+     * handshake completes. If the kernel declines, the socket silently keeps encrypting in
+     * user space. Must be called before the handshake.
+     */
+    abstract void setKernelTlsEnabled(boolean enabled);
+
+    /**
+     * Returns whether the kernel took over the record layer in both directions after the
+     * handshake, as requested with {@link #setKernelTlsEnabled}.
+     */
+    abstract boolean isKernelTlsActive();
+
+    /**
+     * Limits records to {@code smallRecordSize} bytes of plaintext after the handshake and after
+     * the connection has been idle for {@code idleTimeoutMillis}, until
+     * {@code boostThresholdBytes} have been written or {@code boostTimeoutMillis} have passed.
+     * A {@code smallRecordSize} of 0 disables it.
+     */
+    abstract void setDynamicRecordSizing(int smallRecordSize, long boostThresholdBytes,
+            long boostTimeoutMillis, long idleTimeoutMillis);
+
+    /**
+     * Releases the certificates, keys and other configuration only needed for the handshake once
+     * it is done, at the cost of refusing renegotiation. Must be called before the handshake.
+     */
+    abstract void setShedHandshakeConfig(boolean enabled);
+
+    /**
+     * Returns the number of bytes of native memory held for this connection outside of
+     * BoringSSL.
+     */
+    abstract long getNativeFootprint();
+
+    /**
+     * Records where the time of the handshake goes. Must be called before the handshake.
+     */
+    abstract void setHandshakeTimingEnabled(boolean enabled);
+
+    /**
+     * Returns the timings of the last completed handshake, in the order of the fields of
+     * {@link Conscrypt.HandshakeTimings}, or {@code null} if they weren't recorded.
+     */
+    abstract long[] getHandshakeTimings();
+
+    /**
+     * Returns the traffic counters of the connection, in the order of the fields of
+     * {@link Conscrypt.ConnectionStats}, or {@code null} once it has been closed.
+     */
+    abstract long[] getConnectionStats();
+
+    /**
+     * Writes {@code count} bytes of {@code file}, starting at {@code offset}, to the connection.
+     * Returns the number of bytes written, which is less than {@code count} only if the end of
+     * the file is reached. Sockets that can't send the file without copying it through user
+     * space fall back to reading it into a buffer and writing it to the output stream.
+     */
+    long sendFile(FileDescriptor file, long offset, long count) throws IOException {
+        checkNotNull(file, "file");
+        checkArgument(offset >= 0 && count >= 0, "Invalid offset or count");
+        // Reads with pread rather than through a FileChannel, since interrupting a channel closes
+        // it and with it the caller's file descriptor.
+        OutputStream out = getOutputStream();
+        byte[] buffer = new byte[(int) Math.min(count, SEND_FILE_BUFFER_SIZE)];
+        long sent = 0;
+        while (sent < count) {
+            int read = NativeCrypto.pread(
+                    file, buffer, 0, (int) Math.min(buffer.length, count - sent), offset + sent);
+            if (read <= 0) {
+                break;
+            }
+            out.write(buffer, 0, read);
+            sent += read;
+        }
+        return sent;
+    }
+
     /**
      * Enables/disables TLS Channel ID for this server socket.
      *
@@ -18,6 +18,7 @@ package org.conscrypt;
 
 import java.util.Arrays;
 import java.util.Enumeration;
+import java.util.IdentityHashMap;
 import java.util.Iterator;
 import java.util.LinkedHashMap;
 import java.util.Map;
@@ -28,6 +29,7 @@ import java.util.concurrent.locks.ReentrantReadWriteLock;
 import javax.net.ssl.SSLException;
 import javax.net.ssl.SSLSession;
 import javax.net.ssl.SSLSessionContext;
+import javax.net.ssl.X509TrustManager;
 
 /**
  * Supports SSL session caches.
@@ -46,6 +48,17 @@ abstract class AbstractSessionContext implements SSLSessionContext {
 
     private final ReadWriteLock lock = new ReentrantReadWriteLock();
 
+    // Guarded by lock.
+    private boolean certificateCompressionEnabled;
+    private boolean certificateCompressionAvailable;
+
+    private volatile boolean verificationCacheEnabled;
+    // Numbers the trust managers that cached verifications were made by, so that a chain trusted
+    // by one is never taken as trusted by another.
+    private final Map<X509TrustManager, Long> verificationCacheScopes = new IdentityHashMap<>();
+
+    private final CertificateCredentials certificateCredentials = new CertificateCredentials();
+
     private final Map<ByteArray, NativeSslSession> sessions =
             new LinkedHashMap<ByteArray, NativeSslSession>() {
                 @Override
@@ -238,6 +251,97 @@ abstract class AbstractSessionContext implements SSLSessionContext {
         }
     }
 
+    /**
+     * Offers and accepts compressed certificate chains on connections created from now on.
+     * Returns whether certificate compression is available.
+     */
+    boolean enableCertificateCompression() {
+        lock.writeLock().lock();
+        try {
+            if (!isValid()) {
+                return false;
+            }
+            if (!certificateCompressionEnabled) {
+                certificateCompressionAvailable =
+                        NativeCrypto.SSL_CTX_enable_cert_compression(sslCtxNativePointer, this);
+                certificateCompressionEnabled = true;
+            }
+            return certificateCompressionAvailable;
+        } finally {
+            lock.writeLock().unlock();
+        }
+    }
+
+    /**
+     * Caches successful certificate verifications of connections created from now on for at most
+     * {@code ttlMillis}, keeping up to {@code maxEntries} of them. A {@code maxEntries} of 0
+     * disables the cache.
+     */
+    void setVerificationCache(int maxEntries, long ttlMillis) {
+        lock.writeLock().lock();
+        try {
+            if (isValid()) {
+                NativeCrypto.SSL_CTX_set_verify_cache(
+                        sslCtxNativePointer, this, maxEntries, ttlMillis);
+                verificationCacheEnabled = maxEntries > 0 && ttlMillis > 0;
+            }
+        } finally {
+            lock.writeLock().unlock();
+        }
+    }
+
+    /**
+     * Returns the native credentials built for the chains and keys of this context's key manager.
+     */
+    CertificateCredentials getCertificateCredentials() {
+        return certificateCredentials;
+    }
+
+    boolean isVerificationCacheEnabled() {
+        return verificationCacheEnabled;
+    }
+
+    /**
+     * Returns the number that identifies {@code trustManager} in the scope of cached
+     * verifications.
+     */
+    long getVerificationCacheScope(X509TrustManager trustManager) {
+        synchronized (verificationCacheScopes) {
+            Long scope = verificationCacheScopes.get(trustManager);
+            if (scope == null) {
+                scope = (long) verificationCacheScopes.size();
+                verificationCacheScopes.put(trustManager, scope);
+            }
+            return scope;
+        }
+    }
+
+    void clearVerificationCache() {
+        lock.readLock().lock();
+        try {
+            if (isValid()) {
+                NativeCrypto.SSL_CTX_clear_verify_cache(sslCtxNativePointer, this);
+            }
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    /**
+     * Returns the hits, misses and entries of the verification cache, or {@code null} if there
+     * is none.
+     */
+    long[] getVerificationCacheStats() {
+        lock.readLock().lock();
+        try {
+            return isValid()
+                    ? NativeCrypto.SSL_CTX_get_verify_cache_stats(sslCtxNativePointer, this)
+                    : null;
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     protected void setSesssionIdContext(byte[] bytes) {
         lock.writeLock().lock();
         try {
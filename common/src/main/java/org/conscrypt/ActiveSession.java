@@ -45,7 +45,10 @@ final class ActiveSession implements ConscryptSession {
     @SuppressWarnings("deprecation")
     private volatile javax.security.cert.X509Certificate[] peerCertificateChain;
     private X509Certificate[] localCertificates;
-    private X509Certificate[] peerCertificates;
+    // Both volatile since checkPeerCertificatesPresent reads them outside the lock.
+    private volatile X509Certificate[] peerCertificates;
+    // The peer's chain on a resumed session, decoded the first time it is asked for.
+    private volatile PeerCertificateChain undecodedPeerCertificates;
     private byte[] peerCertificateOcspData;
     private byte[] peerTlsSctData;
 
@@ -307,6 +310,7 @@ final class ActiveSession implements ConscryptSession {
         this.peerHost = peerHost;
         this.peerPort = peerPort;
         this.peerCertificates = peerCertificates;
+        this.undecodedPeerCertificates = null;
         synchronized (ssl) {
             this.peerCertificateOcspData = ssl.getPeerCertificateOcspData();
             this.peerTlsSctData = ssl.getPeerTlsSctData();
@@ -328,8 +332,10 @@ final class ActiveSession implements ConscryptSession {
                 // onPeerCertificatesReceived) isn't called by BoringSSL during the handshake
                 // because it presumes the certs were verified in the previous connection on that
                 // session, leaving us without the peer certificates.  If that happens, fetch them
-                // explicitly.
-                configurePeer(peerHost, peerPort, ssl.getPeerCertificates());
+                // explicitly, but only decode them if someone asks.
+                PeerCertificateChain chain = ssl.getPeerCertificateChain();
+                configurePeer(peerHost, peerPort, null);
+                this.undecodedPeerCertificates = chain;
             }
         }
     }
@@ -338,6 +344,18 @@ final class ActiveSession implements ConscryptSession {
      * Throw SSLPeerUnverifiedException on null or empty peerCertificates array
      */
     private void checkPeerCertificatesPresent() throws SSLPeerUnverifiedException {
+        if (peerCertificates == null && undecodedPeerCertificates != null) {
+            synchronized (ssl) {
+                if (peerCertificates == null && undecodedPeerCertificates != null) {
+                    try {
+                        peerCertificates = undecodedPeerCertificates.getCertificates();
+                    } catch (CertificateException e) {
+                        throw new SSLPeerUnverifiedException(e.getMessage());
+                    }
+                    undecodedPeerCertificates = null;
+                }
+            }
+        }
         if (peerCertificates == null || peerCertificates.length == 0) {
             throw new SSLPeerUnverifiedException("No peer certificates");
         }
@@ -68,6 +68,18 @@ final class BufferUtils {
         }
     }
 
+    /**
+     * Returns true if every buffer in the array that has data remaining is direct.
+     */
+    static boolean isDirect(ByteBuffer[] buffers) {
+        for (ByteBuffer buffer : buffers) {
+            if (buffer.hasRemaining() && !buffer.isDirect()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     /**
      * Looks for a buffer in the buffer array which EITHER is larger than {@code minSize} AND
      * has no preceding non-empty buffers OR is the only non-empty buffer in the array.
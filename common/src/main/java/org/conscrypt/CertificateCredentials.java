@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import java.security.InvalidKeyException;
+import java.security.PrivateKey;
+import java.security.PublicKey;
+import java.security.cert.CertificateEncodingException;
+import java.security.cert.X509Certificate;
+import java.util.Arrays;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+import javax.net.ssl.SSLException;
+
+/**
+ * Native credentials for the certificate chains and keys handed out by the key manager of one
+ * session context. A connection authenticating with a chain and key seen before gets the
+ * credential built for them the first time, rather than a fresh copy of the chain. The
+ * credentials live no longer than the context, which holds the key manager and so the keys
+ * anyway.
+ */
+final class CertificateCredentials {
+    // Enough for the few identities a server typically has, e.g. an RSA and an ECDSA chain for
+    // each of a handful of hostnames.
+    private static final int MAXIMUM_SIZE = 32;
+
+    private static final class Entry {
+        final X509Certificate[] chain;
+        final NativeRef.SSL_CREDENTIAL credential;
+
+        Entry(X509Certificate[] chain, NativeRef.SSL_CREDENTIAL credential) {
+            this.chain = chain;
+            this.credential = credential;
+        }
+    }
+
+    // Guarded by itself.
+    private final Map<PrivateKey, Entry> credentials =
+            new LinkedHashMap<PrivateKey, Entry>(16, 0.75f, true) {
+                @Override
+                protected boolean removeEldestEntry(Map.Entry<PrivateKey, Entry> eldest) {
+                    // Connections still holding the evicted credential keep it alive.
+                    return size() > MAXIMUM_SIZE;
+                }
+            };
+
+    /**
+     * Returns the credential for the given key and chain, building it if they have not been seen
+     * together recently.
+     */
+    NativeRef.SSL_CREDENTIAL get(PrivateKey privateKey, X509Certificate[] chain)
+            throws CertificateEncodingException, SSLException {
+        synchronized (credentials) {
+            Entry entry = credentials.get(privateKey);
+            if (entry != null && Arrays.equals(entry.chain, chain)) {
+                return entry.credential;
+            }
+        }
+
+        // Encode the certificates.
+        byte[][] encodedCerts = new byte[chain.length][];
+        for (int i = 0; i < chain.length; ++i) {
+            encodedCerts[i] = chain[i].getEncoded();
+        }
+
+        // Convert the key so we can access a native reference.
+        PublicKey publicKey = (chain.length > 0) ? chain[0].getPublicKey() : null;
+        final OpenSSLKey key;
+        try {
+            key = OpenSSLKey.fromPrivateKeyForTLSStackOnly(privateKey, publicKey);
+        } catch (InvalidKeyException e) {
+            throw new SSLException(e);
+        }
+
+        NativeRef.SSL_CREDENTIAL credential = new NativeRef.SSL_CREDENTIAL(
+                NativeCrypto.SSL_CREDENTIAL_new_x509(encodedCerts, key.getNativeRef()));
+        synchronized (credentials) {
+            credentials.put(privateKey, new Entry(chain.clone(), credential));
+        }
+        return credential;
+    }
+}
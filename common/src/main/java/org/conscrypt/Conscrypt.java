@@ -17,14 +17,17 @@ package org.conscrypt;
 
 import org.conscrypt.io.IoUtils;
 
+import java.io.FileDescriptor;
 import java.io.IOException;
 import java.io.InputStream;
 import java.lang.reflect.InvocationTargetException;
 import java.lang.reflect.Method;
+import java.math.BigInteger;
 import java.nio.ByteBuffer;
 import java.security.KeyManagementException;
 import java.security.PrivateKey;
 import java.security.Provider;
+import java.security.cert.X509CRL;
 import java.security.cert.X509Certificate;
 import java.util.Properties;
 
@@ -131,6 +134,305 @@ public final class Conscrypt {
         return VERSION;
     }
 
+    /**
+     * Process-wide counts of the native objects held by Conscrypt and of the native memory
+     * Conscrypt has allocated for them, for sizing hosts and finding leaks. Memory allocated by
+     * BoringSSL itself is not included in the byte counts.
+     */
+    public static final class NativeMemoryStats {
+        // Indices into NativeCrypto.get_native_memory_stats(), in the order of
+        // memory_stats::Counter in memory_stats.h.
+        private static final int SSL = 0;
+        private static final int SSL_CTX = 1;
+        private static final int SSL_SESSION = 2;
+        private static final int APP_DATA = 3;
+        private static final int APP_DATA_BYTES = 4;
+        private static final int ENGINE_BIO = 5;
+        private static final int ENGINE_BIO_BYTES = 6;
+        private static final int POOL_LOOKUPS = 7;
+        private static final int POOL_LOOKUP_BYTES = 8;
+
+        private final long sslCount;
+        private final long sslContextCount;
+        private final long sessionCount;
+        private final long connectionStateCount;
+        private final long connectionStateBytes;
+        private final long engineBioCount;
+        private final long engineBioBytes;
+        private final long certificatePoolLookups;
+        private final long certificatePoolLookupBytes;
+
+        private NativeMemoryStats(long[] stats) {
+            this.sslCount = stats[SSL];
+            this.sslContextCount = stats[SSL_CTX];
+            this.sessionCount = stats[SSL_SESSION];
+            this.connectionStateCount = stats[APP_DATA];
+            this.connectionStateBytes = stats[APP_DATA_BYTES];
+            this.engineBioCount = stats[ENGINE_BIO];
+            this.engineBioBytes = stats[ENGINE_BIO_BYTES];
+            this.certificatePoolLookups = stats[POOL_LOOKUPS];
+            this.certificatePoolLookupBytes = stats[POOL_LOOKUP_BYTES];
+        }
+
+        /** The number of live native SSL objects, i.e. connections that haven't been freed. */
+        public long sslCount() {
+            return sslCount;
+        }
+        /** The number of live native SSL_CTX objects. */
+        public long sslContextCount() {
+            return sslContextCount;
+        }
+        /** The number of references to native sessions held by Java objects. */
+        public long sessionCount() {
+            return sessionCount;
+        }
+        /**
+         * The number of live blocks of per-connection state held by Conscrypt outside of
+         * BoringSSL. This normally equals {@link #sslCount()}; a difference points at a leak.
+         */
+        public long connectionStateCount() {
+            return connectionStateCount;
+        }
+        /** The bytes of per-connection state held by Conscrypt outside of BoringSSL. */
+        public long connectionStateBytes() {
+            return connectionStateBytes;
+        }
+        /** The number of live engine network BIOs. */
+        public long engineBioCount() {
+            return engineBioCount;
+        }
+        /** The bytes held by engine network BIOs, including their buffers. */
+        public long engineBioBytes() {
+            return engineBioBytes;
+        }
+        /**
+         * The number of certificates and CA names, local or received from peers, passed through
+         * the shared certificate pool since startup. Identical ones share a single native copy, but
+         * this counts every lookup, whether or not it found one; it measures throughput, not the
+         * memory the pool holds or saves.
+         */
+        public long certificatePoolLookups() {
+            return certificatePoolLookups;
+        }
+        /** The bytes of the certificates counted by {@link #certificatePoolLookups()}. */
+        public long certificatePoolLookupBytes() {
+            return certificatePoolLookupBytes;
+        }
+        /** The total bytes of native memory allocated by Conscrypt itself. */
+        public long totalBytes() {
+            return connectionStateBytes + engineBioBytes;
+        }
+    }
+
+    /**
+     * Statistics of a certificate verification cache, see
+     * {@link #setCertificateVerificationCache(SSLContext, int, long)}.
+     */
+    public static final class CertificateVerificationCacheStats {
+        // Indices into the array returned by SSL_CTX_get_verify_cache_stats, in the order of
+        // VerifyCache::Stat in verify_cache.h.
+        private static final int HITS = 0;
+        private static final int MISSES = 1;
+        private static final int ENTRIES = 2;
+
+        private final long hits;
+        private final long misses;
+        private final long size;
+
+        private CertificateVerificationCacheStats(long[] stats) {
+            this.hits = stats[HITS];
+            this.misses = stats[MISSES];
+            this.size = stats[ENTRIES];
+        }
+
+        /** The number of verifications answered from the cache. */
+        public long hits() {
+            return hits;
+        }
+        /** The number of verifications that were not in the cache, or had expired. */
+        public long misses() {
+            return misses;
+        }
+        /** The number of verifications currently cached. */
+        public long size() {
+            return size;
+        }
+    }
+
+    /**
+     * Where the time of a handshake went, as recorded when enabled with
+     * {@link #setHandshakeTimingEnabled(SSLSocket, boolean)}. Durations are in nanoseconds and
+     * offsets are relative to the start of the handshake. The time neither spent in BoringSSL nor
+     * in callbacks, {@link #waitingNanos()}, is mostly spent waiting for the peer.
+     */
+    public static final class HandshakeTimings {
+        // Indices into the array returned by SSL_get_handshake_timings, in the order of
+        // HandshakeTimer::Field in handshake_timer.h.
+        private static final int HELLO_OFFSET = 0;
+        private static final int FINISHED_OFFSET = 1;
+        private static final int LIBRARY = 2;
+        private static final int CERT_SELECTION = 3;
+        private static final int PRIVATE_KEY = 4;
+        private static final int CERT_VERIFICATION = 5;
+        private static final int STEPS = 6;
+        private static final int RESUMED = 7;
+
+        private final long helloOffsetNanos;
+        private final long totalNanos;
+        private final long libraryNanos;
+        private final long certificateSelectionNanos;
+        private final long privateKeyNanos;
+        private final long certificateVerificationNanos;
+        private final long steps;
+        private final boolean resumed;
+
+        private HandshakeTimings(long[] timings) {
+            this.helloOffsetNanos = timings[HELLO_OFFSET];
+            this.totalNanos = timings[FINISHED_OFFSET];
+            this.libraryNanos = timings[LIBRARY];
+            this.certificateSelectionNanos = timings[CERT_SELECTION];
+            this.privateKeyNanos = timings[PRIVATE_KEY];
+            this.certificateVerificationNanos = timings[CERT_VERIFICATION];
+            this.steps = timings[STEPS];
+            this.resumed = timings[RESUMED] != 0;
+        }
+
+        /** When the ClientHello was sent (client) or received (server). */
+        public long helloOffsetNanos() {
+            return helloOffsetNanos;
+        }
+        /** The duration of the handshake. */
+        public long totalNanos() {
+            return totalNanos;
+        }
+        /** The time spent in BoringSSL, including private key operations on native keys. */
+        public long libraryNanos() {
+            return libraryNanos;
+        }
+        /** The time spent selecting the local certificate, including asynchronous selection. */
+        public long certificateSelectionNanos() {
+            return certificateSelectionNanos;
+        }
+        /** The time spent in private key operations on keys backed by a Java provider. */
+        public long privateKeyNanos() {
+            return privateKeyNanos;
+        }
+        /** The time spent verifying the peer's certificates, including asynchronously. */
+        public long certificateVerificationNanos() {
+            return certificateVerificationNanos;
+        }
+        /** The remaining time, mostly spent waiting for the peer or the caller. */
+        public long waitingNanos() {
+            return Math.max(0, totalNanos - libraryNanos - certificateSelectionNanos
+                    - privateKeyNanos - certificateVerificationNanos);
+        }
+        /** The number of times the handshake was driven, roughly one per flight awaited. */
+        public long steps() {
+            return steps;
+        }
+        /** Whether the session was resumed rather than negotiated with a full handshake. */
+        public boolean isResumed() {
+            return resumed;
+        }
+    }
+
+    /**
+     * A snapshot of the traffic counters of a connection, for finding chatty or stalled
+     * connections. The counters are updated concurrently by the reading and writing threads, so
+     * they aren't necessarily consistent with each other. Records and ciphertext handled by
+     * kernel TLS are not counted.
+     */
+    public static final class ConnectionStats {
+        // Indices into the array returned by SSL_get_connection_stats, in the order of
+        // ConnectionStats::Counter in connection_stats.h.
+        private static final int RECORDS_SEALED = 0;
+        private static final int RECORDS_OPENED = 1;
+        private static final int PLAINTEXT_BYTES_WRITTEN = 2;
+        private static final int PLAINTEXT_BYTES_READ = 3;
+        private static final int CIPHERTEXT_BYTES_WRITTEN = 4;
+        private static final int CIPHERTEXT_BYTES_READ = 5;
+        private static final int WANT_READ = 6;
+        private static final int WANT_WRITE = 7;
+        private static final int SELECT_WAITS = 8;
+        private static final int SELECT_WAIT_NANOS = 9;
+        private static final int NOTIFY_WAKEUPS = 10;
+        private static final int HANDSHAKES = 11;
+        private static final int KEY_UPDATES_SENT = 12;
+        private static final int KEY_UPDATES_RECEIVED = 13;
+
+        private final long[] stats;
+
+        private ConnectionStats(long[] stats) {
+            this.stats = stats;
+        }
+
+        /** The number of TLS records written. */
+        public long recordsSealed() {
+            return stats[RECORDS_SEALED];
+        }
+        /** The number of TLS records read. */
+        public long recordsOpened() {
+            return stats[RECORDS_OPENED];
+        }
+        /** The bytes of application data written. */
+        public long plaintextBytesWritten() {
+            return stats[PLAINTEXT_BYTES_WRITTEN];
+        }
+        /** The bytes of application data read. */
+        public long plaintextBytesRead() {
+            return stats[PLAINTEXT_BYTES_READ];
+        }
+        /** The bytes of TLS records written, including their headers. */
+        public long ciphertextBytesWritten() {
+            return stats[CIPHERTEXT_BYTES_WRITTEN];
+        }
+        /** The bytes of TLS records read, including their headers. */
+        public long ciphertextBytesRead() {
+            return stats[CIPHERTEXT_BYTES_READ];
+        }
+        /** The number of times an operation had to wait for data from the peer. */
+        public long wantReadCount() {
+            return stats[WANT_READ];
+        }
+        /** The number of times an operation had to wait to send data to the peer. */
+        public long wantWriteCount() {
+            return stats[WANT_WRITE];
+        }
+        /** The number of times a socket thread blocked waiting for the network. */
+        public long selectWaitCount() {
+            return stats[SELECT_WAITS];
+        }
+        /** The total time socket threads spent blocked waiting for the network. */
+        public long selectWaitNanos() {
+            return stats[SELECT_WAIT_NANOS];
+        }
+        /** The number of times a thread signalled another one blocked on the same socket. */
+        public long wakeupCount() {
+            return stats[NOTIFY_WAKEUPS];
+        }
+        /** The number of handshakes after the initial one. */
+        public long renegotiationCount() {
+            return Math.max(0, stats[HANDSHAKES] - 1);
+        }
+        /** The number of TLS 1.3 KeyUpdate messages sent. */
+        public long keyUpdatesSent() {
+            return stats[KEY_UPDATES_SENT];
+        }
+        /** The number of TLS 1.3 KeyUpdate messages received. */
+        public long keyUpdatesReceived() {
+            return stats[KEY_UPDATES_RECEIVED];
+        }
+    }
+
+    /**
+     * Returns a snapshot of the process-wide native memory counters. See
+     * {@link #getNativeFootprint(SSLSocket)} for the memory held by a single connection.
+     */
+    public static NativeMemoryStats getNativeMemoryStats() {
+        checkAvailability();
+        return new NativeMemoryStats(NativeCrypto.get_native_memory_stats());
+    }
+
     /**
      * Checks that the Conscrypt support is available for the system.
      *
@@ -289,6 +591,116 @@ public final class Conscrypt {
         ((ServerSessionContext) serverContext).setPersistentCache(cache);
     }
 
+    /**
+     * Enables TLS certificate compression (RFC 8879) for connections subsequently created from the
+     * given context. Clients offer to receive compressed chains and servers compress their chain
+     * when the client supports it, which keeps large chains from spilling the server's first
+     * flight past the initial congestion window. The compressed form of recently sent chains is
+     * cached, so a chain is not compressed on every handshake. Certificate compression cannot be
+     * disabled again once enabled.
+     *
+     * @param context the context
+     * @return whether certificate compression is available on this platform
+     */
+    public static boolean enableCertificateCompression(SSLContext context) {
+        boolean enabled = true;
+        for (AbstractSessionContext sessionContext : toConscryptSessionContexts(context)) {
+            enabled &= sessionContext.enableCertificateCompression();
+        }
+        return enabled;
+    }
+
+    /**
+     * Caches successful verifications of peer certificate chains on connections subsequently
+     * created from the given context, so that a chain verified recently is not handed to the trust
+     * manager again. Entries are keyed by the chain, the OCSP response and SCTs the peer sent
+     * with it, the authentication method, the trust manager, the peer hostname, the endpoint
+     * identification algorithm and whether CT is required. They expire after {@code ttlMillis} or
+     * when a certificate of the chain expires, whichever is sooner. Connections that need the
+     * peer's hostname but have none are not cached.
+     *
+     * <p>Only use this when the outcome of verification depends on nothing else, e.g. not on
+     * revocation status that must be fresh for every handshake. Call
+     * {@link #clearCertificateVerificationCache(SSLContext)} when the trust store changes.
+     *
+     * @param context the context
+     * @param maxEntries the maximum number of chains remembered, or 0 to disable the cache
+     * @param ttlMillis how long a verification is remembered, in milliseconds
+     */
+    public static void setCertificateVerificationCache(SSLContext context, int maxEntries,
+                                                       long ttlMillis) {
+        if (maxEntries < 0 || ttlMillis < 0) {
+            throw new IllegalArgumentException("maxEntries < 0 || ttlMillis < 0");
+        }
+        for (AbstractSessionContext sessionContext : toConscryptSessionContexts(context)) {
+            sessionContext.setVerificationCache(maxEntries, ttlMillis);
+        }
+    }
+
+    /**
+     * Forgets all certificate verifications cached for the given context.
+     */
+    public static void clearCertificateVerificationCache(SSLContext context) {
+        for (AbstractSessionContext sessionContext : toConscryptSessionContexts(context)) {
+            sessionContext.clearVerificationCache();
+        }
+    }
+
+    /**
+     * Returns the statistics of the certificate verification cache of the given context, or
+     * {@code null} if {@link #setCertificateVerificationCache} was never called for it.
+     */
+    public static CertificateVerificationCacheStats getCertificateVerificationCacheStats(
+            SSLContext context) {
+        long[] total = null;
+        for (AbstractSessionContext sessionContext : toConscryptSessionContexts(context)) {
+            long[] stats = sessionContext.getVerificationCacheStats();
+            if (stats == null) {
+                continue;
+            }
+            if (total == null) {
+                total = stats;
+            } else {
+                for (int i = 0; i < total.length; i++) {
+                    total[i] += stats[i];
+                }
+            }
+        }
+        return total == null ? null : new CertificateVerificationCacheStats(total);
+    }
+
+    /**
+     * Returns, for each of the given serial numbers, whether the given CRL lists it. For CRLs
+     * created by Conscrypt, all serial numbers are checked in one native call against an index of
+     * the CRL, which is built on first use and kept with it; this suits checking a whole chain or
+     * a batch of certificates against the same CRL. Issuers are not compared.
+     *
+     * @param crl the CRL
+     * @param serialNumbers the serial numbers to check
+     */
+    public static boolean[] areRevoked(X509CRL crl, BigInteger[] serialNumbers) {
+        if (crl instanceof OpenSSLX509CRL) {
+            return ((OpenSSLX509CRL) crl).areRevoked(serialNumbers);
+        }
+        boolean[] revoked = new boolean[serialNumbers.length];
+        for (int i = 0; i < serialNumbers.length; i++) {
+            revoked[i] = crl.getRevokedCertificate(serialNumbers[i]) != null;
+        }
+        return revoked;
+    }
+
+    private static AbstractSessionContext[] toConscryptSessionContexts(SSLContext context) {
+        SSLSessionContext clientContext = context.getClientSessionContext();
+        SSLSessionContext serverContext = context.getServerSessionContext();
+        if (!(clientContext instanceof AbstractSessionContext)
+                || !(serverContext instanceof AbstractSessionContext)) {
+            throw new IllegalArgumentException("Not a conscrypt context: "
+                                               + context.getClass().getName());
+        }
+        return new AbstractSessionContext[] {(AbstractSessionContext) clientContext,
+                                             (AbstractSessionContext) serverContext};
+    }
+
     /**
      * Indicates whether the given {@link SSLSocketFactory} was created by this distribution of
      * Conscrypt.
@@ -410,6 +822,133 @@ public final class Conscrypt {
         toConscrypt(socket).setUseSessionTickets(useSessionTickets);
     }
 
+    /**
+     * Requests that the socket hand its record layer over to the kernel (Linux kTLS) after the
+     * handshake, so that reads and writes bypass user-space encryption. This is a best-effort
+     * optimization: if the platform, the kernel or the negotiated cipher suite doesn't support
+     * it, the socket continues to work as usual. It has no effect on engine-based sockets.
+     * Must be called before the handshake.
+     *
+     * @param socket the socket
+     * @param enabled whether to try to enable kernel TLS
+     */
+    public static void setKernelTlsEnabled(SSLSocket socket, boolean enabled) {
+        toConscrypt(socket).setKernelTlsEnabled(enabled);
+    }
+
+    /**
+     * Returns whether the kernel encrypts and decrypts the records of the given socket, i.e.
+     * whether {@link #setKernelTlsEnabled} took effect in both directions. This is only known
+     * once the handshake has completed.
+     *
+     * @param socket the socket
+     */
+    public static boolean isKernelTlsActive(SSLSocket socket) {
+        return toConscrypt(socket).isKernelTlsActive();
+    }
+
+    /**
+     * Enables dynamic record sizing for the given socket. After the handshake, and again after
+     * the connection has been idle for {@code idleTimeoutMillis}, records carry at most
+     * {@code smallRecordSize} bytes of plaintext until {@code boostThresholdBytes} have been
+     * written or {@code boostTimeoutMillis} have passed since the first of them was, so that the
+     * peer can start processing a response before a full 16KB record has arrived. Records are
+     * full-sized otherwise.
+     *
+     * @param socket the socket
+     * @param smallRecordSize the size of the small records, between 512 and 16384, or 0 to
+     *        disable dynamic record sizing
+     * @param boostThresholdBytes the number of bytes after which records are full-sized
+     * @param boostTimeoutMillis the time after which records are full-sized, or 0 for no limit
+     * @param idleTimeoutMillis the idle time after which records are small again, or 0 for never
+     * @throws IllegalArgumentException if any of the parameters is out of range
+     */
+    public static void setDynamicRecordSizing(SSLSocket socket, int smallRecordSize,
+            long boostThresholdBytes, long boostTimeoutMillis, long idleTimeoutMillis) {
+        toConscrypt(socket).setDynamicRecordSizing(
+                smallRecordSize, boostThresholdBytes, boostTimeoutMillis, idleTimeoutMillis);
+    }
+
+    /**
+     * Makes the given socket release its certificates, private key, cipher configuration and
+     * other state only needed for the handshake once the handshake is done, and free its idle
+     * buffers. This shrinks long-lived, mostly idle connections, at the cost of refusing
+     * renegotiation. Must be called before the handshake. Only the part of the saving made by
+     * Conscrypt itself shows up in {@link #getNativeFootprint(SSLSocket)}.
+     *
+     * @param socket the socket
+     * @param enabled whether to release the handshake configuration
+     */
+    public static void setShedHandshakeConfig(SSLSocket socket, boolean enabled) {
+        toConscrypt(socket).setShedHandshakeConfig(enabled);
+    }
+
+    /**
+     * Returns the number of bytes of native memory Conscrypt currently holds for the given
+     * socket's connection, or 0 once the connection has been closed. Memory allocated by
+     * BoringSSL itself, such as its record buffers and handshake state, is not counted, so the
+     * configuration BoringSSL releases under {@link #setShedHandshakeConfig(SSLSocket, boolean)}
+     * is not reflected here; only the ALPN copies and idle buffers Conscrypt releases are.
+     *
+     * @param socket the socket
+     */
+    public static long getNativeFootprint(SSLSocket socket) {
+        return toConscrypt(socket).getNativeFootprint();
+    }
+
+    /**
+     * Enables/disables recording where the time of the given socket's handshake goes: in
+     * BoringSSL, in certificate selection, private key and certificate verification callbacks,
+     * or waiting for the peer. Must be called before the handshake.
+     *
+     * @param socket the socket
+     * @param enabled whether to record handshake timings
+     */
+    public static void setHandshakeTimingEnabled(SSLSocket socket, boolean enabled) {
+        toConscrypt(socket).setHandshakeTimingEnabled(enabled);
+    }
+
+    /**
+     * Returns the timings of the given socket's last completed handshake, or {@code null} if they
+     * weren't recorded.
+     *
+     * @param socket the socket
+     */
+    public static HandshakeTimings getHandshakeTimings(SSLSocket socket) {
+        long[] timings = toConscrypt(socket).getHandshakeTimings();
+        return timings == null ? null : new HandshakeTimings(timings);
+    }
+
+    /**
+     * Returns the traffic counters of the given socket, or {@code null} once it has been closed.
+     *
+     * @param socket the socket
+     */
+    public static ConnectionStats getConnectionStats(SSLSocket socket) {
+        long[] stats = toConscrypt(socket).getConnectionStats();
+        return stats == null ? null : new ConnectionStats(stats);
+    }
+
+    /**
+     * Writes {@code count} bytes of {@code file}, starting at {@code offset}, to the socket. If
+     * kernel TLS is active (see {@link #setKernelTlsEnabled}), the kernel encrypts the file
+     * contents directly from the page cache and they never enter user space; otherwise they are
+     * copied through the socket's output stream. The file's position is not changed.
+     *
+     * @param socket the socket
+     * @param file the file to send
+     * @param offset the offset in the file of the first byte to send
+     * @param count the number of bytes to send
+     * @return the number of bytes written, which is less than {@code count} only if the end of
+     *         the file is reached
+     * @throws UnsupportedOperationException if kernel TLS is not active and the platform is
+     *         Windows, where the file cannot be read without moving its position
+     */
+    public static long sendFile(SSLSocket socket, FileDescriptor file, long offset, long count)
+            throws IOException {
+        return toConscrypt(socket).sendFile(file, offset, count);
+    }
+
     /**
      * Enables/disables TLS Channel ID for the given server-side socket.
      *
@@ -619,6 +1158,90 @@ public final class Conscrypt {
         toConscrypt(engine).setHandshakeListener(handshakeListener);
     }
 
+    /**
+     * Enables/disables verifying the peer certificate chain in a delegated task for the given
+     * engine. When enabled, the engine reports {@code NEED_TASK} once the peer's certificates
+     * have been received, so that the trust manager can run off the thread driving the engine.
+     * The handshake resumes on the next {@code wrap} or {@code unwrap} after the task returned
+     * by {@link SSLEngine#getDelegatedTask()} has completed.
+     *
+     * <p>This method needs to be invoked before the handshake starts.
+     *
+     * @throws IllegalStateException if the handshake has already started.
+     */
+    public static void setAsyncCertificateVerification(SSLEngine engine, boolean enabled) {
+        toConscrypt(engine).setAsyncCertificateVerification(enabled);
+    }
+
+    /**
+     * Enables dynamic record sizing for the given engine; see
+     * {@link #setDynamicRecordSizing(SSLSocket, int, long, long, long)}.
+     *
+     * @throws IllegalArgumentException if any of the parameters is out of range
+     */
+    public static void setDynamicRecordSizing(SSLEngine engine, int smallRecordSize,
+            long boostThresholdBytes, long boostTimeoutMillis, long idleTimeoutMillis) {
+        toConscrypt(engine).setDynamicRecordSizing(
+                smallRecordSize, boostThresholdBytes, boostTimeoutMillis, idleTimeoutMillis);
+    }
+
+    /**
+     * Makes the given engine release its handshake configuration and idle buffers once the
+     * handshake is done; see {@link #setShedHandshakeConfig(SSLSocket, boolean)}.
+     */
+    public static void setShedHandshakeConfig(SSLEngine engine, boolean enabled) {
+        toConscrypt(engine).setShedHandshakeConfig(enabled);
+    }
+
+    /**
+     * Returns the number of bytes of native memory Conscrypt currently holds for the given
+     * engine; see {@link #getNativeFootprint(SSLSocket)}.
+     */
+    public static long getNativeFootprint(SSLEngine engine) {
+        return toConscrypt(engine).getNativeFootprint();
+    }
+
+    /**
+     * Enables/disables recording where the time of the given engine's handshake goes; see
+     * {@link #setHandshakeTimingEnabled(SSLSocket, boolean)}.
+     */
+    public static void setHandshakeTimingEnabled(SSLEngine engine, boolean enabled) {
+        toConscrypt(engine).setHandshakeTimingEnabled(enabled);
+    }
+
+    /**
+     * Returns the timings of the given engine's last completed handshake, or {@code null} if they
+     * weren't recorded.
+     */
+    public static HandshakeTimings getHandshakeTimings(SSLEngine engine) {
+        long[] timings = toConscrypt(engine).getHandshakeTimings();
+        return timings == null ? null : new HandshakeTimings(timings);
+    }
+
+    /**
+     * Returns the traffic counters of the given engine, or {@code null} once it has been closed.
+     */
+    public static ConnectionStats getConnectionStats(SSLEngine engine) {
+        long[] stats = toConscrypt(engine).getConnectionStats();
+        return stats == null ? null : new ConnectionStats(stats);
+    }
+
+    /**
+     * Enables/disables selecting the server certificate in a delegated task for the given
+     * server-side engine. When enabled, the engine reports {@code NEED_TASK} once the ClientHello
+     * has been processed, so that the key manager can fetch the certificate chain without
+     * blocking the thread driving the engine. The handshake resumes on the next {@code wrap} or
+     * {@code unwrap} after the task returned by {@link SSLEngine#getDelegatedTask()} has
+     * completed.
+     *
+     * <p>This method needs to be invoked before the handshake starts.
+     *
+     * @throws IllegalStateException if the handshake has already started.
+     */
+    public static void setAsyncCertificateSelection(SSLEngine engine, boolean enabled) {
+        toConscrypt(engine).setAsyncCertificateSelection(enabled);
+    }
+
     /**
      * Enables/disables TLS Channel ID for the given server-side engine.
      *
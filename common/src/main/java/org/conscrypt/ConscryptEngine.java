@@ -37,9 +37,17 @@ import static org.conscrypt.NativeConstants.SSL3_RT_MAX_PACKET_SIZE;
 import static org.conscrypt.NativeConstants.SSL3_RT_MAX_PLAIN_LENGTH;
 import static org.conscrypt.NativeConstants.SSL_CB_HANDSHAKE_DONE;
 import static org.conscrypt.NativeConstants.SSL_CB_HANDSHAKE_START;
+import static org.conscrypt.NativeConstants.SSL_ERROR_NONE;
+import static org.conscrypt.NativeConstants.SSL_ERROR_PENDING_CERTIFICATE;
+import static org.conscrypt.NativeConstants.SSL_ERROR_SYSCALL;
+import static org.conscrypt.NativeConstants.SSL_ERROR_WANT_CERTIFICATE_VERIFY;
 import static org.conscrypt.NativeConstants.SSL_ERROR_WANT_READ;
 import static org.conscrypt.NativeConstants.SSL_ERROR_WANT_WRITE;
 import static org.conscrypt.NativeConstants.SSL_ERROR_ZERO_RETURN;
+import static org.conscrypt.NativeCrypto.UNWRAP_ERROR_SHIFT;
+import static org.conscrypt.NativeCrypto.UNWRAP_LENGTH_MASK;
+import static org.conscrypt.NativeCrypto.UNWRAP_PENDING_PLAINTEXT;
+import static org.conscrypt.NativeCrypto.UNWRAP_PRODUCED_SHIFT;
 import static org.conscrypt.Preconditions.checkArgument;
 import static org.conscrypt.Preconditions.checkNotNull;
 import static org.conscrypt.Preconditions.checkPositionIndexes;
@@ -59,6 +67,7 @@ import static java.lang.Math.max;
 import static java.lang.Math.min;
 
 import static javax.net.ssl.SSLEngineResult.HandshakeStatus.FINISHED;
+import static javax.net.ssl.SSLEngineResult.HandshakeStatus.NEED_TASK;
 import static javax.net.ssl.SSLEngineResult.HandshakeStatus.NEED_UNWRAP;
 import static javax.net.ssl.SSLEngineResult.HandshakeStatus.NEED_WRAP;
 import static javax.net.ssl.SSLEngineResult.HandshakeStatus.NOT_HANDSHAKING;
@@ -83,6 +92,8 @@ import java.security.cert.X509Certificate;
 import java.security.interfaces.ECKey;
 import java.security.spec.ECParameterSpec;
 import java.util.Arrays;
+import java.util.List;
+import java.util.Set;
 
 import javax.crypto.SecretKey;
 import javax.net.ssl.SSLEngine;
@@ -111,6 +122,7 @@ final class ConscryptEngine extends AbstractConscryptEngine
     private static final SSLEngineResult NEED_WRAP_OK = new SSLEngineResult(OK, NEED_WRAP, 0, 0);
     private static final SSLEngineResult NEED_WRAP_CLOSED =
             new SSLEngineResult(CLOSED, NEED_WRAP, 0, 0);
+    private static final SSLEngineResult NEED_TASK_OK = new SSLEngineResult(OK, NEED_TASK, 0, 0);
     private static final SSLEngineResult CLOSED_NOT_HANDSHAKING =
             new SSLEngineResult(CLOSED, NOT_HANDSHAKING, 0, 0);
 
@@ -126,6 +138,14 @@ final class ConscryptEngine extends AbstractConscryptEngine
      */
     private ByteBuffer lazyDirectBuffer;
 
+    /**
+     * Scratch arrays for passing several direct buffers to native code in one call, see
+     * {@link #writePlaintextDataGather}, {@link #wrapDirect} and {@link #unwrapDirect}. Guarded
+     * by {@code ssl}.
+     */
+    private long[] gatherAddresses;
+    private int[] gatherLengths;
+
     /**
      * Hostname used with the TLS extension SNI hostname.
      */
@@ -177,6 +197,36 @@ final class ConscryptEngine extends AbstractConscryptEngine
 
     private HandshakeListener handshakeListener;
 
+    /**
+     * Whether the peer certificate chain is verified by a delegated task instead of inline
+     * during {@link #wrap} or {@link #unwrap}.
+     */
+    private boolean asyncCertificateVerification;
+
+    /**
+     * Whether the server certificate is selected by a delegated task instead of inline during
+     * {@link #wrap} or {@link #unwrap}.
+     */
+    private boolean asyncCertificateSelection;
+
+    /**
+     * The pending delegated task (certificate verification or selection), until it is handed out
+     * by {@link #getDelegatedTask()}.
+     */
+    // @GuardedBy("ssl");
+    private Runnable delegatedTask;
+
+    /**
+     * Set while a delegated task has been requested but its result has not been posted yet.
+     */
+    // @GuardedBy("ssl");
+    private boolean delegatedTaskInProgress;
+
+    /**
+     * The reason the last delegated task failed, if it did.
+     */
+    private volatile Exception delegatedTaskFailure;
+
     private final ByteBuffer[] singleSrcBuffer = new ByteBuffer[1];
     private final ByteBuffer[] singleDstBuffer = new ByteBuffer[1];
     private final PeerInfoProvider peerInfoProvider;
@@ -351,6 +401,78 @@ final class ConscryptEngine extends AbstractConscryptEngine
         }
     }
 
+    /**
+     * Enables verifying the peer certificate chain in a delegated task. When enabled, the engine
+     * reports {@link HandshakeStatus#NEED_TASK} once the peer chain has been received, and the
+     * handshake resumes after the task returned by {@link #getDelegatedTask()} has run.
+     */
+    @Override
+    void setAsyncCertificateVerification(boolean enabled) {
+        synchronized (ssl) {
+            if (isHandshakeStarted()) {
+                throw new IllegalStateException(
+                        "Async certificate verification must be set before the handshake starts");
+            }
+            asyncCertificateVerification = enabled;
+        }
+    }
+
+    @Override
+    void setDynamicRecordSizing(int smallRecordSize, long boostThresholdBytes,
+            long boostTimeoutMillis, long idleTimeoutMillis) {
+        synchronized (ssl) {
+            ssl.setDynamicRecordSizing(
+                    smallRecordSize, boostThresholdBytes, boostTimeoutMillis, idleTimeoutMillis);
+        }
+    }
+
+    @Override
+    void setShedHandshakeConfig(boolean enabled) {
+        sslParameters.setShedHandshakeConfig(enabled);
+    }
+
+    @Override
+    long getNativeFootprint() {
+        synchronized (ssl) {
+            return ssl.getNativeFootprint();
+        }
+    }
+
+    @Override
+    void setHandshakeTimingEnabled(boolean enabled) {
+        sslParameters.setHandshakeTiming(enabled);
+    }
+
+    @Override
+    long[] getHandshakeTimings() {
+        synchronized (ssl) {
+            return ssl.getHandshakeTimings();
+        }
+    }
+
+    @Override
+    long[] getConnectionStats() {
+        synchronized (ssl) {
+            return ssl.getConnectionStats();
+        }
+    }
+
+    /**
+     * Enables selecting the server certificate in a delegated task. When enabled, the engine
+     * reports {@link HandshakeStatus#NEED_TASK} once the ClientHello has been processed, and the
+     * handshake resumes after the task returned by {@link #getDelegatedTask()} has run.
+     */
+    @Override
+    void setAsyncCertificateSelection(boolean enabled) {
+        synchronized (ssl) {
+            if (isHandshakeStarted()) {
+                throw new IllegalStateException(
+                        "Async certificate selection must be set before the handshake starts");
+            }
+            asyncCertificateSelection = enabled;
+        }
+    }
+
     /**
      * Sets the listener for the completion of the TLS handshake.
      */
@@ -437,6 +559,12 @@ final class ConscryptEngine extends AbstractConscryptEngine
         try {
             // Prepare the SSL object for the handshake.
             ssl.initialize(getHostname(), channelIdPrivateKey);
+            if (asyncCertificateVerification) {
+                ssl.setAsyncCertificateVerification(true);
+            }
+            if (asyncCertificateSelection) {
+                ssl.setAsyncCertificateSelection(true);
+            }
 
             // For clients, offer to resume a previously cached session to avoid the
             // full TLS handshake.
@@ -504,8 +632,12 @@ final class ConscryptEngine extends AbstractConscryptEngine
 
     @Override
     public Runnable getDelegatedTask() {
-        // This implementation doesn't use any delegated tasks.
-        return null;
+        // Delegated tasks are only used for asynchronous certificate verification and selection.
+        synchronized (ssl) {
+            Runnable task = delegatedTask;
+            delegatedTask = null;
+            return task;
+        }
     }
 
     @Override
@@ -549,6 +681,9 @@ final class ConscryptEngine extends AbstractConscryptEngine
         }
         switch (state) {
             case STATE_HANDSHAKE_STARTED:
+                if (delegatedTaskInProgress) {
+                    return NEED_TASK;
+                }
                 return pendingStatus(pendingOutboundEncryptedBytes());
             case STATE_HANDSHAKE_COMPLETED:
                 return HandshakeStatus.NEED_WRAP;
@@ -791,6 +926,9 @@ final class ConscryptEngine extends AbstractConscryptEngine
                 if (handshakeStatus == NEED_WRAP) {
                     return NEED_WRAP_OK;
                 }
+                if (handshakeStatus == NEED_TASK) {
+                    return NEED_TASK_OK;
+                }
                 if (state == STATE_CLOSED) {
                     return NEED_WRAP_CLOSED;
                 }
@@ -824,6 +962,14 @@ final class ConscryptEngine extends AbstractConscryptEngine
                 return new SSLEngineResult(BUFFER_UNDERFLOW, getHandshakeStatus(), 0, 0);
             }
 
+            if (dstLength > 0) {
+                SSLEngineResult directResult = unwrapDirect(srcs, srcsOffset, srcsEndOffset,
+                        lenRemaining, dsts, dstsOffset, endOffset, handshakeStatus);
+                if (directResult != null) {
+                    return directResult;
+                }
+            }
+
             // Write all of the encrypted source data to the networkBio
             int bytesConsumed = 0;
             if (lenRemaining > 0 && srcsOffset < srcsEndOffset) {
@@ -891,6 +1037,12 @@ final class ConscryptEngine extends AbstractConscryptEngine
                                 case -SSL_ERROR_WANT_WRITE: {
                                     return newResult(bytesConsumed, bytesProduced, handshakeStatus);
                                 }
+                                case -SSL_ERROR_WANT_CERTIFICATE_VERIFY:
+                                case -SSL_ERROR_PENDING_CERTIFICATE: {
+                                    // The handshake is waiting for a delegated task.
+                                    return new SSLEngineResult(getEngineStatus(), handshake(),
+                                                               bytesConsumed, bytesProduced);
+                                }
                                 case -SSL_ERROR_ZERO_RETURN: {
                                     // We received a close_notify from the peer, so mark the
                                     // inbound direction as closed and shut down the SSL object
@@ -943,6 +1095,119 @@ final class ConscryptEngine extends AbstractConscryptEngine
         }
     }
 
+    /**
+     * Performs the BIO write and the plaintext reads of unwrap in a single native call. This
+     * handles the common case of a packet contained in one direct buffer and direct destination
+     * buffers; otherwise it returns null and unwrap takes the step-by-step path.
+     */
+    private SSLEngineResult unwrapDirect(ByteBuffer[] srcs, int srcsOffset, int srcsEndOffset,
+            int packetLength, ByteBuffer[] dsts, int dstsOffset, int dstsEndOffset,
+            HandshakeStatus handshakeStatus) throws SSLException {
+        ByteBuffer src = null;
+        if (packetLength > 0) {
+            while (srcsOffset < srcsEndOffset && !srcs[srcsOffset].hasRemaining()) {
+                srcsOffset++;
+            }
+            src = srcs[srcsOffset];
+            if (!src.isDirect() || src.remaining() < packetLength) {
+                return null;
+            }
+        }
+        int count = 0;
+        for (int i = dstsOffset; i < dstsEndOffset; i++) {
+            ByteBuffer dst = dsts[i];
+            if (!dst.hasRemaining()) {
+                continue;
+            }
+            if (!dst.isDirect()) {
+                return null;
+            }
+            count++;
+        }
+        ensureScratchArrays(count);
+        count = 0;
+        for (int i = dstsOffset; i < dstsEndOffset; i++) {
+            ByteBuffer dst = dsts[i];
+            if (dst.hasRemaining()) {
+                gatherAddresses[count] = directByteBufferAddress(dst, dst.position());
+                gatherLengths[count] = dst.remaining();
+                count++;
+            }
+        }
+
+        long result;
+        try {
+            long srcAddress = src == null ? 0 : directByteBufferAddress(src, src.position());
+            result = networkBio.unwrapDirect(
+                    srcAddress, packetLength, gatherAddresses, gatherLengths, count);
+        } catch (Exception e) {
+            // Shut down the SSL and rethrow the exception.  Users will need to drain any alerts
+            // from the SSL before closing.
+            closeAll();
+            throw convertException(e);
+        }
+        int bytesConsumed = (int) (result & UNWRAP_LENGTH_MASK);
+        int bytesProduced = (int) ((result >>> UNWRAP_PRODUCED_SHIFT) & UNWRAP_LENGTH_MASK);
+        int sslError = (int) ((result >>> UNWRAP_ERROR_SHIFT) & 0xFF);
+
+        if (src != null) {
+            src.position(src.position() + bytesConsumed);
+        }
+        // Every destination before the last one written to was filled completely.
+        int remaining = bytesProduced;
+        for (int i = dstsOffset; i < dstsEndOffset && remaining > 0; i++) {
+            ByteBuffer dst = dsts[i];
+            int n = min(dst.remaining(), remaining);
+            dst.position(dst.position() + n);
+            remaining -= n;
+        }
+
+        switch (sslError) {
+            case SSL_ERROR_NONE:
+                break;
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+            case SSL_ERROR_SYSCALL:
+                // SSL_ERROR_SYSCALL is only reported for an interrupted read.
+                return newResult(bytesConsumed, bytesProduced, handshakeStatus);
+            case SSL_ERROR_WANT_CERTIFICATE_VERIFY:
+            case SSL_ERROR_PENDING_CERTIFICATE:
+                // The handshake is waiting for a delegated task.
+                return new SSLEngineResult(getEngineStatus(), handshake(), bytesConsumed,
+                                           bytesProduced);
+            case SSL_ERROR_ZERO_RETURN:
+                // We received a close_notify from the peer, so mark the inbound direction as
+                // closed and shut down the SSL object
+                closeAll();
+                return new SSLEngineResult(Status.CLOSED,
+                                           pendingOutboundEncryptedBytes() > 0 ? NEED_WRAP
+                                                                               : NOT_HANDSHAKING,
+                                           bytesConsumed, bytesProduced);
+            default:
+                // Should never get here.
+                closeAll();
+                throw newSslExceptionWithMessage("SSL_read");
+        }
+
+        if (handshakeFinished && (result & UNWRAP_PENDING_PLAINTEXT) != 0) {
+            // We filled all buffers but there is still some data pending in the BIO buffer,
+            // return BUFFER_OVERFLOW.
+            return new SSLEngineResult(BUFFER_OVERFLOW,
+                                       mayFinishHandshake(handshakeStatus == FINISHED
+                                                                  ? handshakeStatus
+                                                                  : getHandshakeStatusInternal()),
+                                       bytesConsumed, bytesProduced);
+        }
+        return newResult(bytesConsumed, bytesProduced, handshakeStatus);
+    }
+
+    private void ensureScratchArrays(int length) {
+        if (gatherAddresses == null || gatherAddresses.length < length) {
+            gatherAddresses = new long[length];
+            gatherLengths = new int[length];
+        }
+    }
+
     private static int calcDstsLength(ByteBuffer[] dsts, int dstsOffset, int dstsLength) {
         int capacity = 0;
         for (int i = 0; i < dsts.length; i++) {
@@ -982,6 +1247,13 @@ final class ConscryptEngine extends AbstractConscryptEngine
                     case SSL_ERROR_WANT_WRITE: {
                         return NEED_WRAP;
                     }
+                    case SSL_ERROR_WANT_CERTIFICATE_VERIFY: {
+                        return requestCertificateVerification();
+                    }
+                    case SSL_ERROR_PENDING_CERTIFICATE: {
+                        // The task was created by serverCertificateRequested.
+                        return NEED_TASK;
+                    }
                     default: {
                         // SSL_ERROR_NONE.
                     }
@@ -990,6 +1262,11 @@ final class ConscryptEngine extends AbstractConscryptEngine
                 // Shut down the SSL and rethrow the exception.  Users will need to drain any alerts
                 // from the SSL before closing.
                 closeAll();
+                Exception taskFailure = delegatedTaskFailure;
+                if (taskFailure != null) {
+                    // Report why the delegated task failed the handshake.
+                    throw taskFailure;
+                }
                 throw e;
             }
 
@@ -1005,6 +1282,84 @@ final class ConscryptEngine extends AbstractConscryptEngine
         }
     }
 
+    /**
+     * Creates the delegated task verifying the peer certificate chain the first time the handshake
+     * stops to wait for it.
+     */
+    private HandshakeStatus requestCertificateVerification() {
+        if (!delegatedTaskInProgress) {
+            final PeerCertificateChain certChain = ssl.getPeerCertificateChain();
+            final String authMethod = ssl.getPendingAuthMethod();
+            startDelegatedTask(new Runnable() {
+                @Override
+                public void run() {
+                    verifyCertificateChainAsync(certChain, authMethod);
+                }
+            });
+        }
+        return NEED_TASK;
+    }
+
+    private void startDelegatedTask(Runnable task) {
+        delegatedTaskInProgress = true;
+        delegatedTask = task;
+    }
+
+    private void verifyCertificateChainAsync(PeerCertificateChain certChain, String authMethod) {
+        boolean verified = false;
+        try {
+            verifyCertificateChain(
+                    certChain == null ? null : certChain.getCertificates(), authMethod);
+            verified = true;
+        } catch (CertificateException e) {
+            delegatedTaskFailure = e;
+        }
+        synchronized (ssl) {
+            delegatedTaskInProgress = false;
+            try {
+                ssl.setCertificateVerificationResult(verified);
+            } catch (IOException ignored) {
+                // The engine was closed while the verification was running.
+            }
+        }
+    }
+
+    private void selectServerCertificateAsync() {
+        // The key manager may block, e.g. to load a key, so only reading the request and
+        // installing the result hold the engine lock.
+        Exception failure = null;
+        List<NativeSsl.ChosenCredential> chosen = null;
+        try {
+            Set<String> keyTypes;
+            synchronized (ssl) {
+                keyTypes = ssl.getServerKeyTypes();
+            }
+            chosen = ssl.chooseServerCredentials(keyTypes);
+        } catch (IOException | RuntimeException e) {
+            failure = e;
+        }
+        synchronized (ssl) {
+            boolean selected = false;
+            if (failure == null) {
+                try {
+                    ssl.installServerCredentials(chosen);
+                    selected = true;
+                } catch (IOException | RuntimeException e) {
+                    failure = e;
+                }
+            }
+            if (failure != null) {
+                delegatedTaskFailure = failure;
+            }
+            delegatedTaskInProgress = false;
+            try {
+                ssl.setCertificateSelectionResult(selected);
+            } catch (IOException ignored) {
+                // The engine was closed while the selection was running.
+            }
+        }
+    }
+
     private void finishHandshake() throws SSLException {
         handshakeFinished = true;
         // Notify the listener, if provided.
@@ -1040,6 +1395,66 @@ final class ConscryptEngine extends AbstractConscryptEngine
         return ssl.writeDirectByteBuffer(directByteBufferAddress(src, pos), len);
     }
 
+    /**
+     * Wraps up to one record of plaintext from {@code single}, or gathered from {@code srcs} if
+     * it is null, directly into {@code dst}. Neither the sources nor {@code dst} are updated;
+     * the result packs the bytes consumed and produced and the SSL error of a failed write.
+     */
+    private long wrapDirect(ByteBuffer[] srcs, ByteBuffer single, ByteBuffer dst)
+            throws SSLException {
+        try {
+            int count;
+            if (single != null) {
+                ensureScratchArrays(1);
+                gatherAddresses[0] = directByteBufferAddress(single, single.position());
+                gatherLengths[0] = min(single.remaining(), SSL3_RT_MAX_PLAIN_LENGTH);
+                count = 1;
+            } else {
+                count = fillGatherArrays(srcs, SSL3_RT_MAX_PLAIN_LENGTH);
+            }
+            return networkBio.wrapDirect(gatherAddresses, gatherLengths, count,
+                    directByteBufferAddress(dst, dst.position()), dst.remaining());
+        } catch (Exception e) {
+            throw convertException(e);
+        }
+    }
+
+    /**
+     * Fills the scratch arrays with the addresses and lengths of up to {@code len} bytes from
+     * several direct buffers, returning the number of entries.
+     */
+    private int fillGatherArrays(ByteBuffer[] srcs, int len) {
+        ensureScratchArrays(srcs.length);
+        int count = 0;
+        for (ByteBuffer src : srcs) {
+            int remaining = min(src.remaining(), len);
+            if (remaining == 0) {
+                continue;
+            }
+            gatherAddresses[count] = directByteBufferAddress(src, src.position());
+            gatherLengths[count] = remaining;
+            count++;
+            len -= remaining;
+            if (len == 0) {
+                break;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Writes up to {@code len} bytes from several direct buffers as a single record. The
+     * buffers are not marked as consumed.
+     */
+    private int writePlaintextDataGather(ByteBuffer[] srcs, int len) throws SSLException {
+        try {
+            int count = fillGatherArrays(srcs, len);
+            return ssl.writeDirectByteBuffers(gatherAddresses, gatherLengths, count);
+        } catch (Exception e) {
+            throw convertException(e);
+        }
+    }
+
     private int writePlaintextDataHeap(ByteBuffer src, int pos, int len) throws IOException {
         AllocatedBuffer allocatedBuffer = null;
         try {
@@ -1437,6 +1852,9 @@ final class ConscryptEngine extends AbstractConscryptEngine
                 if (handshakeStatus == NEED_UNWRAP) {
                     return NEED_UNWRAP_OK;
                 }
+                if (handshakeStatus == NEED_TASK) {
+                    return NEED_TASK_OK;
+                }
 
                 if (state == STATE_CLOSED) {
                     return NEED_UNWRAP_CLOSED;
@@ -1460,22 +1878,41 @@ final class ConscryptEngine extends AbstractConscryptEngine
                 boolean isCopy = false;
                 ByteBuffer outputBuffer =
                         BufferUtils.getBufferLargerThan(srcs, SSL3_RT_MAX_PLAIN_LENGTH);
-                if (outputBuffer == null) {
-                    // The buffer by getOrCreateLazyDirectBuffer() is also used by
-                    // writePlainTextDataHeap(), but by filling it here the write path will go via
-                    // writePlainTextDataDirect() and the cost will be approximately the same,
-                    // especially if compacting multiple non-direct buffers into a single
-                    // direct one.
-                    // TODO(): use bufferAllocator if set.
-                    // https://github.com/google/conscrypt/issues/974
-                    outputBuffer = BufferUtils.copyNoConsume(srcs, getOrCreateLazyDirectBuffer(),
-                                                             SSL3_RT_MAX_PLAIN_LENGTH);
+                final int result;
+                int wrapError = -1;
+                if (dst.isDirect() && (outputBuffer == null ? BufferUtils.isDirect(srcs)
+                                                            : outputBuffer.isDirect())) {
+                    // Direct buffers on both sides: seal the record straight into dst.
+                    long packed = wrapDirect(srcs, outputBuffer, dst);
+                    result = (int) (packed & UNWRAP_LENGTH_MASK);
+                    bytesProduced = (int) ((packed >>> UNWRAP_PRODUCED_SHIFT) & UNWRAP_LENGTH_MASK);
+                    wrapError = (int) ((packed >>> UNWRAP_ERROR_SHIFT) & 0xFF);
+                    dst.position(dst.position() + bytesProduced);
+                    isCopy = true;
+                } else if (outputBuffer == null && BufferUtils.isDirect(srcs)) {
+                    // Several direct buffers: let the native code gather them into a single
+                    // record rather than staging a copy here.
+                    result = writePlaintextDataGather(srcs, SSL3_RT_MAX_PLAIN_LENGTH);
                     isCopy = true;
+                } else {
+                    if (outputBuffer == null) {
+                        // The buffer by getOrCreateLazyDirectBuffer() is also used by
+                        // writePlainTextDataHeap(), but by filling it here the write path will
+                        // go via writePlainTextDataDirect() and the cost will be approximately
+                        // the same, especially if compacting multiple non-direct buffers into a
+                        // single direct one.
+                        // TODO(): use bufferAllocator if set.
+                        // https://github.com/google/conscrypt/issues/974
+                        outputBuffer = BufferUtils.copyNoConsume(
+                                srcs, getOrCreateLazyDirectBuffer(), SSL3_RT_MAX_PLAIN_LENGTH);
+                        isCopy = true;
+                    }
+                    // Write plaintext application data to the SSL engine
+                    result = writePlaintextData(outputBuffer,
+                                                min(SSL3_RT_MAX_PLAIN_LENGTH,
+                                                    outputBuffer.remaining()));
                 }
                 final SSLEngineResult pendingNetResult;
-                // Write plaintext application data to the SSL engine
-                int result = writePlaintextData(
-                        outputBuffer, min(SSL3_RT_MAX_PLAIN_LENGTH, outputBuffer.remaining()));
                 if (result > 0) {
                     bytesConsumed = result;
                     if (isCopy) {
@@ -1492,7 +1929,7 @@ final class ConscryptEngine extends AbstractConscryptEngine
                         bytesProduced = pendingNetResult.bytesProduced();
                     }
                 } else {
-                    int sslError = ssl.getError(result);
+                    int sslError = wrapError != -1 ? wrapError : ssl.getError(result);
                     switch (sslError) {
                         case SSL_ERROR_ZERO_RETURN:
                             // This means the connection was shutdown correctly, close inbound
@@ -1599,6 +2036,15 @@ final class ConscryptEngine extends AbstractConscryptEngine
         synchronized (ssl) {
             String[] jsseAlgs = SSLUtils.mapSignatureAlgorithms(signatureAlgs);
             activeSession.onPeerSignatureAlgorithmsReceived(jsseAlgs);
+            if (asyncCertificateSelection) {
+                startDelegatedTask(new Runnable() {
+                    @Override
+                    public void run() {
+                        selectServerCertificateAsync();
+                    }
+                });
+                return;
+            }
             ssl.configureServerCertificate();
         }
     }
@@ -1631,13 +2077,19 @@ final class ConscryptEngine extends AbstractConscryptEngine
     }
 
     @Override
-    public void verifyCertificateChain(byte[][] certChain, String authMethod)
+    public void verifyCertificateChain(long[] certificateRefs, String authMethod)
+            throws CertificateException {
+        verifyCertificateChain(
+                certificateRefs == null ? null : PeerCertificateChain.decode(certificateRefs),
+                authMethod);
+    }
+
+    private void verifyCertificateChain(X509Certificate[] peerCertChain, String authMethod)
             throws CertificateException {
         try {
-            if (certChain == null || certChain.length == 0) {
+            if (peerCertChain == null || peerCertChain.length == 0) {
                 throw new CertificateException("Peer sent no certificate");
             }
-            X509Certificate[] peerCertChain = SSLUtils.decodeX509CertificateChain(certChain);
 
             X509TrustManager x509tm = sslParameters.getX509TrustManager();
             if (x509tm == null) {
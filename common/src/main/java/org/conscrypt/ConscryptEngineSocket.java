@@ -253,9 +253,13 @@ class ConscryptEngineSocket extends OpenSSLSocketImpl implements SSLParametersIm
                         break;
                     }
                     case NEED_TASK: {
-                        // Should never get here, since our engine never provides tasks.
-                        close();
-                        throw new IllegalStateException("Engine tasks are unsupported");
+                        // Handshaking on a socket is blocking anyway, so just run the tasks
+                        // on this thread.
+                        Runnable task;
+                        while ((task = engine.getDelegatedTask()) != null) {
+                            task.run();
+                        }
+                        break;
                     }
                     case NOT_HANDSHAKING:
                     case FINISHED: {
@@ -468,6 +472,49 @@ class ConscryptEngineSocket extends OpenSSLSocketImpl implements SSLParametersIm
         engine.setUseSessionTickets(useSessionTickets);
     }
 
+    @Override
+    final void setKernelTlsEnabled(boolean enabled) {
+        // Kernel TLS needs the native SSL to own the socket's file descriptor, which is never
+        // the case for the engine-based socket.
+    }
+
+    @Override
+    final boolean isKernelTlsActive() {
+        return false;
+    }
+
+    @Override
+    final void setDynamicRecordSizing(int smallRecordSize, long boostThresholdBytes,
+            long boostTimeoutMillis, long idleTimeoutMillis) {
+        engine.setDynamicRecordSizing(
+                smallRecordSize, boostThresholdBytes, boostTimeoutMillis, idleTimeoutMillis);
+    }
+
+    @Override
+    final void setShedHandshakeConfig(boolean enabled) {
+        engine.setShedHandshakeConfig(enabled);
+    }
+
+    @Override
+    final long getNativeFootprint() {
+        return engine.getNativeFootprint();
+    }
+
+    @Override
+    final void setHandshakeTimingEnabled(boolean enabled) {
+        engine.setHandshakeTimingEnabled(enabled);
+    }
+
+    @Override
+    final long[] getHandshakeTimings() {
+        return engine.getHandshakeTimings();
+    }
+
+    @Override
+    final long[] getConnectionStats() {
+        return engine.getConnectionStats();
+    }
+
     @Override
     public final void setChannelIdEnabled(boolean enabled) {
         engine.setChannelIdEnabled(enabled);
@@ -16,6 +16,8 @@
 
 package org.conscrypt;
 
+import static org.conscrypt.Preconditions.checkArgument;
+import static org.conscrypt.Preconditions.checkNotNull;
 import static org.conscrypt.SSLUtils.EngineStates.STATE_CLOSED;
 import static org.conscrypt.SSLUtils.EngineStates.STATE_HANDSHAKE_COMPLETED;
 import static org.conscrypt.SSLUtils.EngineStates.STATE_HANDSHAKE_STARTED;
@@ -27,6 +29,7 @@ import org.conscrypt.ExternalSession.Provider;
 import org.conscrypt.NativeRef.SSL_SESSION;
 import org.conscrypt.metrics.StatsLog;
 
+import java.io.FileDescriptor;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
@@ -122,6 +125,17 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
 
     private long handshakeStartedMillis = 0;
 
+    /**
+     * Whether to hand the record layer over to the kernel once the handshake completes.
+     */
+    private boolean kernelTlsEnabled;
+
+    /**
+     * Whether the kernel accepted the transmit direction, which allows {@link #sendFile}
+     * to skip user space entirely.
+     */
+    private volatile boolean kernelTlsTx;
+
     // The constructors should not be called except from the Platform class, because we may
     // want to construct a subclass instead.
     ConscryptFileDescriptorSocket(SSLParametersImpl sslParameters) throws IOException {
@@ -233,6 +247,13 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
 
                 // Update the session from the current state of the SSL object.
                 activeSession.onPeerCertificateAvailable(getHostnameOrIP(), getPort());
+
+                if (kernelTlsEnabled) {
+                    // Best effort: a result of 0 means the kernel declined and the connection
+                    // keeps using the user-space record layer.
+                    int offloaded = ssl.enableKernelTls(Platform.getFileDescriptor(socket));
+                    kernelTlsTx = (offloaded & NativeCrypto.KTLS_TX) != 0;
+                }
             } catch (CertificateException e) {
                 SSLHandshakeException wrapper = new SSLHandshakeException(e.getMessage());
                 wrapper.initCause(e);
@@ -393,13 +414,13 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
     }
 
     @Override
-    public final void verifyCertificateChain(byte[][] certChain, String authMethod)
+    public final void verifyCertificateChain(long[] certificateRefs, String authMethod)
             throws CertificateException {
         try {
-            if (certChain == null || certChain.length == 0) {
+            if (certificateRefs == null || certificateRefs.length == 0) {
                 throw new CertificateException("Peer sent no certificate");
             }
-            X509Certificate[] peerCertChain = SSLUtils.decodeX509CertificateChain(certChain);
+            X509Certificate[] peerCertChain = PeerCertificateChain.decode(certificateRefs);
 
             X509TrustManager x509tm = sslParameters.getX509TrustManager();
             if (x509tm == null) {
@@ -567,6 +588,28 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
             return ssl.getPendingReadableBytes();
         }
 
+        long sendFile(FileDescriptor file, long offset, long count) throws IOException {
+            Platform.blockGuardOnNetwork();
+            checkOpen();
+            synchronized (writeLock) {
+                synchronized (ssl) {
+                    if (state == STATE_CLOSED) {
+                        throw new SocketException("socket is closed");
+                    }
+                }
+
+                long sent = ssl.sendFile(Platform.getFileDescriptor(socket), file, offset, count,
+                        writeTimeoutMilliseconds);
+
+                synchronized (ssl) {
+                    if (state == STATE_CLOSED) {
+                        throw new SocketException("socket is closed");
+                    }
+                }
+                return sent;
+            }
+        }
+
         void awaitPendingOps() {
             if (DBG_STATE) {
                 synchronized (ssl) {
@@ -782,6 +825,61 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
         sslParameters.setUseSessionTickets(useSessionTickets);
     }
 
+    @Override
+    final void setKernelTlsEnabled(boolean enabled) {
+        kernelTlsEnabled = enabled;
+    }
+
+    @Override
+    final boolean isKernelTlsActive() {
+        // The transmit direction is only offloaded once the receive direction is.
+        return kernelTlsTx;
+    }
+
+    @Override
+    final void setDynamicRecordSizing(int smallRecordSize, long boostThresholdBytes,
+            long boostTimeoutMillis, long idleTimeoutMillis) {
+        ssl.setDynamicRecordSizing(
+                smallRecordSize, boostThresholdBytes, boostTimeoutMillis, idleTimeoutMillis);
+    }
+
+    @Override
+    final void setShedHandshakeConfig(boolean enabled) {
+        sslParameters.setShedHandshakeConfig(enabled);
+    }
+
+    @Override
+    final long getNativeFootprint() {
+        return ssl.getNativeFootprint();
+    }
+
+    @Override
+    final void setHandshakeTimingEnabled(boolean enabled) {
+        sslParameters.setHandshakeTiming(enabled);
+    }
+
+    @Override
+    final long[] getHandshakeTimings() {
+        return ssl.getHandshakeTimings();
+    }
+
+    @Override
+    final long[] getConnectionStats() {
+        return ssl.getConnectionStats();
+    }
+
+    @Override
+    final long sendFile(FileDescriptor file, long offset, long count) throws IOException {
+        // Waits for the handshake, after which kernelTlsTx is final.
+        SSLOutputStream out = (SSLOutputStream) getOutputStream();
+        if (!kernelTlsTx) {
+            return super.sendFile(file, offset, count);
+        }
+        checkNotNull(file, "file");
+        checkArgument(offset >= 0 && count >= 0, "Invalid offset or count");
+        return out.sendFile(file, offset, count);
+    }
+
     /**
      * This method enables Server Name Indication.  If the hostname is not a valid SNI hostname,
      * the SNI extension will be omitted from the handshake.
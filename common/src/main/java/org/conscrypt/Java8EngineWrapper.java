@@ -97,6 +97,48 @@ final class Java8EngineWrapper extends AbstractConscryptEngine {
         delegate.setHandshakeListener(handshakeListener);
     }
 
+    @Override
+    void setAsyncCertificateVerification(boolean enabled) {
+        delegate.setAsyncCertificateVerification(enabled);
+    }
+
+    @Override
+    void setDynamicRecordSizing(int smallRecordSize, long boostThresholdBytes,
+            long boostTimeoutMillis, long idleTimeoutMillis) {
+        delegate.setDynamicRecordSizing(
+                smallRecordSize, boostThresholdBytes, boostTimeoutMillis, idleTimeoutMillis);
+    }
+
+    @Override
+    void setShedHandshakeConfig(boolean enabled) {
+        delegate.setShedHandshakeConfig(enabled);
+    }
+
+    @Override
+    long getNativeFootprint() {
+        return delegate.getNativeFootprint();
+    }
+
+    @Override
+    void setHandshakeTimingEnabled(boolean enabled) {
+        delegate.setHandshakeTimingEnabled(enabled);
+    }
+
+    @Override
+    long[] getHandshakeTimings() {
+        return delegate.getHandshakeTimings();
+    }
+
+    @Override
+    long[] getConnectionStats() {
+        return delegate.getConnectionStats();
+    }
+
+    @Override
+    void setAsyncCertificateSelection(boolean enabled) {
+        delegate.setAsyncCertificateSelection(enabled);
+    }
+
     @Override
     void setHostname(String hostname) {
         delegate.setHostname(hostname);
@@ -35,7 +35,6 @@ import java.security.cert.CertificateException;
 import java.security.cert.CertificateParsingException;
 import java.util.ArrayList;
 import java.util.Arrays;
-import java.util.Calendar;
 import java.util.HashSet;
 import java.util.List;
 import java.util.Set;
@@ -132,6 +131,20 @@ public final class NativeCrypto {
 
     static native long PEM_read_bio_PrivateKey(long bioCtx);
 
+    /** Used in the "which" mask of PEM_read_all, and as the kind of each object it returns. */
+    static final int PEM_X509 = 1;
+    static final int PEM_X509_CRL = 2;
+    static final int PEM_PRIVATE_KEY = 4;
+    static final int PEM_PUBLIC_KEY = 8;
+
+    /**
+     * Decodes every PEM block in {@code pem} whose kind is in the {@code which} mask and returns
+     * a {@code (kind, pointer)} pair for each, in order: X509, X509_CRL or EVP_PKEY pointers
+     * depending on the kind. Other blocks, including encrypted keys, are skipped. Decoding stops
+     * at the first malformed block of a requested kind.
+     */
+    static native long[] PEM_read_all(byte[] pem, int which);
+
     static native long getRSAPrivateKeyWrapper(PrivateKey key, byte[] modulus);
 
     static native long getECPrivateKeyWrapper(PrivateKey key, NativeRef.EC_GROUP ecGroupRef);
@@ -535,6 +548,14 @@ public final class NativeCrypto {
      */
     static final int GN_STACK_ISSUER_ALT_NAME = 2;
 
+    // Flags for X509_matches_host, which must match native_crypto.cc.
+
+    /** Matches the host against the iPAddress names instead of the dNSName names. */
+    static final int HOST_MATCH_IP_ADDRESS = 1;
+
+    /** Rejects wildcard names that match top-level domains, such as *.com. */
+    static final int HOST_MATCH_STRICT_WILDCARDS = 2;
+
     /**
      * Used to request only non-critical types in get_X509*_ext_oids.
      */
@@ -549,6 +570,21 @@ public final class NativeCrypto {
 
     static native long d2i_X509(byte[] encoded) throws ParsingException;
 
+    /**
+     * Parses the certificates found in {@code data} at the (offset, length) pairs in {@code spans}
+     * and returns their handles, with 0 for any that could not be parsed. If {@code errors} is not
+     * null, the error code of each failure is stored at its index.
+     */
+    static native long[] d2i_X509_batch(byte[] data, int[] spans, int[] errors);
+
+    /**
+     * Parses the certificate held by a handle returned by {@link #SSL_get0_peer_certificate_refs}.
+     * The returned X509 shares the handle's bytes rather than copying them.
+     */
+    static native long X509_parse_from_buffer(long buffer) throws ParsingException;
+
+    static native void CRYPTO_BUFFER_free(long buffer);
+
     static native long PEM_read_bio_X509(long bioCtx);
 
     static native byte[] i2d_X509(long x509ctx, OpenSSLX509Certificate holder);
@@ -594,6 +630,14 @@ public final class NativeCrypto {
                                                          OpenSSLX509Certificate holder, int type)
             throws CertificateParsingException;
 
+    /**
+     * Returns whether a subjectAltName of the certificate matches {@code host} under the rules of
+     * {@link OkHostnameVerifier}. Unless {@code flags} includes {@link #HOST_MATCH_IP_ADDRESS},
+     * {@code host} must already be in lower case.
+     */
+    static native boolean X509_matches_host(long x509ctx, OpenSSLX509Certificate holder,
+                                            String host, int flags);
+
     static native boolean[] get_X509_ex_kusage(long x509ctx, OpenSSLX509Certificate holder);
 
     static native String[] get_X509_ex_xkusage(long x509ctx, OpenSSLX509Certificate holder);
@@ -616,6 +660,13 @@ public final class NativeCrypto {
 
     static native byte[] get_X509_tbs_cert(long x509ctx, OpenSSLX509Certificate holder);
 
+    /**
+     * Returns the commonly used scalar fields of a certificate in one call, in the layout read by
+     * {@link X509CertificateFields}.
+     */
+    static native byte[] get_X509_fields(long x509ctx, OpenSSLX509Certificate holder)
+            throws ParsingException;
+
     static native byte[] get_X509_tbs_cert_without_ext(long x509ctx, OpenSSLX509Certificate holder,
                                                        String oid);
 
@@ -674,6 +725,30 @@ public final class NativeCrypto {
     /** Returns an array of X509_REVOKED that are owned by the caller. */
     static native long[] X509_CRL_get_REVOKED(long x509CrlCtx, OpenSSLX509CRL holder);
 
+    /**
+     * Returns the revocation date of each of the given X509_REVOKED handles, e.g. as returned by
+     * {@link #X509_CRL_get_REVOKED}, in milliseconds since the epoch, or {@link Long#MIN_VALUE}
+     * for a date that cannot be parsed.
+     */
+    static native long[] X509_REVOKED_get_revocationDates(long[] x509RevokedCtxs);
+
+    /**
+     * Copies the serial numbers listed by the CRL into an index to be released with
+     * {@link #X509_CRL_revocation_index_free}. The index does not refer to the CRL and may be
+     * queried from any thread.
+     */
+    static native long X509_CRL_revocation_index_new(long x509CrlCtx, OpenSSLX509CRL holder);
+
+    static native void X509_CRL_revocation_index_free(long indexCtx);
+
+    /**
+     * Returns, for each serial number in {@code serials}, whether the index lists it. Serial
+     * numbers are encoded as by {@link java.math.BigInteger#toByteArray} and located by
+     * {@code spans}, which holds an offset and a length for each.
+     */
+    static native boolean[] X509_CRL_revocation_index_lookup(NativeRef.REVOCATION_INDEX index,
+                                                             byte[] serials, int[] spans);
+
     static native String[] get_X509_CRL_ext_oids(long x509Crlctx, OpenSSLX509CRL holder,
                                                  int critical);
 
@@ -744,8 +819,8 @@ public final class NativeCrypto {
 
     // --- ASN1_TIME -----------------------------------------------------------
 
-    static native void ASN1_TIME_to_Calendar(long asn1TimeCtx, Calendar cal)
-            throws ParsingException;
+    /** Returns the time in milliseconds since the epoch. */
+    static native long ASN1_TIME_to_millis(long asn1TimeCtx) throws ParsingException;
 
     // --- ASN1 Encoding -------------------------------------------------------
 
@@ -1083,6 +1158,30 @@ public final class NativeCrypto {
     static native long SSL_CTX_set_timeout(long ssl_ctx, AbstractSessionContext holder,
                                            long seconds);
 
+    /**
+     * Offers and accepts compressed certificate chains (RFC 8879) on connections of the context.
+     * Returns {@code false} if no compression algorithm is available.
+     */
+    static native boolean SSL_CTX_enable_cert_compression(long ssl_ctx,
+                                                          AbstractSessionContext holder);
+
+    /**
+     * Caches successful certificate verifications of connections of the context that opted in
+     * with {@link #SSL_set_verify_cache_scope}, for at most {@code ttlMillis}. A {@code maxEntries}
+     * of 0 disables the cache.
+     */
+    static native void SSL_CTX_set_verify_cache(long ssl_ctx, AbstractSessionContext holder,
+                                                int maxEntries, long ttlMillis);
+
+    static native void SSL_CTX_clear_verify_cache(long ssl_ctx, AbstractSessionContext holder);
+
+    /**
+     * Returns the hits, misses and entries of the verification cache of the context, or
+     * {@code null} if it has none.
+     */
+    static native long[] SSL_CTX_get_verify_cache_stats(long ssl_ctx,
+                                                        AbstractSessionContext holder);
+
     static native long SSL_new(long ssl_ctx, AbstractSessionContext holder) throws SSLException;
 
     static native void SSL_enable_tls_channel_id(long ssl, NativeSsl ssl_holder)
@@ -1094,16 +1193,31 @@ public final class NativeCrypto {
                                                NativeRef.EVP_PKEY pkey);
 
     /**
-     * Sets the local certificates and private key.
+     * Builds a credential from a certificate chain and its private key that can be shared by any
+     * number of connections.
      *
-     * @param ssl the SSL reference.
-     * @param encodedCertificates the encoded form of the local certificate chain.
+     * @param encodedCertificates the encoded form of the certificate chain.
      * @param pkey a reference to the private key.
-     * @throws SSLException if a problem occurs setting the cert/key.
+     * @return the address of the credential, to be freed with {@link #SSL_CREDENTIAL_free}.
      */
-    static native void setLocalCertsAndPrivateKey(long ssl, NativeSsl ssl_holder,
-                                                  byte[][] encodedCertificates,
-                                                  NativeRef.EVP_PKEY pkey) throws SSLException;
+    static native long SSL_CREDENTIAL_new_x509(byte[][] encodedCertificates,
+                                               NativeRef.EVP_PKEY pkey);
+
+    static native void SSL_CREDENTIAL_free(long credential);
+
+    /**
+     * Adds a credential to those the connection may authenticate with. When several are added,
+     * the first one the peer supports, in the order added, is used.
+     */
+    static native void SSL_add1_credential(long ssl, NativeSsl ssl_holder,
+                                           NativeRef.SSL_CREDENTIAL credential)
+            throws SSLException;
+
+    /**
+     * Returns the address of the credential chosen by the current or last handshake, or 0 if
+     * none was chosen.
+     */
+    static native long SSL_get_selected_credential(long ssl, NativeSsl ssl_holder);
 
     static native void SSL_set_client_CA_list(long ssl, NativeSsl ssl_holder,
                                               byte[][] asn1DerEncodedX500Principals)
@@ -1356,6 +1470,48 @@ public final class NativeCrypto {
 
     static native void SSL_set_verify(long ssl, NativeSsl ssl_holder, int mode);
 
+    /**
+     * Enables asynchronous certificate verification. While enabled, the handshake does not call
+     * {@link SSLHandshakeCallbacks#verifyCertificateChain} but stops with
+     * {@code SSL_ERROR_WANT_CERTIFICATE_VERIFY} until a result is posted with
+     * {@link #SSL_set_cert_verify_result}.
+     */
+    static native void SSL_set_async_cert_verification(long ssl, NativeSsl ssl_holder,
+                                                       boolean enabled);
+
+    /**
+     * Returns the key exchange name of the cipher being negotiated, for use as the
+     * {@code authMethod} of an asynchronous certificate verification.
+     */
+    static native String SSL_get_pending_cipher_auth_method(long ssl, NativeSsl ssl_holder);
+
+    /**
+     * Posts the result of a pending asynchronous certificate verification. May be called from any
+     * thread.
+     *
+     * @throws IllegalStateException if no verification is pending
+     */
+    static native void SSL_set_cert_verify_result(long ssl, NativeSsl ssl_holder,
+                                                  boolean verified);
+
+    /**
+     * Enables asynchronous server certificate selection. While enabled, the handshake stops with
+     * {@code SSL_ERROR_PENDING_CERTIFICATE} after calling
+     * {@link SSLHandshakeCallbacks#serverCertificateRequested} until completion is reported with
+     * {@link #SSL_set_cert_selection_result}.
+     */
+    static native void SSL_set_async_cert_selection(long ssl, NativeSsl ssl_holder,
+                                                    boolean enabled);
+
+    /**
+     * Reports the outcome of a pending asynchronous certificate selection. May be called from any
+     * thread.
+     *
+     * @throws IllegalStateException if no selection is pending
+     */
+    static native void SSL_set_cert_selection_result(long ssl, NativeSsl ssl_holder,
+                                                     boolean selected);
+
     static native void SSL_set_session(long ssl, NativeSsl ssl_holder, long sslSessionNativePointer)
             throws SSLException;
 
@@ -1372,6 +1528,14 @@ public final class NativeCrypto {
             throws SSLException;
     static native String SSL_get_servername(long ssl, NativeSsl ssl_holder);
 
+    /**
+     * Lets verifications of the peer's chain be cached by the context. A cached verification is
+     * only reused by connections with the same {@code scope}, which must capture everything
+     * besides the chain and the authentication method that verification depends on.
+     */
+    static native void SSL_set_verify_cache_scope(long ssl, NativeSsl ssl_holder, String scope)
+            throws SSLException;
+
     static native void SSL_do_handshake(long ssl, NativeSsl ssl_holder, FileDescriptor fd,
                                         SSLHandshakeCallbacks shc, int timeoutMillis)
             throws SSLException, SocketTimeoutException, CertificateException;
@@ -1389,6 +1553,12 @@ public final class NativeCrypto {
      */
     static native byte[][] SSL_get0_peer_certificates(long ssl, NativeSsl ssl_holder);
 
+    /**
+     * Returns handles to the peer's certificates, to be released with {@link #CRYPTO_BUFFER_free},
+     * or {@code null} if the peer sent none.
+     */
+    static native long[] SSL_get0_peer_certificate_refs(long ssl, NativeSsl ssl_holder);
+
     /**
      * Reads with the native SSL_read function from the encrypted data stream
      * @return -1 if error or the end of the stream is reached.
@@ -1404,6 +1574,82 @@ public final class NativeCrypto {
                                  SSLHandshakeCallbacks shc, byte[] b, int off, int len,
                                  int writeTimeoutMillis) throws IOException;
 
+    /**
+     * Opts in to releasing the handshake configuration of the connection, and other state only
+     * needed during the handshake, once the handshake is done. Renegotiation is refused.
+     */
+    static native void SSL_set_shed_handshake_config(long ssl, NativeSsl ssl_holder,
+                                                     boolean enabled);
+
+    /**
+     * Returns the number of bytes of native memory Conscrypt holds for the connection, not
+     * counting allocations made by BoringSSL itself, including the handshake configuration
+     * released by {@link #SSL_set_shed_handshake_config}.
+     */
+    static native long SSL_get_native_footprint(long ssl, NativeSsl ssl_holder);
+
+    /**
+     * Starts or stops recording where the time of the connection's handshakes goes.
+     */
+    static native void SSL_set_handshake_timing(long ssl, NativeSsl ssl_holder, boolean enabled);
+
+    /**
+     * Returns the timings of the last completed handshake in the order of the fields of
+     * {@link Conscrypt.HandshakeTimings}, or {@code null} if none was recorded.
+     */
+    static native long[] SSL_get_handshake_timings(long ssl, NativeSsl ssl_holder);
+
+    /**
+     * Returns the traffic counters of the connection in the order of the fields of
+     * {@link Conscrypt.ConnectionStats}.
+     */
+    static native long[] SSL_get_connection_stats(long ssl, NativeSsl ssl_holder);
+
+    /**
+     * Configures dynamic record sizing: records carry at most {@code smallRecordSize} bytes of
+     * plaintext until {@code boostBytes} have been written, or {@code boostMillis} (no limit, if
+     * 0) have passed since the first of them was, counting from the handshake or from when the
+     * connection was last idle for {@code idleMillis} (never, if 0). They are full-sized
+     * otherwise. A {@code smallRecordSize} of 0 disables it.
+     */
+    static native void SSL_set_dynamic_record_sizing(long ssl, NativeSsl ssl_holder,
+                                                     int smallRecordSize, long boostBytes,
+                                                     long boostMillis, long idleMillis);
+
+    /**
+     * Hands the record layer of an established connection over to the kernel (Linux kTLS).
+     * Returns a mask of {@link #KTLS_TX} and {@link #KTLS_RX} describing the directions the
+     * kernel accepted, or 0 if the connection stays in user space, e.g. because the kernel or
+     * the negotiated cipher doesn't support it.
+     */
+    static native int SSL_enable_ktls(long ssl, NativeSsl ssl_holder, FileDescriptor fd)
+            throws IOException;
+
+    /**
+     * Reads up to {@code length} bytes of {@code file} at {@code position} into {@code buffer},
+     * without changing the file's position. Unlike {@link java.nio.channels.FileChannel}, an
+     * interrupt does not close the file. Returns the number of bytes read, or -1 at the end of
+     * the file. Not supported on Windows.
+     */
+    static native int pread(FileDescriptor file, byte[] buffer, int offset, int length,
+                            long position) throws IOException;
+
+    /**
+     * Writes {@code count} bytes of {@code file}, starting at {@code offset}, to a connection
+     * whose transmit direction has been handed to the kernel with {@link #SSL_enable_ktls}.
+     * The file contents never enter user space. Returns the number of bytes written, which is
+     * less than {@code count} only if the end of the file is reached.
+     */
+    static native long SSL_sendfile(long ssl, NativeSsl ssl_holder, FileDescriptor fd,
+                                    FileDescriptor file, long offset, long count,
+                                    int writeTimeoutMillis) throws IOException;
+
+    /** The kernel encrypts outgoing records; see {@link #SSL_enable_ktls}. */
+    static final int KTLS_TX = 1;
+
+    /** The kernel decrypts incoming records; see {@link #SSL_enable_ktls}. */
+    static final int KTLS_RX = 2;
+
     static native void SSL_interrupt(long ssl, NativeSsl ssl_holder);
     static native void SSL_shutdown(long ssl, NativeSsl ssl_holder, FileDescriptor fd,
                                     SSLHandshakeCallbacks shc) throws IOException;
@@ -1450,13 +1696,14 @@ public final class NativeCrypto {
         /**
          * Verify that the certificate chain is trusted.
          *
-         * @param certificateChain chain of X.509 certificates in their encoded form
+         * @param certificateRefs handles to the X.509 certificates of the chain, each of which the
+         *        callee takes ownership of, e.g. with {@link PeerCertificateChain#decode}
          * @param authMethod auth algorithm name
          *
          * @throws CertificateException if the certificate is untrusted
          */
         @SuppressWarnings("unused")
-        void verifyCertificateChain(byte[][] certificateChain, String authMethod)
+        void verifyCertificateChain(long[] certificateRefs, String authMethod)
                 throws CertificateException;
 
         /**
@@ -1641,6 +1888,52 @@ public final class NativeCrypto {
                                               int length, SSLHandshakeCallbacks shc)
             throws IOException;
 
+    /**
+     * Fused engine unwrap: writes {@code srcLength} bytes of ciphertext into the network BIO and
+     * then reads plaintext into the first {@code dstCount} destination address/length pairs,
+     * stopping at the first destination that isn't filled. The result packs the bytes consumed
+     * and produced, the SSL error that stopped the reads and whether more plaintext is pending;
+     * see the {@code UNWRAP_*} constants.
+     */
+    static native long ENGINE_SSL_unwrap_direct(long ssl, NativeSsl ssl_holder, long bioRef,
+                                                long srcAddress, int srcLength,
+                                                long[] dstAddresses, int[] dstLengths,
+                                                int dstCount, SSLHandshakeCallbacks shc)
+            throws IOException, CertificateException;
+
+    /** Mask for the bytes consumed and produced in the result of ENGINE_SSL_unwrap_direct. */
+    static final long UNWRAP_LENGTH_MASK = 0xFFFFFFL;
+
+    /** Shift of the bytes produced in the result of ENGINE_SSL_unwrap_direct. */
+    static final int UNWRAP_PRODUCED_SHIFT = 24;
+
+    /** Shift of the SSL error code in the result of ENGINE_SSL_unwrap_direct. */
+    static final int UNWRAP_ERROR_SHIFT = 48;
+
+    /** Set in the result of ENGINE_SSL_unwrap_direct if plaintext is still pending. */
+    static final long UNWRAP_PENDING_PLAINTEXT = 1L << 56;
+
+    /**
+     * Gathering variant of {@link #ENGINE_SSL_write_direct}: writes the first {@code count}
+     * address/length pairs as a single record. The lengths must add up to at most
+     * {@link NativeConstants#SSL3_RT_MAX_PLAIN_LENGTH}.
+     */
+    static native int ENGINE_SSL_write_direct_gather(long ssl, NativeSsl ssl_holder,
+                                                     long[] addresses, int[] lengths, int count,
+                                                     SSLHandshakeCallbacks shc)
+            throws IOException;
+
+    /**
+     * Writes the first {@code srcCount} address/length pairs of plaintext as a single record,
+     * sealing it directly into the destination address where it fits. The result packs the bytes
+     * consumed and produced and the SSL error of a failed write, as for
+     * {@link #ENGINE_SSL_unwrap_direct}.
+     */
+    static native long ENGINE_SSL_wrap_direct(long ssl, NativeSsl ssl_holder, long bioRef,
+                                              long[] srcAddresses, int[] srcLengths, int srcCount,
+                                              long dstAddress, int dstLength,
+                                              SSLHandshakeCallbacks shc) throws IOException;
+
     /**
      * Writes data from the given direct {@link java.nio.ByteBuffer} to the BIO.
      */
@@ -1674,6 +1967,14 @@ public final class NativeCrypto {
     static native byte[] Scrypt_generate_key(byte[] password, byte[] salt, int n, int r, int p,
                                              int key_len);
 
+    /**
+     * Returns the process-wide native memory counters: live SSL, SSL_CTX and Java-held
+     * SSL_SESSION objects, live AppData objects and their bytes, live engine BIOs and their bytes,
+     * and the buffers interned in the certificate pool since startup and their bytes, in that
+     * order.
+     */
+    static native long[] get_native_memory_stats();
+
     /**
      * Return {@code true} if BoringSSL has been built in FIPS mode.
      */
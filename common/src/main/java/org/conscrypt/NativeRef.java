@@ -162,6 +162,28 @@ abstract class NativeRef {
         }
     }
 
+    static final class REVOCATION_INDEX extends NativeRef {
+        REVOCATION_INDEX(long nativePointer) {
+            super(nativePointer);
+        }
+
+        @Override
+        void doFree(long context) {
+            NativeCrypto.X509_CRL_revocation_index_free(context);
+        }
+    }
+
+    static final class SSL_CREDENTIAL extends NativeRef {
+        SSL_CREDENTIAL(long nativePointer) {
+            super(nativePointer);
+        }
+
+        @Override
+        void doFree(long context) {
+            NativeCrypto.SSL_CREDENTIAL_free(context);
+        }
+    }
+
     static final class SSL_SESSION extends NativeRef {
         SSL_SESSION(long nativePointer) {
             super(nativePointer);
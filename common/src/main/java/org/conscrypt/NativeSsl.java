@@ -33,14 +33,17 @@ import java.io.FileDescriptor;
 import java.io.IOException;
 import java.net.SocketException;
 import java.nio.charset.StandardCharsets;
-import java.security.InvalidKeyException;
 import java.security.PrivateKey;
-import java.security.PublicKey;
 import java.security.cert.CertificateEncodingException;
 import java.security.cert.CertificateException;
 import java.security.cert.X509Certificate;
+import java.util.ArrayList;
 import java.util.Arrays;
-import java.util.HashSet;
+import java.util.Collections;
+import java.util.LinkedHashMap;
+import java.util.LinkedHashSet;
+import java.util.List;
+import java.util.Map;
 import java.util.Set;
 import java.util.concurrent.locks.ReadWriteLock;
 import java.util.concurrent.locks.ReentrantReadWriteLock;
@@ -60,7 +63,11 @@ final class NativeSsl {
     private final SSLHandshakeCallbacks handshakeCallbacks;
     private final AliasChooser aliasChooser;
     private final PSKCallbacks pskCallbacks;
-    private X509Certificate[] localCertificates;
+    private volatile X509Certificate[] localCertificates;
+    // The credentials added to the SSL, in order, with the chain each one authenticates with.
+    // Replaced rather than modified, so that it can be read without the lock.
+    private volatile Map<NativeRef.SSL_CREDENTIAL, X509Certificate[]> credentials =
+            Collections.emptyMap();
     private final ReadWriteLock lock = new ReentrantReadWriteLock();
     private volatile long ssl;
 
@@ -118,11 +125,133 @@ final class NativeSsl {
     }
 
     X509Certificate[] getPeerCertificates() throws CertificateException {
-        byte[][] encoded = NativeCrypto.SSL_get0_peer_certificates(ssl, this);
-        return encoded == null ? null : SSLUtils.decodeX509CertificateChain(encoded);
+        long[] refs = NativeCrypto.SSL_get0_peer_certificate_refs(ssl, this);
+        return refs == null ? null : PeerCertificateChain.decode(refs);
+    }
+
+    /**
+     * Returns the peer's certificate chain without decoding it, or {@code null} if the peer has
+     * not sent one.
+     */
+    PeerCertificateChain getPeerCertificateChain() {
+        long[] refs = NativeCrypto.SSL_get0_peer_certificate_refs(ssl, this);
+        return refs == null ? null : new PeerCertificateChain(refs);
+    }
+
+    String getPendingAuthMethod() {
+        return NativeCrypto.SSL_get_pending_cipher_auth_method(ssl, this);
+    }
+
+    /**
+     * Returns the number of bytes of native memory held for this connection outside of
+     * BoringSSL, or 0 once it has been closed. What BoringSSL frees when shedding the handshake
+     * configuration is therefore not visible here.
+     */
+    long getNativeFootprint() {
+        lock.readLock().lock();
+        try {
+            return isClosed() ? 0 : NativeCrypto.SSL_get_native_footprint(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    /**
+     * Returns the timings of the last completed handshake, or {@code null} if they weren't
+     * recorded or the connection has been closed.
+     */
+    long[] getHandshakeTimings() {
+        lock.readLock().lock();
+        try {
+            return isClosed() ? null : NativeCrypto.SSL_get_handshake_timings(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    /**
+     * Returns the traffic counters of this connection, or {@code null} once it has been closed.
+     */
+    long[] getConnectionStats() {
+        lock.readLock().lock();
+        try {
+            return isClosed() ? null : NativeCrypto.SSL_get_connection_stats(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    /**
+     * Limits records to {@code smallRecordSize} bytes of plaintext after the handshake and after
+     * the connection has been idle for {@code idleTimeoutMillis} (0 for never), until
+     * {@code boostThresholdBytes} have been written or {@code boostTimeoutMillis} (0 for no
+     * limit) have passed. This lets the peer start decrypting a response before a full-sized
+     * record has arrived. A {@code smallRecordSize} of 0 disables it.
+     */
+    void setDynamicRecordSizing(int smallRecordSize, long boostThresholdBytes,
+            long boostTimeoutMillis, long idleTimeoutMillis) {
+        NativeCrypto.SSL_set_dynamic_record_sizing(ssl, this, smallRecordSize,
+                boostThresholdBytes, boostTimeoutMillis, idleTimeoutMillis);
+    }
+
+    void setAsyncCertificateVerification(boolean enabled) {
+        NativeCrypto.SSL_set_async_cert_verification(ssl, this, enabled);
+    }
+
+    /**
+     * Posts the result of an asynchronous certificate verification. This may be called from any
+     * thread; the handshake consumes the result the next time it is resumed.
+     */
+    void setCertificateVerificationResult(boolean verified) throws SocketException {
+        lock.readLock().lock();
+        try {
+            if (isClosed()) {
+                throw new SocketException("Socket is closed");
+            }
+            NativeCrypto.SSL_set_cert_verify_result(ssl, this, verified);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    void setAsyncCertificateSelection(boolean enabled) {
+        NativeCrypto.SSL_set_async_cert_selection(ssl, this, enabled);
+    }
+
+    /**
+     * Reports whether an asynchronous server certificate selection succeeded. This may be called
+     * from any thread; the handshake picks it up the next time it is resumed.
+     */
+    void setCertificateSelectionResult(boolean selected) throws SocketException {
+        lock.readLock().lock();
+        try {
+            if (isClosed()) {
+                throw new SocketException("Socket is closed");
+            }
+            NativeCrypto.SSL_set_cert_selection_result(ssl, this, selected);
+        } finally {
+            lock.readLock().unlock();
+        }
     }
 
     X509Certificate[] getLocalCertificates() {
+        Map<NativeRef.SSL_CREDENTIAL, X509Certificate[]> credentials = this.credentials;
+        if (credentials.size() > 1) {
+            // Several chains were offered; report the one the handshake chose.
+            lock.readLock().lock();
+            try {
+                long selected =
+                        isClosed() ? 0 : NativeCrypto.SSL_get_selected_credential(ssl, this);
+                for (Map.Entry<NativeRef.SSL_CREDENTIAL, X509Certificate[]> entry :
+                        credentials.entrySet()) {
+                    if (entry.getKey().address == selected) {
+                        return entry.getValue();
+                    }
+                }
+            } finally {
+                lock.readLock().unlock();
+            }
+        }
         return localCertificates;
     }
 
@@ -231,40 +360,60 @@ final class NativeSsl {
     }
 
     private void setCertificate(String alias) throws CertificateEncodingException, SSLException {
+        installCredential(chooseCredential(alias));
+    }
+
+    /** A certificate chain and key chosen by the key manager, not yet offered to the peer. */
+    static final class ChosenCredential {
+        private final NativeRef.SSL_CREDENTIAL credential;
+        private final X509Certificate[] chain;
+
+        private ChosenCredential(NativeRef.SSL_CREDENTIAL credential, X509Certificate[] chain) {
+            this.credential = credential;
+            this.chain = chain;
+        }
+    }
+
+    /**
+     * Looks up the chain and key of {@code alias} and the shared credential for them, or returns
+     * {@code null} if there are none. This does not touch the native SSL.
+     */
+    private ChosenCredential chooseCredential(String alias)
+            throws CertificateEncodingException, SSLException {
         if (alias == null) {
-            return;
+            return null;
         }
         X509KeyManager keyManager = parameters.getX509KeyManager();
         if (keyManager == null) {
-            return;
+            return null;
         }
         PrivateKey privateKey = keyManager.getPrivateKey(alias);
         if (privateKey == null) {
-            return;
+            return null;
         }
-        localCertificates = keyManager.getCertificateChain(alias);
-        if (localCertificates == null) {
-            return;
+        X509Certificate[] chain = keyManager.getCertificateChain(alias);
+        if (chain == null) {
+            return null;
         }
-        int numLocalCerts = localCertificates.length;
-        PublicKey publicKey = (numLocalCerts > 0) ? localCertificates[0].getPublicKey() : null;
+        return new ChosenCredential(
+                parameters.getSessionContext().getCertificateCredentials().get(privateKey, chain),
+                chain);
+    }
 
-        // Encode the local certificates.
-        byte[][] encodedLocalCerts = new byte[numLocalCerts][];
-        for (int i = 0; i < numLocalCerts; ++i) {
-            encodedLocalCerts[i] = localCertificates[i].getEncoded();
+    private void installCredential(ChosenCredential chosen) throws SSLException {
+        if (chosen == null) {
+            return;
         }
-
-        // Convert the key so we can access a native reference.
-        final OpenSSLKey key;
-        try {
-            key = OpenSSLKey.fromPrivateKeyForTLSStackOnly(privateKey, publicKey);
-        } catch (InvalidKeyException e) {
-            throw new SSLException(e);
+        localCertificates = chosen.chain;
+
+        // Attach the shared credential for this chain and key, unless it already is.
+        if (!credentials.containsKey(chosen.credential)) {
+            NativeCrypto.SSL_add1_credential(ssl, this, chosen.credential);
+            Map<NativeRef.SSL_CREDENTIAL, X509Certificate[]> newCredentials =
+                    new LinkedHashMap<>(credentials);
+            newCredentials.put(chosen.credential, chosen.chain);
+            credentials = Collections.unmodifiableMap(newCredentials);
         }
-
-        // Set the local certs and private key.
-        NativeCrypto.setLocalCertsAndPrivateKey(ssl, this, encodedLocalCerts, key.getNativeRef());
     }
 
     String getVersion() {
@@ -442,6 +591,18 @@ final class NativeSsl {
             NativeCrypto.SSL_set_tlsext_host_name(ssl, this, hostname);
         }
 
+        // Verification of a server, or one that checks the peer's identity, depends on the peer's
+        // host; without a hostname, e.g. when connecting to an IP address, it is not cached.
+        AbstractSessionContext sessionContext = parameters.getSessionContext();
+        boolean needsHostname =
+                isClient() || parameters.getEndpointIdentificationAlgorithm() != null;
+        if (sessionContext.isVerificationCacheEnabled()
+                && parameters.getUnderlyingX509TrustManager() != null
+                && (hostname != null || !needsHostname)) {
+            NativeCrypto.SSL_set_verify_cache_scope(
+                    ssl, this, getVerificationCacheScope(sessionContext, hostname));
+        }
+
         // BEAST attack mitigation (1/n-1 record splitting for CBC cipher suites
         // with TLSv1 and SSLv3).
         NativeCrypto.SSL_set_mode(ssl, this, SSL_MODE_CBC_RECORD_SPLITTING);
@@ -450,23 +611,82 @@ final class NativeSsl {
             setCertificateValidation();
         }
         setTlsChannelId(channelIdPrivateKey);
+
+        if (parameters.shedHandshakeConfig) {
+            NativeCrypto.SSL_set_shed_handshake_config(ssl, this, true);
+        }
+        if (parameters.handshakeTiming) {
+            NativeCrypto.SSL_set_handshake_timing(ssl, this, true);
+        }
+    }
+
+    /**
+     * Returns what, besides the chain, the outcome of verifying the peer decides on: the trust
+     * manager, the mode, the host and how it is checked, and whether CT is required. The stapled
+     * OCSP response and SCTs are added natively. Each part is length-prefixed, so that different
+     * parts never encode the same.
+     */
+    private String getVerificationCacheScope(AbstractSessionContext sessionContext,
+                                             String hostname) {
+        StringBuilder scope = new StringBuilder();
+        scope.append(sessionContext.getVerificationCacheScope(
+                             parameters.getUnderlyingX509TrustManager()))
+                .append(isClient() ? ":client" : ":server");
+        appendScopePart(scope, hostname);
+        appendScopePart(scope, parameters.getEndpointIdentificationAlgorithm());
+        scope.append(parameters.isCTVerificationEnabled(hostname) ? ":ct" : ":noct");
+        return scope.toString();
+    }
+
+    private static void appendScopePart(StringBuilder scope, String part) {
+        if (part == null) {
+            scope.append(":-");
+        } else {
+            scope.append(':').append(part.length()).append(':').append(part);
+        }
     }
 
     void configureServerCertificate() throws IOException {
+        installServerCredentials(chooseServerCredentials(getServerKeyTypes()));
+    }
+
+    /**
+     * Checks the requested server name and returns the key types to choose server certificates
+     * for, in order of preference, or none on a client. This reads the native SSL.
+     */
+    Set<String> getServerKeyTypes() throws IOException {
         verifyWithSniMatchers(getRequestedServerName());
         if (isClient()) {
-            return;
+            return Collections.emptySet();
         }
+        return getCipherKeyTypes();
+    }
+
+    /**
+     * Asks the key manager for a certificate of each key type. This may block, e.g. to load a
+     * key, but does not touch the native SSL, so it needs no lock.
+     */
+    List<ChosenCredential> chooseServerCredentials(Set<String> keyTypes) throws IOException {
         X509KeyManager keyManager = parameters.getX509KeyManager();
-        if (keyManager != null) {
-            for (String keyType : getCipherKeyTypes()) {
-                try {
-                    setCertificate(aliasChooser.chooseServerAlias(keyManager, keyType));
-                } catch (CertificateEncodingException e) {
-                    throw new IOException(e);
-                }
+        if (keyManager == null) {
+            return Collections.emptyList();
+        }
+        List<ChosenCredential> chosen = new ArrayList<>(keyTypes.size());
+        for (String keyType : keyTypes) {
+            try {
+                chosen.add(chooseCredential(aliasChooser.chooseServerAlias(keyManager, keyType)));
+            } catch (CertificateEncodingException e) {
+                throw new IOException(e);
             }
         }
+        return chosen;
+    }
+
+    /** Offers the chosen certificates to the peer, in order. */
+    void installServerCredentials(List<ChosenCredential> chosen) throws IOException {
+        for (ChosenCredential credential : chosen) {
+            installCredential(credential);
+        }
     }
 
     private void verifyWithSniMatchers(String serverName) throws SSLHandshakeException {
@@ -479,8 +699,14 @@ final class NativeSsl {
         }
     }
 
+    /**
+     * Returns the key types of the enabled cipher suites, in the order the suites are preferred.
+     * Server certificates are offered in this order, and BoringSSL uses the first one the client
+     * supports, so e.g. an EC certificate is preferred to an RSA one when ECDSA suites come
+     * first.
+     */
     private Set<String> getCipherKeyTypes() {
-        Set<String> keyTypes = new HashSet<>();
+        Set<String> keyTypes = new LinkedHashSet<>();
         for (long sslCipherNativePointer : NativeCrypto.SSL_get_ciphers(ssl, this)) {
             String keyType = SSLUtils.getServerX509KeyType(sslCipherNativePointer);
             if (keyType != null) {
@@ -543,6 +769,33 @@ final class NativeSsl {
         }
     }
 
+    // TODO(nathanmittler): Remove once after we switch to the engine socket.
+    int enableKernelTls(FileDescriptor fd) throws IOException {
+        lock.readLock().lock();
+        try {
+            if (isClosed() || fd == null || !fd.valid()) {
+                throw new SocketException("Socket is closed");
+            }
+            return NativeCrypto.SSL_enable_ktls(ssl, this, fd);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    // TODO(nathanmittler): Remove once after we switch to the engine socket.
+    long sendFile(FileDescriptor fd, FileDescriptor file, long offset, long count,
+            int timeoutMillis) throws IOException {
+        lock.readLock().lock();
+        try {
+            if (isClosed() || fd == null || !fd.valid()) {
+                throw new SocketException("Socket is closed");
+            }
+            return NativeCrypto.SSL_sendfile(ssl, this, fd, file, offset, count, timeoutMillis);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     @SuppressWarnings("deprecation") // PSKKeyManager is deprecated, but in our own package
     private void enablePSKKeyManagerIfRequested() throws SSLException {
         // Enable Pre-Shared Key (PSK) key exchange if requested
@@ -676,6 +929,16 @@ final class NativeSsl {
         }
     }
 
+    int writeDirectByteBuffers(long[] addresses, int[] lengths, int count) throws IOException {
+        lock.readLock().lock();
+        try {
+            return NativeCrypto.ENGINE_SSL_write_direct_gather(ssl, this, addresses, lengths,
+                                                               count, handshakeCallbacks);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     void forceRead() throws IOException {
         lock.readLock().lock();
         try {
@@ -772,6 +1035,34 @@ final class NativeSsl {
             }
         }
 
+        long unwrapDirect(long srcAddress, int srcLength, long[] dstAddresses, int[] dstLengths,
+                int dstCount) throws IOException, CertificateException {
+            lock.readLock().lock();
+            try {
+                if (isClosed()) {
+                    throw new SSLException("Connection closed");
+                }
+                return NativeCrypto.ENGINE_SSL_unwrap_direct(ssl, NativeSsl.this, bio, srcAddress,
+                        srcLength, dstAddresses, dstLengths, dstCount, handshakeCallbacks);
+            } finally {
+                lock.readLock().unlock();
+            }
+        }
+
+        long wrapDirect(long[] srcAddresses, int[] srcLengths, int srcCount, long dstAddress,
+                int dstLength) throws IOException {
+            lock.readLock().lock();
+            try {
+                if (isClosed()) {
+                    throw new SSLException("Connection closed");
+                }
+                return NativeCrypto.ENGINE_SSL_wrap_direct(ssl, NativeSsl.this, bio, srcAddresses,
+                        srcLengths, srcCount, dstAddress, dstLength, handshakeCallbacks);
+            } finally {
+                lock.readLock().unlock();
+            }
+        }
+
         int readDirectByteBuffer(long destAddress, int destLength) throws IOException {
             lock.readLock().lock();
             try {
@@ -96,17 +96,20 @@ abstract class NativeSslSession {
             int count = buf.getInt();
             checkRemaining(buf, count);
 
-            java.security.cert.X509Certificate[] peerCerts =
-                    new java.security.cert.X509Certificate[count];
+            // Decode the certificates in place, in one native call.
+            int[] certSpans = new int[count * 2];
             for (int i = 0; i < count; i++) {
                 length = buf.getInt();
                 checkRemaining(buf, length);
 
-                byte[] certData = new byte[length];
-                buf.get(certData);
-                try {
-                    peerCerts[i] = OpenSSLX509Certificate.fromX509Der(certData);
-                } catch (Exception e) {
+                certSpans[2 * i] = buf.position();
+                certSpans[2 * i + 1] = length;
+                buf.position(buf.position() + length);
+            }
+            java.security.cert.X509Certificate[] peerCerts =
+                    OpenSSLX509Certificate.fromX509DerSpans(data, certSpans);
+            for (int i = 0; i < count; i++) {
+                if (peerCerts[i] == null) {
                     throw new IOException("Can not read certificate " + i + "/" + count);
                 }
             }
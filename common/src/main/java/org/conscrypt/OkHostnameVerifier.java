@@ -85,10 +85,26 @@ public final class OkHostnameVerifier implements ConscryptHostnameVerifier {
     }
 
     public boolean verify(String host, X509Certificate certificate) {
+        if (certificate instanceof OpenSSLX509Certificate) {
+            return verifyNative(host, (OpenSSLX509Certificate) certificate);
+        }
         return verifyAsIpAddress(host) ? verifyIpAddress(host, certificate)
                                        : verifyHostName(host, certificate);
     }
 
+    /**
+     * Matches the names natively, with the same rules as {@link #verifyIpAddress} and
+     * {@link #verifyHostName(String, X509Certificate)}. The host name is lowercased here because
+     * {@link String#toLowerCase} also maps some non-ASCII characters to ASCII.
+     */
+    private boolean verifyNative(String host, OpenSSLX509Certificate certificate) {
+        int flags = strictWildcardMode ? NativeCrypto.HOST_MATCH_STRICT_WILDCARDS : 0;
+        if (verifyAsIpAddress(host)) {
+            return certificate.matchesHost(host, flags | NativeCrypto.HOST_MATCH_IP_ADDRESS);
+        }
+        return certificate.matchesHost(host.toLowerCase(Locale.US), flags);
+    }
+
     static boolean verifyAsIpAddress(String host) {
         return VERIFY_AS_IP_ADDRESS.matcher(host).matches();
     }
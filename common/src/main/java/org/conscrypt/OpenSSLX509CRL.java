@@ -36,12 +36,10 @@ import java.security.cert.X509CRLEntry;
 import java.security.cert.X509Certificate;
 import java.util.ArrayList;
 import java.util.Arrays;
-import java.util.Calendar;
 import java.util.Date;
 import java.util.HashSet;
 import java.util.List;
 import java.util.Set;
-import java.util.TimeZone;
 
 import javax.crypto.BadPaddingException;
 import javax.crypto.IllegalBlockSizeException;
@@ -54,6 +52,8 @@ final class OpenSSLX509CRL extends X509CRL {
     private volatile long mContext;
     private final Date thisUpdate;
     private final Date nextUpdate;
+    // Built on the first lookup by serial number.
+    private volatile NativeRef.REVOCATION_INDEX revocationIndex;
 
     private OpenSSLX509CRL(long ctx) throws ParsingException {
         mContext = ctx;
@@ -64,11 +64,9 @@ final class OpenSSLX509CRL extends X509CRL {
     }
 
     // Package-visible because it's also used by OpenSSLX509CRLEntry
+    @SuppressWarnings("JavaUtilDate") // Needed for API compatibility
     static Date toDate(long asn1time) throws ParsingException {
-        Calendar calendar = Calendar.getInstance(TimeZone.getTimeZone("UTC"));
-        calendar.set(Calendar.MILLISECOND, 0);
-        NativeCrypto.ASN1_TIME_to_Calendar(asn1time, calendar);
-        return calendar.getTime();
+        return new Date(NativeCrypto.ASN1_TIME_to_millis(asn1time));
     }
 
     static OpenSSLX509CRL fromX509DerInputStream(InputStream is) throws ParsingException {
@@ -125,6 +123,27 @@ final class OpenSSLX509CRL extends X509CRL {
         }
     }
 
+    /**
+     * Decodes every CRL in a PEM document with a single native call. Decoding stops at the first
+     * malformed CRL.
+     */
+    static List<OpenSSLX509CRL> fromX509PemBytes(byte[] pem) {
+        long[] items = NativeCrypto.PEM_read_all(pem, NativeCrypto.PEM_X509_CRL);
+        List<OpenSSLX509CRL> crls = new ArrayList<>(items.length / 2);
+        for (int i = 0; i < items.length; i += 2) {
+            try {
+                crls.add(new OpenSSLX509CRL(items[i + 1]));
+            } catch (ParsingException e) {
+                // The failed CRL frees its own context; free the ones not reached.
+                for (int j = i + 2; j < items.length; j += 2) {
+                    NativeCrypto.X509_CRL_free(items[j + 1], null);
+                }
+                break;
+            }
+        }
+        return crls;
+    }
+
     static List<OpenSSLX509CRL> fromPkcs7PemInputStream(InputStream is) throws ParsingException {
         OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is, true);
 
@@ -296,8 +315,11 @@ final class OpenSSLX509CRL extends X509CRL {
 
     @Override
     public X509CRLEntry getRevokedCertificate(BigInteger serialNumber) {
-        final long revokedRef =
-                NativeCrypto.X509_CRL_get0_by_serial(mContext, this, serialNumber.toByteArray());
+        byte[] serial = serialNumber.toByteArray();
+        if (!isListed(serial)) {
+            return null;
+        }
+        final long revokedRef = NativeCrypto.X509_CRL_get0_by_serial(mContext, this, serial);
         if (revokedRef == 0) {
             return null;
         }
@@ -308,9 +330,57 @@ final class OpenSSLX509CRL extends X509CRL {
         }
     }
 
+    /**
+     * Returns, for each of the given serial numbers, whether this CRL lists it. The serial
+     * numbers are checked in one native call against an index of the CRL built on first use.
+     */
+    boolean[] areRevoked(BigInteger[] serialNumbers) {
+        byte[][] serials = new byte[serialNumbers.length][];
+        int[] spans = new int[2 * serialNumbers.length];
+        int total = 0;
+        for (int i = 0; i < serials.length; i++) {
+            serials[i] = serialNumbers[i].toByteArray();
+            spans[2 * i] = total;
+            spans[2 * i + 1] = serials[i].length;
+            total += serials[i].length;
+        }
+        byte[] packed = new byte[total];
+        for (int i = 0; i < serials.length; i++) {
+            System.arraycopy(serials[i], 0, packed, spans[2 * i], serials[i].length);
+        }
+        return NativeCrypto.X509_CRL_revocation_index_lookup(revocationIndex(), packed, spans);
+    }
+
+    /**
+     * Returns whether this CRL lists the given encoded serial number, for any issuer. A miss is
+     * final; a hit still has to be confirmed against the issuer by the caller.
+     */
+    private boolean isListed(byte[] serial) {
+        return NativeCrypto.X509_CRL_revocation_index_lookup(
+                revocationIndex(), serial, new int[] {0, serial.length})[0];
+    }
+
+    private NativeRef.REVOCATION_INDEX revocationIndex() {
+        NativeRef.REVOCATION_INDEX index = revocationIndex;
+        if (index == null) {
+            synchronized (this) {
+                index = revocationIndex;
+                if (index == null) {
+                    index = new NativeRef.REVOCATION_INDEX(
+                            NativeCrypto.X509_CRL_revocation_index_new(mContext, this));
+                    revocationIndex = index;
+                }
+            }
+        }
+        return index;
+    }
+
     @Override
     public X509CRLEntry getRevokedCertificate(X509Certificate certificate) {
         if (certificate instanceof OpenSSLX509Certificate) {
+            if (!isListed(certificate.getSerialNumber().toByteArray())) {
+                return null;
+            }
             OpenSSLX509Certificate osslCert = (OpenSSLX509Certificate) certificate;
             final long x509RevokedRef = NativeCrypto.X509_CRL_get0_by_cert(
                     mContext, this, osslCert.getContext(), osslCert);
@@ -335,14 +405,17 @@ final class OpenSSLX509CRL extends X509CRL {
         if (entryRefs == null || entryRefs.length == 0) {
             return null;
         }
+        // Read from the copies, since the CRL's own list may be reordered by a concurrent lookup.
+        final long[] revocationDates = NativeCrypto.X509_REVOKED_get_revocationDates(entryRefs);
 
         final Set<OpenSSLX509CRLEntry> crlSet = new HashSet<>();
-        for (long entryRef : entryRefs) {
-            try {
-                crlSet.add(new OpenSSLX509CRLEntry(entryRef));
-            } catch (ParsingException e) {
+        for (int i = 0; i < entryRefs.length; i++) {
+            if (revocationDates[i] == Long.MIN_VALUE) {
                 // Skip this entry
+                NativeCrypto.X509_REVOKED_free(entryRefs[i], null);
+                continue;
             }
+            crlSet.add(new OpenSSLX509CRLEntry(entryRefs[i], revocationDates[i]));
         }
 
         return crlSet;
@@ -387,6 +460,9 @@ final class OpenSSLX509CRL extends X509CRL {
         if (!(cert instanceof X509Certificate)) {
             return false;
         }
+        if (!isListed(((X509Certificate) cert).getSerialNumber().toByteArray())) {
+            return false;
+        }
 
         final OpenSSLX509Certificate osslCert;
         if (cert instanceof OpenSSLX509Certificate) {
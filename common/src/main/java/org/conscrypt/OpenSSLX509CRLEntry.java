@@ -42,6 +42,16 @@ final class OpenSSLX509CRLEntry extends X509CRLEntry {
                 OpenSSLX509CRL.toDate(NativeCrypto.get_X509_REVOKED_revocationDate(mContext, this));
     }
 
+    /**
+     * Creates an entry whose revocation date was already read, in milliseconds since the epoch,
+     * e.g. by {@link NativeCrypto#X509_REVOKED_get_revocationDates}.
+     */
+    @SuppressWarnings("JavaUtilDate") // Needed for API compatibility
+    OpenSSLX509CRLEntry(long ctx, long revocationDate) {
+        mContext = ctx;
+        this.revocationDate = new Date(revocationDate);
+    }
+
     @Override
     public Set<String> getCriticalExtensionOIDs() {
         String[] critOids = NativeCrypto.get_X509_REVOKED_ext_oids(
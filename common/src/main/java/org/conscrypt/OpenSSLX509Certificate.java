@@ -41,14 +41,12 @@ import java.security.spec.InvalidKeySpecException;
 import java.security.spec.X509EncodedKeySpec;
 import java.util.ArrayList;
 import java.util.Arrays;
-import java.util.Calendar;
 import java.util.Collection;
 import java.util.Collections;
 import java.util.Date;
 import java.util.HashSet;
 import java.util.List;
 import java.util.Set;
-import java.util.TimeZone;
 
 import javax.crypto.BadPaddingException;
 import javax.crypto.IllegalBlockSizeException;
@@ -63,23 +61,20 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     private transient volatile long mContext;
     private transient Integer mHashCode;
+    private final transient X509CertificateFields fields;
 
     private final Date notBefore;
     private final Date notAfter;
 
+    @SuppressWarnings("JavaUtilDate") // Needed for API compatibility
     OpenSSLX509Certificate(long ctx) throws ParsingException {
         mContext = ctx;
         // The legacy X509 OpenSSL APIs don't validate ASN1_TIME structures until access, so
-        // parse them here because this is the only time we're allowed to throw ParsingException
-        notBefore = toDate(NativeCrypto.X509_get_notBefore(mContext, this));
-        notAfter = toDate(NativeCrypto.X509_get_notAfter(mContext, this));
-    }
-
-    private static Date toDate(long asn1time) throws ParsingException {
-        Calendar calendar = Calendar.getInstance(TimeZone.getTimeZone("UTC"));
-        calendar.set(Calendar.MILLISECOND, 0);
-        NativeCrypto.ASN1_TIME_to_Calendar(asn1time, calendar);
-        return calendar.getTime();
+        // parse them here because this is the only time we're allowed to throw ParsingException.
+        // The other fields most getters need come back in the same call.
+        fields = X509CertificateFields.read(mContext, this);
+        notBefore = new Date(fields.notBefore());
+        notAfter = new Date(fields.notAfter());
     }
 
     public static OpenSSLX509Certificate fromX509DerInputStream(InputStream is)
@@ -108,6 +103,26 @@ public final class OpenSSLX509Certificate extends X509Certificate {
         }
     }
 
+    /**
+     * Decodes the certificates found in {@code data} at the (offset, length) pairs in
+     * {@code spans} with a single native call. Entries that cannot be decoded are {@code null}.
+     */
+    static OpenSSLX509Certificate[] fromX509DerSpans(byte[] data, int[] spans) {
+        long[] certRefs = NativeCrypto.d2i_X509_batch(data, spans, null);
+        OpenSSLX509Certificate[] certs = new OpenSSLX509Certificate[certRefs.length];
+        for (int i = 0; i < certRefs.length; i++) {
+            if (certRefs[i] == 0) {
+                continue;
+            }
+            try {
+                certs[i] = new OpenSSLX509Certificate(certRefs[i]);
+            } catch (ParsingException ignored) {
+                // Leave it null, as if it had failed to parse.
+            }
+        }
+        return certs;
+    }
+
     public static List<OpenSSLX509Certificate> fromPkcs7DerInputStream(InputStream is)
             throws ParsingException {
         OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is, true);
@@ -154,6 +169,27 @@ public final class OpenSSLX509Certificate extends X509Certificate {
         }
     }
 
+    /**
+     * Decodes every certificate in a PEM document with a single native call. Decoding stops at the
+     * first malformed certificate.
+     */
+    static List<OpenSSLX509Certificate> fromX509PemBytes(byte[] pem) {
+        long[] items = NativeCrypto.PEM_read_all(pem, NativeCrypto.PEM_X509);
+        List<OpenSSLX509Certificate> certs = new ArrayList<>(items.length / 2);
+        for (int i = 0; i < items.length; i += 2) {
+            try {
+                certs.add(new OpenSSLX509Certificate(items[i + 1]));
+            } catch (ParsingException e) {
+                // The failed certificate frees its own context; free the ones not reached.
+                for (int j = i + 2; j < items.length; j += 2) {
+                    NativeCrypto.X509_free(items[j + 1], null);
+                }
+                break;
+            }
+        }
+        return certs;
+    }
+
     public static List<OpenSSLX509Certificate> fromPkcs7PemInputStream(InputStream is)
             throws ParsingException {
         OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is, true);
@@ -237,8 +273,7 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public boolean hasUnsupportedCriticalExtension() {
-        return (NativeCrypto.get_X509_ex_flags(mContext, this) & NativeConstants.EXFLAG_CRITICAL)
-                != 0;
+        return (fields.extensionFlags() & NativeConstants.EXFLAG_CRITICAL) != 0;
     }
 
     @Override
@@ -267,7 +302,7 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public int getVersion() {
-        return (int) NativeCrypto.X509_get_version(mContext, this) + 1;
+        return fields.version() + 1;
     }
 
     @Override
@@ -323,7 +358,7 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public String getSigAlgOID() {
-        return NativeCrypto.get_X509_sig_alg_oid(mContext, this);
+        return fields.sigAlgOid();
     }
 
     @Override
@@ -359,7 +394,7 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public int getBasicConstraints() {
-        if ((NativeCrypto.get_X509_ex_flags(mContext, this) & NativeConstants.EXFLAG_CA) == 0) {
+        if ((fields.extensionFlags() & NativeConstants.EXFLAG_CA) == 0) {
             return -1;
         }
 
@@ -529,6 +564,14 @@ public final class OpenSSLX509Certificate extends X509Certificate {
                 mContext, this, NativeCrypto.GN_STACK_SUBJECT_ALT_NAME));
     }
 
+    /**
+     * Returns whether a subjectAltName matches {@code host}, without converting the names to Java
+     * objects. See {@link NativeCrypto#X509_matches_host}.
+     */
+    boolean matchesHost(String host, int flags) {
+        return NativeCrypto.X509_matches_host(mContext, this, host, flags);
+    }
+
     @Override
     public Collection<List<?>> getIssuerAlternativeNames() throws CertificateParsingException {
         return alternativeNameArrayToList(NativeCrypto.get_X509_GENERAL_NAME_stack(
@@ -16,6 +16,7 @@
 
 package org.conscrypt;
 
+import java.io.ByteArrayOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.PushbackInputStream;
@@ -46,6 +47,7 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
     private static final int VALUE_0 = 0x30; // Value of '0'
 
     private static final int PUSHBACK_SIZE = 64;
+    private static final int READ_BUFFER_SIZE = 8192;
 
     static class ParsingException extends Exception {
         private static final long serialVersionUID = 8390802697728301325L;
@@ -97,6 +99,21 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
         return idx < header.length && header[idx] == 0x06;
     }
 
+    private static boolean isPem(byte[] header, int len) {
+        return len >= PEM_MARKER.length
+                && Arrays.equals(PEM_MARKER, Arrays.copyOf(header, PEM_MARKER.length));
+    }
+
+    private static byte[] readRemaining(InputStream is) throws IOException {
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        byte[] buffer = new byte[READ_BUFFER_SIZE];
+        int len;
+        while ((len = is.read(buffer)) != -1) {
+            out.write(buffer, 0, len);
+        }
+        return out.toByteArray();
+    }
+
     /**
      * The code for X509 Certificates and CRL is pretty much the same. We use
      * this abstract class to share the code between them. This makes it ugly,
@@ -197,6 +214,12 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
                 if (isMaybePkcs7(buffer)) {
                     return fromPkcs7DerInputStream(pbis);
                 }
+
+                // A PEM bundle is decoded in one native pass rather than through a stream that
+                // BoringSSL reads line by line.
+                if (isPem(buffer, len)) {
+                    return fromX509PemBytes(readRemaining(pbis));
+                }
             } catch (Exception e) {
                 if (markable) {
                     try {
@@ -250,6 +273,11 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
 
         protected abstract T fromX509DerInputStream(InputStream pbis) throws ParsingException;
 
+        /**
+         * Decodes every item in a PEM document, stopping at the first malformed one.
+         */
+        protected abstract List<? extends T> fromX509PemBytes(byte[] pem) throws ParsingException;
+
         protected abstract List<? extends T> fromPkcs7PemInputStream(InputStream is)
                 throws ParsingException;
 
@@ -271,6 +299,12 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
                     return OpenSSLX509Certificate.fromX509DerInputStream(is);
                 }
 
+                @Override
+                public List<? extends OpenSSLX509Certificate> fromX509PemBytes(byte[] pem)
+                        throws ParsingException {
+                    return OpenSSLX509Certificate.fromX509PemBytes(pem);
+                }
+
                 @Override
                 public List<? extends OpenSSLX509Certificate> fromPkcs7PemInputStream(
                         InputStream is) throws ParsingException {
@@ -295,6 +329,12 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
             return OpenSSLX509CRL.fromX509DerInputStream(is);
         }
 
+        @Override
+        public List<? extends OpenSSLX509CRL> fromX509PemBytes(byte[] pem)
+                throws ParsingException {
+            return OpenSSLX509CRL.fromX509PemBytes(pem);
+        }
+
         @Override
         public List<? extends OpenSSLX509CRL> fromPkcs7PemInputStream(InputStream is)
                 throws ParsingException {
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import org.conscrypt.OpenSSLX509CertificateFactory.ParsingException;
+
+import java.security.cert.CertificateException;
+import java.security.cert.X509Certificate;
+
+/**
+ * A certificate chain received from the peer, held as references to the native buffers BoringSSL
+ * received it in. Nothing is copied until asked for: the certificates are decoded on the first
+ * call to {@link #getCertificates()}, sharing the native bytes, and the references are released
+ * as soon as they are.
+ */
+final class PeerCertificateChain {
+    private final int length;
+    // Guarded by this; null once decoded or released.
+    private long[] refs;
+    private X509Certificate[] certificates;
+    private CertificateException failure;
+
+    /**
+     * Takes ownership of the given handles, as returned by
+     * {@link NativeCrypto#SSL_get0_peer_certificate_refs}.
+     */
+    PeerCertificateChain(long[] refs) {
+        this.length = refs.length;
+        this.refs = refs;
+    }
+
+    /**
+     * Decodes the given handles, as returned by
+     * {@link NativeCrypto#SSL_get0_peer_certificate_refs}, and releases them.
+     */
+    static X509Certificate[] decode(long[] refs) throws CertificateException {
+        X509Certificate[] result = new X509Certificate[refs.length];
+        int i = 0;
+        try {
+            for (; i < refs.length; i++) {
+                // The X509 takes its own reference to the buffer.
+                result[i] = new OpenSSLX509Certificate(
+                        NativeCrypto.X509_parse_from_buffer(refs[i]));
+                NativeCrypto.CRYPTO_BUFFER_free(refs[i]);
+            }
+        } catch (ParsingException e) {
+            throw new CertificateException(e);
+        } finally {
+            for (; i < refs.length; i++) {
+                NativeCrypto.CRYPTO_BUFFER_free(refs[i]);
+            }
+        }
+        return result;
+    }
+
+    int length() {
+        return length;
+    }
+
+    synchronized X509Certificate[] getCertificates() throws CertificateException {
+        if (certificates == null && failure == null) {
+            long[] toDecode = refs;
+            refs = null;
+            try {
+                certificates = decode(toDecode);
+            } catch (CertificateException e) {
+                failure = e;
+            }
+        }
+        if (failure != null) {
+            throw failure;
+        }
+        return certificates.clone();
+    }
+
+    @Override
+    @SuppressWarnings("Finalize")
+    protected void finalize() throws Throwable {
+        try {
+            // Only reached if the chain was never decoded.
+            synchronized (this) {
+                if (refs != null) {
+                    for (long ref : refs) {
+                        NativeCrypto.CRYPTO_BUFFER_free(ref);
+                    }
+                    refs = null;
+                }
+            }
+        } finally {
+            super.finalize();
+        }
+    }
+}
@@ -69,6 +69,9 @@ final class SSLParametersImpl implements Cloneable {
     private final PSKKeyManager pskKeyManager;
     // source of X.509 certificate based authentication trust decisions or null if not provided
     private final X509TrustManager x509TrustManager;
+    // the trust manager that makes the decisions of x509TrustManager, which differs from it when
+    // x509TrustManager only forwards to it on behalf of a socket
+    private X509TrustManager underlyingX509TrustManager;
     // source of Spake trust or null if not provided
     private final Spake2PlusTrustManager spake2PlusTrustManager;
     // source of Spake authentication or null if not provided
@@ -109,6 +112,8 @@ final class SSLParametersImpl implements Cloneable {
     byte[] applicationProtocols = EmptyArray.BYTE;
     ApplicationProtocolSelectorAdapter applicationProtocolSelector;
     boolean useSessionTickets;
+    boolean shedHandshakeConfig;
+    boolean handshakeTiming;
     private Boolean useSni;
 
     /**
@@ -163,6 +168,7 @@ final class SSLParametersImpl implements Cloneable {
                         "Spake2PlusTrustManager should not be set with X509TrustManager");
             }
         }
+        underlyingX509TrustManager = x509TrustManager;
         if ((spake2PlusTrustManager != null) != (spake2PlusKeyManager != null)) {
             throw new KeyManagementException(
                     "Spake2PlusTrustManager and Spake2PlusKeyManager should be set together");
@@ -213,6 +219,7 @@ final class SSLParametersImpl implements Cloneable {
         this.x509KeyManager = x509KeyManager;
         this.pskKeyManager = pskKeyManager;
         this.x509TrustManager = x509TrustManager;
+        this.underlyingX509TrustManager = x509TrustManager;
         this.spake2PlusKeyManager = spake2PlusKeyManager;
         this.spake2PlusTrustManager = spake2PlusTrustManager;
 
@@ -238,6 +245,8 @@ final class SSLParametersImpl implements Cloneable {
                 : sslParams.applicationProtocols.clone();
         this.applicationProtocolSelector = sslParams.applicationProtocolSelector;
         this.useSessionTickets = sslParams.useSessionTickets;
+        this.shedHandshakeConfig = sslParams.shedHandshakeConfig;
+        this.handshakeTiming = sslParams.handshakeTiming;
         this.useSni = sslParams.useSni;
         this.channelIdEnabled = sslParams.channelIdEnabled;
         this.namedGroups = (sslParams.namedGroups == null) ? null : sslParams.namedGroups.clone();
@@ -314,6 +323,13 @@ final class SSLParametersImpl implements Cloneable {
         return x509TrustManager;
     }
 
+    /**
+     * Returns the trust manager that decides what {@link #getX509TrustManager()} trusts.
+     */
+    X509TrustManager getUnderlyingX509TrustManager() {
+        return underlyingX509TrustManager;
+    }
+
     /*
      * Returns the names of enabled cipher suites.
      */
@@ -476,6 +492,21 @@ final class SSLParametersImpl implements Cloneable {
         this.useSessionTickets = useSessionTickets;
     }
 
+    /*
+     * Whether connections release their handshake configuration once the
+     * handshake is done.
+     */
+    void setShedHandshakeConfig(boolean shedHandshakeConfig) {
+        this.shedHandshakeConfig = shedHandshakeConfig;
+    }
+
+    /*
+     * Whether connections record where the time of their handshakes goes.
+     */
+    void setHandshakeTiming(boolean handshakeTiming) {
+        this.handshakeTiming = handshakeTiming;
+    }
+
     /*
      * Whether connections using this SSL connection should use the TLS
      * extension Server Name Indication (SNI).
@@ -609,9 +640,16 @@ final class SSLParametersImpl implements Cloneable {
         }
     }
 
+    /**
+     * Returns a copy that uses {@code newTrustManager}, which must forward its decisions to the
+     * trust manager of this instance.
+     */
     SSLParametersImpl cloneWithTrustManager(X509TrustManager newTrustManager) {
-        return new SSLParametersImpl(clientSessionContext, serverSessionContext, x509KeyManager,
-                                     pskKeyManager, newTrustManager, null, null, this);
+        SSLParametersImpl result =
+                new SSLParametersImpl(clientSessionContext, serverSessionContext, x509KeyManager,
+                                      pskKeyManager, newTrustManager, null, null, this);
+        result.underlyingX509TrustManager = underlyingX509TrustManager;
+        return result;
     }
 
     SSLParametersImpl cloneWithSpake() {
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import org.conscrypt.OpenSSLX509CertificateFactory.ParsingException;
+
+import java.nio.BufferUnderflowException;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * The scalar fields of a certificate read by {@link NativeCrypto#get_X509_fields} in a single
+ * call, so that the getters of {@link OpenSSLX509Certificate} which only need scalars do not each
+ * cross into native code. Byte string fields keep their own natives, which copy them out of the
+ * encodings BoringSSL retains from parsing.
+ */
+final class X509CertificateFields {
+    // Must match kX509FieldsVersion in native_crypto.cc.
+    private static final int VERSION = 3;
+
+    private final int version;
+    private final long notBefore;
+    private final long notAfter;
+    private final int extensionFlags;
+    private final String sigAlgOid;
+
+    private X509CertificateFields(int version, long notBefore, long notAfter, int extensionFlags,
+                                  String sigAlgOid) {
+        this.version = version;
+        this.notBefore = notBefore;
+        this.notAfter = notAfter;
+        this.extensionFlags = extensionFlags;
+        this.sigAlgOid = sigAlgOid;
+    }
+
+    static X509CertificateFields read(long x509ctx, OpenSSLX509Certificate holder)
+            throws ParsingException {
+        return parse(NativeCrypto.get_X509_fields(x509ctx, holder));
+    }
+
+    static X509CertificateFields parse(byte[] fields) throws ParsingException {
+        try {
+            ByteBuffer buf = ByteBuffer.wrap(fields);
+            if (buf.getInt() != VERSION) {
+                throw new ParsingException("Unsupported X.509 fields layout");
+            }
+            int version = buf.getInt();
+            long notBefore = buf.getLong();
+            long notAfter = buf.getLong();
+            int extensionFlags = buf.getInt();
+            byte[] sigAlgOid = new byte[buf.getInt()];
+            buf.get(sigAlgOid);
+            return new X509CertificateFields(version, notBefore, notAfter, extensionFlags,
+                                             new String(sigAlgOid, StandardCharsets.US_ASCII));
+        } catch (BufferUnderflowException | NegativeArraySizeException e) {
+            throw new ParsingException(e);
+        }
+    }
+
+    /** Returns the zero-based X.509 version. */
+    int version() {
+        return version;
+    }
+
+    /** Returns the start of the validity period in milliseconds since the epoch. */
+    long notBefore() {
+        return notBefore;
+    }
+
+    /** Returns the end of the validity period in milliseconds since the epoch. */
+    long notAfter() {
+        return notAfter;
+    }
+
+    int extensionFlags() {
+        return extensionFlags;
+    }
+
+    /** Returns the signature algorithm OID in dotted form. */
+    String sigAlgOid() {
+        return sigAlgOid;
+    }
+}
@@ -18,8 +18,10 @@ package org.conscrypt;
 
 import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
 import static org.junit.Assert.assertNull;
 import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertTrue;
 import static org.junit.Assert.fail;
 
 import org.conscrypt.TestUtils.BufferType;
@@ -196,6 +198,21 @@ public class BufferUtilsTest {
         assertSame(buffers[2], BufferUtils.getBufferLargerThan(buffers, K16));
     }
 
+    @Test
+    public void isDirect() {
+        for (int[] sizes : TEST_SIZES) {
+            // Arrays without any data remaining are trivially direct.
+            boolean expected = bufferType == BufferType.DIRECT || arraySum(sizes) == 0;
+            assertEquals(expected, BufferUtils.isDirect(bufferType.newRandomBuffers(sizes)));
+        }
+
+        // Empty buffers of another type don't matter.
+        ByteBuffer[] mixed = {ByteBuffer.allocate(0), ByteBuffer.allocateDirect(100)};
+        assertTrue(BufferUtils.isDirect(mixed));
+        mixed[0] = ByteBuffer.allocate(1);
+        assertFalse(BufferUtils.isDirect(mixed));
+    }
+
     private int arraySum(int[] sizes) {
         int sum = 0;
         for (int i : sizes) {
@@ -70,12 +70,17 @@ public final class HostnameVerifierTest {
     public static Collection<Object[]> data() {
         // Both verifiers should behave the same in all tests except for
         // subjectAltNameWithToplevelWildcard(), and that test is not parameterized for clarity.
-        return Arrays.asList(new Object[][] {{OkHostnameVerifier.INSTANCE},
-                                             {OkHostnameVerifier.strictInstance()}});
+        // Each runs against both the platform's certificates and OpenSSLX509Certificates, which
+        // the verifier matches natively.
+        return Arrays.asList(new Object[][] {{OkHostnameVerifier.INSTANCE, false},
+                                             {OkHostnameVerifier.INSTANCE, true},
+                                             {OkHostnameVerifier.strictInstance(), false},
+                                             {OkHostnameVerifier.strictInstance(), true}});
     }
 
-    @Parameter public OkHostnameVerifier verifier;
+    @Parameter(0) public OkHostnameVerifier verifier;
     // END Android-changed: Run tests for both default and strict verifiers. http://b/144694112
+    @Parameter(1) public boolean openSslCertificates;
 
     @Test
     public void verify() throws Exception {
@@ -503,6 +508,34 @@ public final class HostnameVerifierTest {
         assertFalse(verifier.verify(certs, "127.0.0.2", session));
     }
 
+    @Test
+    public void subjectAltMatchesNormalizedHost() throws Exception {
+        // The certificate of subjectAltUsesLocalDomainAndIp().
+        X509Certificate certificate =
+                certificate(""
+                            + "-----BEGIN CERTIFICATE-----\n"
+                            + "MIIBWDCCAQKgAwIBAgIJANS1EtICX2AZMA0GCSqGSIb3DQEBBQUAMBQxEjAQBgNV\n"
+                            + "BAMTCWxvY2FsaG9zdDAgFw0xMjAxMDIxOTA4NThaGA8yMTExMTIwOTE5MDg1OFow\n"
+                            + "FDESMBAGA1UEAxMJbG9jYWxob3N0MFwwDQYJKoZIhvcNAQEBBQADSwAwSAJBAPpt\n"
+                            + "atK8r4/hf4hSIs0os/BSlQLbRBaK9AfBReM4QdAklcQqe6CHsStKfI8pp0zs7Ptg\n"
+                            + "PmMdpbttL0O7mUboBC8CAwEAAaM1MDMwMQYDVR0RBCowKIIVbG9jYWxob3N0Lmxv\n"
+                            + "Y2FsZG9tYWlugglsb2NhbGhvc3SHBH8AAAEwDQYJKoZIhvcNAQEFBQADQQD0ntfL\n"
+                            + "DCzOCv9Ma6Lv5o5jcYWVxvBSTsnt22hsJpWD1K7iY9lbkLwl0ivn73pG2evsAn9G\n"
+                            + "X8YKH52fnHsCrhSD\n"
+                            + "-----END CERTIFICATE-----");
+
+        assertTrue(verifier.verify("localhost", certificate));
+        assertTrue(verifier.verify("LOCALHOST", certificate));
+        assertTrue(verifier.verify("localhost.", certificate));
+        assertTrue(verifier.verify("localhost.localdomain", certificate));
+        assertFalse(verifier.verify("local.host", certificate));
+        assertFalse(verifier.verify(".localhost", certificate));
+        assertFalse(verifier.verify("127.0.0.1.localhost", certificate));
+
+        assertTrue(verifier.verify("127.0.0.1", certificate));
+        assertFalse(verifier.verify("127.0.0.2", certificate));
+    }
+
     @Test
     public void wildcardsCannotMatchIpAddresses() throws Exception {
         // openssl req -x509 -nodes -days 36500 -subj '/CN=*.0.0.1' -newkey rsa:512 -out cert.pem
@@ -675,6 +708,10 @@ public final class HostnameVerifierTest {
     }
 
     private X509Certificate certificate(String certificate) throws Exception {
+        if (openSslCertificates) {
+            return OpenSSLX509Certificate.fromX509PemInputStream(
+                    new ByteArrayInputStream(certificate.getBytes(UTF_8)));
+        }
         return (X509Certificate) CertificateFactory.getInstance("X.509").generateCertificate(
                 new ByteArrayInputStream(certificate.getBytes(UTF_8)));
     }
@@ -136,7 +136,7 @@ public class NativeCryptoArgTest {
                                       .hasArg(0, long.class)
                                       .hasArg(1, conscryptClass("NativeSsl"))
                                       .except(nonThrowingMethods)
-                                      .expectSize(60)
+                                      .expectSize(80)
                                       .build();
 
         testMethods(filter, NullPointerException.class);
@@ -147,7 +147,7 @@ public class NativeCryptoArgTest {
                          .hasPrefix("SSL_")
                          .hasArgLength(1)
                          .hasArg(0, long.class)
-                         .expectSize(10)
+                         .expectSize(11)
                          .build();
 
         testMethods(filter, NullPointerException.class);
@@ -205,7 +205,7 @@ public class NativeCryptoArgTest {
                                       .hasArg(0, long.class)
                                       .hasArg(1, conscryptClass("OpenSSLX509Certificate"),
                                               conscryptClass("OpenSSLX509CRL"))
-                                      .expectSize(32)
+                                      .expectSize(34)
                                       .build();
         // TODO(prb): test null second argument
         testMethods(filter, NullPointerException.class);
@@ -216,14 +216,22 @@ public class NativeCryptoArgTest {
         invokeAndExpect(conscryptThrowable("OpenSSLX509CertificateFactory$ParsingException"),
                         "d2i_X509", new byte[] {0, 0, 0, 0, 0, 0, 0, 0, 0});
 
+        expectNPE("d2i_X509_batch", null, new int[] {0, 0}, null);
+        expectNPE("d2i_X509_batch", new byte[0], null, null);
+
         expectNPE("d2i_X509_bio", NULL);
+        expectNPE("X509_parse_from_buffer", NULL);
         expectNPE("PEM_read_bio_X509", NULL);
+        expectNPE("PEM_read_all", null, 1);
         expectNPE("ASN1_seq_pack_X509", (Object) null);
 
         // TODO(prb): Check what this should really throw
         // expectNPE("ASN1_seq_pack_X509", (Object) new long[] { NULL });
 
         expectNPE("ASN1_seq_unpack_X509_bio", NULL);
+        expectNPE("X509_CRL_revocation_index_lookup", null, new byte[0], new int[0]);
+        expectNPE("X509_REVOKED_get_revocationDates", (Object) null);
+        expectNPE("X509_REVOKED_get_revocationDates", (Object) new long[] {NULL});
 
         //
         expectNPE("X509_cmp", NULL, null, NULL, null);
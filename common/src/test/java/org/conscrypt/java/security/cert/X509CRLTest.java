@@ -29,6 +29,7 @@ import org.junit.runner.RunWith;
 import org.junit.runners.JUnit4;
 
 import java.io.ByteArrayInputStream;
+import java.math.BigInteger;
 import java.nio.charset.StandardCharsets;
 import java.security.Provider;
 import java.security.SignatureException;
@@ -148,6 +149,9 @@ public class X509CRLTest {
 
                         assertFalse(crl.isRevoked(ca));
                         assertNull(crl.getRevokedCertificate(ca));
+                        assertEquals(entry, crl.getRevokedCertificate(BigInteger.valueOf(7)));
+                        assertNull(crl.getRevokedCertificate(BigInteger.valueOf(-7)));
+                        assertNull(crl.getRevokedCertificate(BigInteger.valueOf(0x107)));
 
                         assertEquals(Collections.singleton(entry), crl.getRevokedCertificates());
                     }
@@ -83,6 +83,9 @@ int main(int /* argc */, char** /* argv */) {
     CONST(SSL_ERROR_WANT_READ);
     CONST(SSL_ERROR_WANT_WRITE);
     CONST(SSL_ERROR_ZERO_RETURN);
+    CONST(SSL_ERROR_SYSCALL);
+    CONST(SSL_ERROR_WANT_CERTIFICATE_VERIFY);
+    CONST(SSL_ERROR_PENDING_CERTIFICATE);
 
     CONST(TLS1_VERSION);
     CONST(TLS1_1_VERSION);
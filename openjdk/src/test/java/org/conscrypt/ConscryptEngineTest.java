@@ -16,6 +16,7 @@
 
 package org.conscrypt;
 
+import static org.conscrypt.NativeConstants.SSL3_RT_MAX_PLAIN_LENGTH;
 import static org.conscrypt.TestUtils.getConscryptProvider;
 import static org.conscrypt.TestUtils.getJdkProvider;
 import static org.conscrypt.TestUtils.highestCommonProtocol;
@@ -24,9 +25,11 @@ import static org.conscrypt.TestUtils.newTextMessage;
 import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
 import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNotNull;
 import static org.junit.Assert.assertNull;
 import static org.junit.Assert.assertThrows;
 import static org.junit.Assert.assertTrue;
+import static org.junit.Assume.assumeTrue;
 import static org.mockito.ArgumentMatchers.same;
 import static org.mockito.Mockito.when;
 
@@ -253,6 +256,31 @@ public class ConscryptEngineTest {
                                                  ClientAuth.REQUIRED));
     }
 
+    @Test
+    public void asyncCertificateVerificationShouldSucceed() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        Conscrypt.setAsyncCertificateVerification(clientEngine, true);
+        doHandshake(true);
+        assertEquals(HandshakeStatus.NOT_HANDSHAKING, clientEngine.getHandshakeStatus());
+        assertEquals(HandshakeStatus.NOT_HANDSHAKING, serverEngine.getHandshakeStatus());
+    }
+
+    @Test
+    public void asyncCertificateVerificationWithUntrustedServerShouldFail() throws Exception {
+        setupEngines(TestKeyStore.getClientCA2(), TestKeyStore.getServer());
+        Conscrypt.setAsyncCertificateVerification(clientEngine, true);
+        assertThrows(SSLHandshakeException.class, () -> doHandshake(true));
+    }
+
+    @Test
+    public void asyncCertificateSelectionShouldSucceed() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        Conscrypt.setAsyncCertificateSelection(serverEngine, true);
+        doHandshake(true);
+        assertEquals(HandshakeStatus.NOT_HANDSHAKING, clientEngine.getHandshakeStatus());
+        assertEquals(HandshakeStatus.NOT_HANDSHAKING, serverEngine.getHandshakeStatus());
+    }
+
     @Test
     public void exchangeMessages() throws Exception {
         setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
@@ -291,6 +319,270 @@ public class ConscryptEngineTest {
         exchangeMessage(inputBuffer, clientEngine, serverEngine);
     }
 
+    @Test
+    public void exchangeManySmallBuffers() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        doHandshake(true);
+
+        final int numBuffers = 50;
+        final int bufferSize = 500;
+        ByteBuffer[] messages = new ByteBuffer[numBuffers];
+        ByteArrayOutputStream expected = new ByteArrayOutputStream();
+        for (int i = 0; i < numBuffers; i++) {
+            messages[i] = newMessage(bufferSize);
+            expected.write(toArray(messages[i].duplicate()));
+        }
+
+        List<ByteBuffer> encrypted = new ArrayList<ByteBuffer>();
+        while (messages[numBuffers - 1].hasRemaining()) {
+            ByteBuffer encryptedBuffer =
+                    bufferType.newBuffer(clientEngine.getSession().getPacketBufferSize());
+            SSLEngineResult wrapResult = clientEngine.wrap(messages, encryptedBuffer);
+            assertEquals(SSLEngineResult.Status.OK, wrapResult.getStatus());
+            if (encrypted.isEmpty()) {
+                // The small buffers are packed into a single full-size record.
+                assertEquals(SSL3_RT_MAX_PLAIN_LENGTH, wrapResult.bytesConsumed());
+            }
+            encryptedBuffer.flip();
+            encrypted.add(encryptedBuffer);
+        }
+        assertEquals(2, encrypted.size());
+
+        byte[] actualBytes =
+                unwrap(encrypted.toArray(new ByteBuffer[encrypted.size()]), serverEngine);
+        assertArrayEquals(expected.toByteArray(), actualBytes);
+    }
+
+    @Test
+    public void dynamicRecordSizingStartsWithSmallRecords() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        doHandshake(true);
+        Conscrypt.setDynamicRecordSizing(clientEngine, 1024, 4096, 0, 0);
+
+        ByteBuffer message = newMessage(4096 + SSL3_RT_MAX_PLAIN_LENGTH);
+        byte[] messageBytes = toArray(message.duplicate());
+        List<ByteBuffer> encrypted = new ArrayList<ByteBuffer>();
+        while (message.hasRemaining()) {
+            ByteBuffer encryptedBuffer =
+                    bufferType.newBuffer(clientEngine.getSession().getPacketBufferSize());
+            SSLEngineResult wrapResult = clientEngine.wrap(message, encryptedBuffer);
+            assertEquals(Status.OK, wrapResult.getStatus());
+            // Four small records, then full-sized ones.
+            assertEquals(encrypted.size() < 4 ? 1024 : SSL3_RT_MAX_PLAIN_LENGTH,
+                    wrapResult.bytesConsumed());
+            encryptedBuffer.flip();
+            encrypted.add(encryptedBuffer);
+        }
+        assertEquals(5, encrypted.size());
+
+        byte[] actualBytes =
+                unwrap(encrypted.toArray(new ByteBuffer[encrypted.size()]), serverEngine);
+        assertArrayEquals(messageBytes, actualBytes);
+    }
+
+    @Test
+    public void dynamicRecordSizingEndsAfterBoostTimeout() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        doHandshake(true);
+        Conscrypt.setDynamicRecordSizing(clientEngine, 1024, Long.MAX_VALUE, 50, 0);
+
+        ByteBuffer message = newMessage(1024 + SSL3_RT_MAX_PLAIN_LENGTH);
+        byte[] messageBytes = toArray(message.duplicate());
+        List<ByteBuffer> encrypted = new ArrayList<ByteBuffer>();
+        while (message.hasRemaining()) {
+            if (!encrypted.isEmpty()) {
+                Thread.sleep(100);
+            }
+            ByteBuffer encryptedBuffer =
+                    bufferType.newBuffer(clientEngine.getSession().getPacketBufferSize());
+            SSLEngineResult wrapResult = clientEngine.wrap(message, encryptedBuffer);
+            assertEquals(Status.OK, wrapResult.getStatus());
+            // One small record, then full-sized ones once the timeout has passed.
+            assertEquals(encrypted.isEmpty() ? 1024 : SSL3_RT_MAX_PLAIN_LENGTH,
+                    wrapResult.bytesConsumed());
+            encryptedBuffer.flip();
+            encrypted.add(encryptedBuffer);
+        }
+        assertEquals(2, encrypted.size());
+
+        byte[] actualBytes =
+                unwrap(encrypted.toArray(new ByteBuffer[encrypted.size()]), serverEngine);
+        assertArrayEquals(messageBytes, actualBytes);
+    }
+
+    @Test
+    public void shedHandshakeConfigReleasesIdleBuffers() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        Conscrypt.setShedHandshakeConfig(clientEngine, true);
+        doHandshake(true);
+
+        ByteBuffer message = newMessage(MESSAGE_SIZE);
+        exchangeMessage(message, clientEngine, serverEngine);
+        exchangeMessage(newMessage(MESSAGE_SIZE), serverEngine, clientEngine);
+
+        // Both engines are idle, but only the client has released its buffers.
+        assertTrue(Conscrypt.getNativeFootprint(clientEngine) > 0);
+        assertTrue(Conscrypt.getNativeFootprint(clientEngine)
+                < Conscrypt.getNativeFootprint(serverEngine));
+    }
+
+    @Test
+    public void handshakeTimingsAttributeHandshakeTime() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        Conscrypt.setHandshakeTimingEnabled(clientEngine, true);
+        doHandshake(true);
+
+        assertNull(Conscrypt.getHandshakeTimings(serverEngine));
+        Conscrypt.HandshakeTimings timings = Conscrypt.getHandshakeTimings(clientEngine);
+        assertNotNull(timings);
+        assertFalse(timings.isResumed());
+        assertTrue(timings.steps() >= 2);
+        assertTrue(timings.helloOffsetNanos() <= timings.totalNanos());
+        assertTrue(timings.libraryNanos() > 0);
+        assertTrue(timings.certificateVerificationNanos() > 0);
+        assertTrue(timings.libraryNanos() + timings.certificateVerificationNanos()
+                <= timings.totalNanos());
+    }
+
+    @Test
+    public void connectionStatsCountTraffic() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        doHandshake(true);
+        exchangeMessage(newMessage(MESSAGE_SIZE), clientEngine, serverEngine);
+
+        Conscrypt.ConnectionStats client = Conscrypt.getConnectionStats(clientEngine);
+        Conscrypt.ConnectionStats server = Conscrypt.getConnectionStats(serverEngine);
+        assertEquals(MESSAGE_SIZE, client.plaintextBytesWritten());
+        assertEquals(MESSAGE_SIZE, server.plaintextBytesRead());
+        assertTrue(client.recordsSealed() > 0);
+        assertEquals(client.ciphertextBytesWritten(), server.ciphertextBytesRead());
+        assertTrue(client.ciphertextBytesWritten() > MESSAGE_SIZE);
+        assertEquals(0, client.renegotiationCount());
+    }
+
+    @Test
+    public void certificateCompressionShrinksServerFlight() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        doHandshake(true);
+        long uncompressed = Conscrypt.getConnectionStats(serverEngine).ciphertextBytesWritten();
+
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        assumeTrue(Conscrypt.enableCertificateCompression(clientContext));
+        assertTrue(Conscrypt.enableCertificateCompression(serverContext));
+        clientEngine = newEngine(clientContext, true);
+        serverEngine = newEngine(serverContext, false);
+        doHandshake(true);
+        long compressed = Conscrypt.getConnectionStats(serverEngine).ciphertextBytesWritten();
+
+        assertTrue(compressed < uncompressed);
+        exchangeMessage(newMessage(MESSAGE_SIZE), clientEngine, serverEngine);
+    }
+
+    @Test
+    public void sharedCredentialsReportChosenChain() throws Exception {
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        for (int i = 0; i < 2; i++) {
+            clientEngine = newEngine(clientContext, true);
+            serverEngine = newEngine(serverContext, false);
+            doHandshake(true);
+
+            // Whichever of the server's chains was chosen, it is the one the client received.
+            assertArrayEquals(clientEngine.getSession().getPeerCertificates(),
+                    serverEngine.getSession().getLocalCertificates());
+            exchangeMessage(newMessage(MESSAGE_SIZE), clientEngine, serverEngine);
+        }
+    }
+
+    @Test
+    public void certificateVerificationCacheSkipsRepeatedVerification() throws Exception {
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        Conscrypt.setCertificateVerificationCache(serverContext, 16, 60_000);
+        for (int i = 0; i < 2; i++) {
+            // A fresh client context each time, so that the session is not resumed.
+            clientEngine = newEngine(
+                    newContext(getConscryptProvider(), TestKeyStore.getClient()), true);
+            serverEngine = newEngine(serverContext, false);
+            serverEngine.setNeedClientAuth(true);
+            doHandshake(true);
+
+            // A cached verification still leaves the peer's chain on the session.
+            assertNotNull(serverEngine.getSession().getPeerCertificates());
+        }
+
+        Conscrypt.CertificateVerificationCacheStats stats =
+                Conscrypt.getCertificateVerificationCacheStats(serverContext);
+        assertEquals(1, stats.hits());
+        assertEquals(1, stats.misses());
+        assertEquals(1, stats.size());
+        Conscrypt.clearCertificateVerificationCache(serverContext);
+        assertEquals(0, Conscrypt.getCertificateVerificationCacheStats(serverContext).size());
+    }
+
+    @Test
+    public void certificateVerificationCacheIsScopedByHost() throws Exception {
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        Conscrypt.setCertificateVerificationCache(clientContext, 16, 60_000);
+        String[] hosts = {"one.example", "one.example", "two.example"};
+        for (int i = 0; i < hosts.length; i++) {
+            // A new port each time, so that the session is not resumed.
+            clientEngine = clientContext.createSSLEngine(hosts[i], 1000 + i);
+            clientEngine.setEnabledCipherSuites(TestUtils.getCommonCipherSuites());
+            clientEngine.setUseClientMode(true);
+            serverEngine = newEngine(serverContext, false);
+            doHandshake(true);
+        }
+
+        Conscrypt.CertificateVerificationCacheStats stats =
+                Conscrypt.getCertificateVerificationCacheStats(clientContext);
+        assertEquals(1, stats.hits());
+        assertEquals(2, stats.misses());
+    }
+
+    @Test
+    public void nativeMemoryStatsIncludeLiveEngines() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        doHandshake(true);
+
+        Conscrypt.NativeMemoryStats stats = Conscrypt.getNativeMemoryStats();
+        assertTrue(stats.sslCount() >= 2);
+        assertTrue(stats.connectionStateCount() >= 2);
+        assertTrue(stats.engineBioCount() >= 2);
+        assertTrue(stats.totalBytes() >= Conscrypt.getNativeFootprint(clientEngine)
+                        + Conscrypt.getNativeFootprint(serverEngine));
+    }
+
+    @Test
+    public void unwrapIntoSeveralBuffers() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        doHandshake(true);
+
+        ByteBuffer message = newMessage(LARGE_MESSAGE_SIZE);
+        byte[] messageBytes = toArray(message);
+        ByteBuffer encrypted = combine(wrapAll(message, clientEngine));
+
+        ByteBuffer[] dsts = new ByteBuffer[5];
+        for (int i = 0; i < dsts.length; i++) {
+            dsts[i] = bufferType.newBuffer(LARGE_MESSAGE_SIZE / 4);
+        }
+        int produced = 0;
+        while (encrypted.hasRemaining()) {
+            SSLEngineResult result = serverEngine.unwrap(encrypted, dsts);
+            assertEquals(Status.OK, result.getStatus());
+            produced += result.bytesProduced();
+        }
+        assertEquals(LARGE_MESSAGE_SIZE, produced);
+
+        ByteArrayOutputStream actual = new ByteArrayOutputStream();
+        for (ByteBuffer dst : dsts) {
+            dst.flip();
+            actual.write(toArray(dst));
+        }
+        assertArrayEquals(messageBytes, actual.toByteArray());
+    }
+
     @Test
     public void alpnWithProtocolListShouldSucceed() throws Exception {
         setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
@@ -472,8 +764,11 @@ public class ConscryptEngineTest {
     }
 
     private SSLEngine newEngine(Provider provider, TestKeyStore keyStore, boolean client) {
-        SSLContext serverContext = newContext(provider, keyStore);
-        SSLEngine engine = serverContext.createSSLEngine();
+        return newEngine(newContext(provider, keyStore), client);
+    }
+
+    private SSLEngine newEngine(SSLContext context, boolean client) {
+        SSLEngine engine = context.createSSLEngine();
         engine.setEnabledCipherSuites(TestUtils.getCommonCipherSuites());
         engine.setUseClientMode(client);
         if (Conscrypt.isConscrypt(engine)) {
@@ -496,6 +791,11 @@ public class ConscryptEngineTest {
         assertArrayEquals(messageBytes, actualBytes);
     }
 
+    private ByteBuffer[] wrapAll(ByteBuffer input, SSLEngine engine) throws SSLException {
+        List<ByteBuffer> wrapped = wrap(input, engine);
+        return wrapped.toArray(new ByteBuffer[wrapped.size()]);
+    }
+
     private List<ByteBuffer> wrap(ByteBuffer input, SSLEngine engine) throws SSLException {
         // Encrypt the input message.
         List<ByteBuffer> wrapped = new ArrayList<ByteBuffer>();
@@ -40,6 +40,10 @@ import org.junit.runners.Parameterized.Parameters;
 import org.mockito.ArgumentMatchers;
 import org.mockito.Mockito;
 
+import java.io.DataInputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
 import java.io.IOException;
 import java.lang.reflect.Field;
 import java.net.InetAddress;
@@ -53,6 +57,7 @@ import java.security.KeyStore;
 import java.security.PrivateKey;
 import java.security.cert.CertificateException;
 import java.security.cert.X509Certificate;
+import java.util.Arrays;
 import java.util.Random;
 import java.util.concurrent.Callable;
 import java.util.concurrent.ExecutionException;
@@ -288,6 +293,7 @@ public class ConscryptSocketTest {
         KeyManager[] keyManagers;
         TrustManager[] trustManagers;
         String[] alpnProtocols;
+        boolean kernelTls;
 
         abstract AbstractConscryptSocket createSocket(ServerSocket listener) throws IOException;
 
@@ -339,6 +345,7 @@ public class ConscryptSocketTest {
             if (alpnProtocols != null) {
                 Conscrypt.setApplicationProtocols(socket, alpnProtocols);
             }
+            Conscrypt.setKernelTlsEnabled(socket, kernelTls);
             return socket;
         }
     }
@@ -371,6 +378,7 @@ public class ConscryptSocketTest {
             if (alpnProtocolSelector != null) {
                 Conscrypt.setApplicationProtocolSelector(socket, alpnProtocolSelector);
             }
+            Conscrypt.setKernelTlsEnabled(socket, kernelTls);
             return socket;
         }
     }
@@ -766,6 +774,96 @@ public class ConscryptSocketTest {
         }
     }
 
+    @Test
+    public void dataFlowsWithKernelTls() throws Exception {
+        final TestConnection connection =
+                new TestConnection(new X509Certificate[] {cert, ca}, certKey);
+        connection.clientHooks.kernelTls = true;
+        connection.serverHooks.kernelTls = true;
+        connection.doHandshakeSuccess();
+        // Whether the kernel accepts the offload depends on the platform.
+        assumeTrue(Conscrypt.isKernelTlsActive(connection.client));
+        assumeTrue(Conscrypt.isKernelTlsActive(connection.server));
+        int maxDataSize = connection.client.getSession().getApplicationBufferSize();
+
+        sendData(connection.client, connection.server, randomBuffer(maxDataSize));
+        sendData(connection.server, connection.client, randomBuffer(maxDataSize));
+        for (int i = 0; i < 20; i++) {
+            sendData(connection.client, connection.server, randomSizeBuffer(maxDataSize));
+            sendData(connection.server, connection.client, randomSizeBuffer(maxDataSize));
+        }
+
+        connection.client.close();
+        assertEquals(-1, connection.server.getInputStream().read());
+    }
+
+    @Test
+    public void dataFlowsWithKernelTlsOnOneSide() throws Exception {
+        final TestConnection connection =
+                new TestConnection(new X509Certificate[] {cert, ca}, certKey);
+        connection.clientHooks.kernelTls = true;
+        connection.doHandshakeSuccess();
+        assumeTrue(Conscrypt.isKernelTlsActive(connection.client));
+        // The kernel's records must interoperate with a peer encrypting in user space.
+        assertFalse(Conscrypt.isKernelTlsActive(connection.server));
+        int maxDataSize = connection.client.getSession().getApplicationBufferSize();
+
+        for (int i = 0; i < 20; i++) {
+            sendData(connection.client, connection.server, randomSizeBuffer(maxDataSize));
+            sendData(connection.server, connection.client, randomSizeBuffer(maxDataSize));
+        }
+
+        connection.server.close();
+        assertEquals(-1, connection.client.getInputStream().read());
+    }
+
+    @Test
+    public void sendFile() throws Exception {
+        final TestConnection connection =
+                new TestConnection(new X509Certificate[] {cert, ca}, certKey);
+        connection.clientHooks.kernelTls = true;
+        connection.serverHooks.kernelTls = true;
+        connection.doHandshakeSuccess();
+        // Otherwise this would only exercise the user-space fallback.
+        assumeTrue(Conscrypt.isKernelTlsActive(connection.client));
+
+        checkSendFile(connection);
+    }
+
+    @Test
+    public void sendFileWithoutKernelTls() throws Exception {
+        final TestConnection connection =
+                new TestConnection(new X509Certificate[] {cert, ca}, certKey);
+        connection.doHandshakeSuccess();
+        assertFalse(Conscrypt.isKernelTlsActive(connection.client));
+
+        checkSendFile(connection);
+    }
+
+    private void checkSendFile(final TestConnection connection) throws Exception {
+        final byte[] contents = randomBuffer(100000);
+        File file = File.createTempFile("conscrypt", ".tmp");
+        file.deleteOnExit();
+        try (FileOutputStream out = new FileOutputStream(file)) {
+            out.write(contents);
+        }
+
+        try (final FileInputStream in = new FileInputStream(file)) {
+            // Ask for more than the file holds to check the short count at end of file.
+            Future<Long> sent = executor.submit(
+                    () -> Conscrypt.sendFile(connection.client, in.getFD(), 1000, 200000));
+            byte[] received = new byte[contents.length - 1000];
+            new DataInputStream(connection.server.getInputStream()).readFully(received);
+
+            assertEquals(received.length, (long) sent.get(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+            assertArrayEquals(Arrays.copyOfRange(contents, 1000, contents.length), received);
+            assertEquals(0, in.getChannel().position());
+        }
+
+        // The connection is still usable for ordinary writes afterwards.
+        sendData(connection.client, connection.server, randomBuffer(100));
+    }
+
     private void sendData(SSLSocket source, final SSLSocket destination, byte[] data)
             throws Exception {
         final byte[] received = new byte[data.length];
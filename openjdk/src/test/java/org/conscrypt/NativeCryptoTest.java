@@ -437,55 +437,44 @@ public class NativeCryptoTest {
     }
 
     @Test
-    public void setLocalCertsAndPrivateKey_withNullSSLShouldThrow() throws Exception {
+    public void SSL_add1_credential_withNullSSLShouldThrow() throws Exception {
+        NativeRef.SSL_CREDENTIAL credential =
+                newCredential(ENCODED_SERVER_CERTIFICATES, SERVER_PRIVATE_KEY);
         assertThrows(NullPointerException.class,
-                     ()
-                             -> NativeCrypto.setLocalCertsAndPrivateKey(
-                                     NULL, null, ENCODED_SERVER_CERTIFICATES,
-                                     SERVER_PRIVATE_KEY.getNativeRef()));
+                     () -> NativeCrypto.SSL_add1_credential(NULL, null, credential));
     }
 
     @Test
-    public void setLocalCertsAndPrivateKey_withNullCertificatesShouldThrow() throws Exception {
-        long c = NativeCrypto.SSL_CTX_new();
-        long s = NativeCrypto.SSL_new(c, null);
-        assertThrows(NullPointerException.class, () -> {
-            try {
-                NativeCrypto.setLocalCertsAndPrivateKey(s, null, null,
-                                                        SERVER_PRIVATE_KEY.getNativeRef());
-            } finally {
-                NativeCrypto.SSL_free(s, null);
-                NativeCrypto.SSL_CTX_free(c, null);
-            }
-        });
+    public void SSL_CREDENTIAL_new_x509_withNullCertificatesShouldThrow() throws Exception {
+        assertThrows(NullPointerException.class,
+                     ()
+                             -> NativeCrypto.SSL_CREDENTIAL_new_x509(
+                                     null, SERVER_PRIVATE_KEY.getNativeRef()));
     }
 
     @Test
-    public void setLocalCertsAndPrivateKey_withNullKeyShouldThrow() throws Exception {
-        long c = NativeCrypto.SSL_CTX_new();
-        long s = NativeCrypto.SSL_new(c, null);
-        assertThrows(NullPointerException.class, () -> {
-            try {
-                NativeCrypto.setLocalCertsAndPrivateKey(s, null, ENCODED_SERVER_CERTIFICATES, null);
-            } finally {
-                NativeCrypto.SSL_free(s, null);
-                NativeCrypto.SSL_CTX_free(c, null);
-            }
-        });
+    public void SSL_CREDENTIAL_new_x509_withNullKeyShouldThrow() throws Exception {
+        assertThrows(NullPointerException.class,
+                     () -> NativeCrypto.SSL_CREDENTIAL_new_x509(ENCODED_SERVER_CERTIFICATES, null));
     }
 
     @Test
-    public void setLocalCertsAndPrivateKey() throws Exception {
+    public void SSL_add1_credential() throws Exception {
         long c = NativeCrypto.SSL_CTX_new();
         long s = NativeCrypto.SSL_new(c, null);
 
-        NativeCrypto.setLocalCertsAndPrivateKey(s, null, ENCODED_SERVER_CERTIFICATES,
-                                                SERVER_PRIVATE_KEY.getNativeRef());
+        NativeCrypto.SSL_add1_credential(
+                s, null, newCredential(ENCODED_SERVER_CERTIFICATES, SERVER_PRIVATE_KEY));
 
         NativeCrypto.SSL_free(s, null);
         NativeCrypto.SSL_CTX_free(c, null);
     }
 
+    private static NativeRef.SSL_CREDENTIAL newCredential(byte[][] certificates, OpenSSLKey key) {
+        return new NativeRef.SSL_CREDENTIAL(
+                NativeCrypto.SSL_CREDENTIAL_new_x509(certificates, key.getNativeRef()));
+    }
+
     @Test
     public void SSL_set1_tls_channel_id_withNullChannelShouldThrow() throws Exception {
         assertThrows(NullPointerException.class,
@@ -1101,15 +1090,17 @@ public class NativeCryptoTest {
         private boolean verifyCertificateChainCalled;
 
         @Override
-        public void verifyCertificateChain(byte[][] certs, String authMethod)
+        public void verifyCertificateChain(long[] certificateRefs, String authMethod)
                 throws CertificateException {
-            certificateChainRefs = new long[certs.length];
-            for (int i = 0; i < certs.length; ++i) {
-                byte[] cert = certs[i];
+            certificateChainRefs = new long[certificateRefs.length];
+            for (int i = 0; i < certificateRefs.length; ++i) {
                 try {
-                    certificateChainRefs[i] = NativeCrypto.d2i_X509(cert);
+                    certificateChainRefs[i] =
+                            NativeCrypto.X509_parse_from_buffer(certificateRefs[i]);
                 } catch (ParsingException e) {
                     throw new RuntimeException(e);
+                } finally {
+                    NativeCrypto.CRYPTO_BUFFER_free(certificateRefs[i]);
                 }
             }
             this.authMethod = authMethod;
@@ -1301,8 +1292,7 @@ public class NativeCryptoTest {
         public long beforeHandshake(long c) throws SSLException {
             long s = super.beforeHandshake(c);
             if (privateKey != null && certificates != null) {
-                NativeCrypto.setLocalCertsAndPrivateKey(s, null, certificates,
-                                                        privateKey.getNativeRef());
+                NativeCrypto.SSL_add1_credential(s, null, newCredential(certificates, privateKey));
             }
             if (channelIdEnabled) {
                 NativeCrypto.SSL_enable_tls_channel_id(s, null);
@@ -1579,8 +1569,8 @@ public class NativeCryptoTest {
             public void clientCertificateRequested(long s)
                     throws CertificateEncodingException, SSLException {
                 super.clientCertificateRequested(s);
-                NativeCrypto.setLocalCertsAndPrivateKey(s, null, ENCODED_CLIENT_CERTIFICATES,
-                                                        CLIENT_PRIVATE_KEY.getNativeRef());
+                NativeCrypto.SSL_add1_credential(
+                        s, null, newCredential(ENCODED_CLIENT_CERTIFICATES, CLIENT_PRIVATE_KEY));
             }
         };
         Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, ENCODED_SERVER_CERTIFICATES) {
@@ -2658,6 +2648,75 @@ public class NativeCryptoTest {
         server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
     }
 
+    @Test
+    public void test_SSL_get0_peer_certificate_refs() throws Exception {
+        // This test only works on older versions of Java, see b/502061834.
+        assumeFalse(TestUtils.isJavaVersion(17));
+
+        final ServerSocket listener = newServerSocket();
+
+        Hooks cHooks = new Hooks() {
+            @Override
+            public void afterHandshake(long session, long s, long c, Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback) throws Exception {
+                X509Certificate[] certs = PeerCertificateChain.decode(
+                        NativeCrypto.SSL_get0_peer_certificate_refs(s, null));
+                byte[][] cc = new byte[certs.length][];
+                for (int i = 0; i < certs.length; i++) {
+                    cc[i] = certs[i].getEncoded();
+                }
+                assertEqualByteArrays(ENCODED_SERVER_CERTIFICATES, cc);
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, ENCODED_SERVER_CERTIFICATES);
+        Future<TestSSLHandshakeCallbacks> client = handshake(listener, 0, true, cHooks, null, null);
+        Future<TestSSLHandshakeCallbacks> server =
+                handshake(listener, 0, false, sHooks, null, null);
+        client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+    }
+
+    @Test
+    public void test_SSL_peer_certificates_are_pooled() throws Exception {
+        // This test only works on older versions of Java, see b/502061834.
+        assumeFalse(TestUtils.isJavaVersion(17));
+
+        final List<long[]> chains = Collections.synchronizedList(new ArrayList<long[]>());
+        try {
+            for (int i = 0; i < 2; i++) {
+                final ServerSocket listener = newServerSocket();
+                Hooks cHooks = new Hooks() {
+                    @Override
+                    public void afterHandshake(long session, long s, long c, Socket sock,
+                                               FileDescriptor fd, SSLHandshakeCallbacks callback)
+                            throws Exception {
+                        // Held until both connections are done, so that the pool keeps them.
+                        chains.add(NativeCrypto.SSL_get0_peer_certificate_refs(s, null));
+                        super.afterHandshake(session, s, c, sock, fd, callback);
+                    }
+                };
+                Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, ENCODED_SERVER_CERTIFICATES);
+                Future<TestSSLHandshakeCallbacks> client =
+                        handshake(listener, 0, true, cHooks, null, null);
+                Future<TestSSLHandshakeCallbacks> server =
+                        handshake(listener, 0, false, sHooks, null, null);
+                client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+                server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+            }
+
+            // Both connections received the same chain, so they share one copy of each buffer.
+            assertEquals(2, chains.size());
+            assertArrayEquals(chains.get(0), chains.get(1));
+        } finally {
+            for (long[] refs : chains) {
+                for (long ref : refs) {
+                    NativeCrypto.CRYPTO_BUFFER_free(ref);
+                }
+            }
+        }
+    }
+
     @Test
     public void test_SSL_cipher_names() throws Exception {
         // This test only works on older versions of Java, see b/502061834.
@@ -3931,6 +3990,34 @@ public class NativeCryptoTest {
         }
     }
 
+    @Test
+    public void test_BIO_streams_largerThanBuffer() throws Exception {
+        byte[] data = new byte[20000];
+        for (int i = 0; i < data.length; i++) {
+            data[i] = (byte) i;
+        }
+
+        OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(new ByteArrayInputStream(data), true);
+        try {
+            byte[] buffer = new byte[data.length + 1];
+            assertEquals(data.length, NativeCrypto.BIO_read(bis.getBioContext(), buffer));
+            assertArrayEquals(data, Arrays.copyOf(buffer, data.length));
+        } finally {
+            bis.release();
+        }
+
+        ByteArrayOutputStream os = new ByteArrayOutputStream();
+        long ctx = NativeCrypto.create_BIO_OutputStream(os);
+        try {
+            NativeCrypto.BIO_write(ctx, data, 0, 100);
+            assertEquals(100, os.size());
+            NativeCrypto.BIO_write(ctx, data, 100, data.length - 100);
+            assertArrayEquals(data, os.toByteArray());
+        } finally {
+            NativeCrypto.BIO_free_all(ctx);
+        }
+    }
+
     @Test
     public void test_get_ocsp_single_extension() throws Exception {
         final String OCSP_SCT_LIST_OID = "1.3.6.1.4.1.11129.2.4.5";
@@ -4059,6 +4146,72 @@ public class NativeCryptoTest {
         assertThrows(ParsingException.class, () -> NativeCrypto.d2i_X509(new byte[1]));
     }
 
+    @Test
+    public void d2i_X509_batch() throws Exception {
+        byte[] cert = ENCODED_SERVER_CERTIFICATES[0];
+        byte[] data = new byte[2 * cert.length + 1];
+        System.arraycopy(cert, 0, data, 0, cert.length);
+        System.arraycopy(cert, 0, data, cert.length + 1, cert.length);
+        int[] spans = {0, cert.length, cert.length, 1, cert.length + 1, cert.length};
+        int[] errors = new int[3];
+
+        long[] refs = NativeCrypto.d2i_X509_batch(data, spans, errors);
+        try {
+            assertEquals(3, refs.length);
+            assertEquals(0, NativeCrypto.X509_cmp(SERVER_CERTIFICATE_REFS[0], null, refs[0], null));
+            assertEquals(0, errors[0]);
+            assertEquals(NULL, refs[1]);
+            assertNotEquals(0, errors[1]);
+            assertEquals(0, NativeCrypto.X509_cmp(SERVER_CERTIFICATE_REFS[0], null, refs[2], null));
+            assertEquals(0, errors[2]);
+        } finally {
+            for (long ref : refs) {
+                if (ref != NULL) {
+                    NativeCrypto.X509_free(ref, null);
+                }
+            }
+        }
+
+        assertThrows(ArrayIndexOutOfBoundsException.class,
+                     () -> NativeCrypto.d2i_X509_batch(data, new int[] {1, data.length}, null));
+    }
+
+    @Test
+    public void X509_CRL_revocation_index() throws Exception {
+        // The CRL lists serial number 7 only.
+        OpenSSLX509CRL crl = OpenSSLX509CRL.fromX509PemInputStream(openTestFile("crl.pem"));
+        BigInteger[] serials = {BigInteger.valueOf(7), BigInteger.valueOf(-7), BigInteger.ZERO,
+                                BigInteger.valueOf(0x107), BigInteger.valueOf(7).shiftLeft(64)};
+        assertArrayEquals(new boolean[] {true, false, false, false, false},
+                          Conscrypt.areRevoked(crl, serials));
+
+        assertEquals(0, Conscrypt.areRevoked(crl, new BigInteger[0]).length);
+
+        // Single lookups consult the index before the CRL itself.
+        assertNotNull(crl.getRevokedCertificate(BigInteger.valueOf(7)));
+        assertNull(crl.getRevokedCertificate(BigInteger.valueOf(0x107)));
+        // cert.pem is serial number 7 from the CRL's issuer, ca-cert.pem is not listed.
+        OpenSSLX509Certificate revoked =
+                OpenSSLX509Certificate.fromX509PemInputStream(openTestFile("cert.pem"));
+        OpenSSLX509Certificate notRevoked =
+                OpenSSLX509Certificate.fromX509PemInputStream(openTestFile("ca-cert.pem"));
+        assertTrue(crl.isRevoked(revoked));
+        assertNotNull(crl.getRevokedCertificate(revoked));
+        assertFalse(crl.isRevoked(notRevoked));
+        assertNull(crl.getRevokedCertificate(notRevoked));
+    }
+
+    @Test
+    public void X509_REVOKED_get_revocationDates() throws Exception {
+        OpenSSLX509CRL crl = OpenSSLX509CRL.fromX509PemInputStream(openTestFile("crl.pem"));
+        // 2019-08-07T10:27:10Z and 2019-09-06T10:27:10Z
+        assertEquals(1565173630000L, crl.getThisUpdate().getTime());
+        assertEquals(1567765630000L, crl.getNextUpdate().getTime());
+        // 2019-08-07T10:26:54Z
+        assertEquals(1565173614000L,
+                     crl.getRevokedCertificates().iterator().next().getRevocationDate().getTime());
+    }
+
     private static void assertContains(String actualValue, String expectedSubstring) {
         if (actualValue == null) {
             return;
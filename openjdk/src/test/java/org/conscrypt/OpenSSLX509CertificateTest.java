@@ -17,6 +17,7 @@
 package org.conscrypt;
 
 import static org.conscrypt.TestUtils.openTestFile;
+import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
 import static org.junit.Assert.assertFalse;
 import static org.junit.Assert.assertNotNull;
@@ -39,7 +40,10 @@ import java.lang.reflect.Field;
 import java.lang.reflect.InvocationTargetException;
 import java.lang.reflect.Method;
 import java.lang.reflect.Modifier;
+import java.math.BigInteger;
+import java.security.cert.Certificate;
 import java.util.Arrays;
+import java.util.Collection;
 
 @RunWith(JUnit4.class)
 public class OpenSSLX509CertificateTest {
@@ -127,6 +131,64 @@ public class OpenSSLX509CertificateTest {
         return OpenSSLX509Certificate.fromX509PemInputStream(openTestFile(name));
     }
 
+    @Test
+    public void test_fieldsMatchNativeGetters() throws Exception {
+        for (String name : new String[] {"cert.pem", "cert-ct-poisoned.pem"}) {
+            OpenSSLX509Certificate cert = loadTestCertificate(name);
+            long ctx = cert.getContext();
+
+            assertArrayEquals(NativeCrypto.i2d_X509(ctx, cert), cert.getEncoded());
+            assertArrayEquals(NativeCrypto.get_X509_tbs_cert(ctx, cert),
+                              cert.getTBSCertificate());
+            assertArrayEquals(NativeCrypto.get_X509_signature(ctx, cert), cert.getSignature());
+            assertArrayEquals(NativeCrypto.X509_get_issuer_name(ctx, cert),
+                              cert.getIssuerX500Principal().getEncoded());
+            assertArrayEquals(NativeCrypto.X509_get_subject_name(ctx, cert),
+                              cert.getSubjectX500Principal().getEncoded());
+            assertEquals(new BigInteger(NativeCrypto.X509_get_serialNumber(ctx, cert)),
+                         cert.getSerialNumber());
+            assertEquals(NativeCrypto.X509_get_version(ctx, cert) + 1, cert.getVersion());
+            assertEquals(NativeCrypto.get_X509_sig_alg_oid(ctx, cert), cert.getSigAlgOID());
+        }
+    }
+
+    @Test
+    public void test_PEM_read_all() throws Exception {
+        ByteArrayOutputStream pem = new ByteArrayOutputStream();
+        for (String name : new String[] {"cert-key.pem", "cert.pem", "ct-server-key-public.pem",
+                                         "blocklist_test_chain.pem"}) {
+            pem.write(TestUtils.readTestFile(name));
+        }
+
+        long[] items = NativeCrypto.PEM_read_all(pem.toByteArray(), NativeCrypto.PEM_X509);
+        assertEquals(6, items.length);
+        for (int i = 0; i < items.length; i += 2) {
+            assertEquals(NativeCrypto.PEM_X509, items[i]);
+            NativeCrypto.X509_free(items[i + 1], null);
+        }
+
+        int keys = NativeCrypto.PEM_PRIVATE_KEY | NativeCrypto.PEM_PUBLIC_KEY;
+        items = NativeCrypto.PEM_read_all(pem.toByteArray(), keys);
+        assertEquals(4, items.length);
+        assertEquals(NativeCrypto.PEM_PRIVATE_KEY, items[0]);
+        assertEquals(NativeCrypto.PEM_PUBLIC_KEY, items[2]);
+        NativeCrypto.EVP_PKEY_free(items[1]);
+        NativeCrypto.EVP_PKEY_free(items[3]);
+    }
+
+    @Test
+    public void test_generateCertificatesFromPemBundle() throws Exception {
+        ByteArrayOutputStream pem = new ByteArrayOutputStream();
+        pem.write(TestUtils.readTestFile("blocklist_test_chain.pem"));
+        pem.write(TestUtils.readTestFile("cert.pem"));
+
+        Collection<? extends Certificate> certs =
+                new OpenSSLX509CertificateFactory().engineGenerateCertificates(
+                        new ByteArrayInputStream(pem.toByteArray()));
+        assertEquals(3, certs.size());
+        assertEquals(loadTestCertificate("cert.pem"), certs.toArray()[2]);
+    }
+
     @Test
     public void test_deletingCTPoisonExtension() throws Exception {
         /* certPoisoned has an extra poison extension.